@@ -1,15 +1,57 @@
 #include "audio-io.h"
+#include "telemetry.h"
 #include <vorbis/vorbisfile.h>
 #include <string.h>
 #include <glib.h>
 #include <math.h>
+#include <errno.h>
+
+// How long a read from a buffer that is still being encoded waits for the next page
+#define VC_GROWING_READ_TIMEOUT (20 * G_TIME_SPAN_MILLISECOND)
+#define VC_GROWING_OPEN_TIMEOUT (500 * G_TIME_SPAN_MILLISECOND)   // the headers are in before the preview opens
+
+// The latency budget is split between the device buffer and the ring buffer in front of it, the
+// ring keeps at least this share so the decoder always has room to stay ahead
+#define VC_RING_LATENCY_SHARE   0.25
+
+// The device session (backend connection, output stream and worker threads) is opened 
+// lazily on first play and kept alive across files, only the stream is rebuilt when
+// the sample rate, channel count or latency change.
+static OggVorbis_File           vf;
+static GThread                  *audioIoThread              = NULL;
+static GThread                  *decoderThread              = NULL;
+static gboolean                 loaded                      = false;
+static gboolean                 sessionStarted              = false;
+static int                      bitstream                   = 0;
+static gint                     events                      = 0;
+static double                   requestedLatency            = VC_AUDIO_IO_DEFAULT_LATENCY;   // under sessionLock
+static double                   achievedLatency             = 0.0;                           // under sessionLock
+static int                      rbTargetBytes               = 0;
+static int                      streamRate                  = 0;
+static int                      streamChannels              = 0;
+static double                   streamLatency               = 0.0;
+static bool                     paused                      = true;
+static GMutex                   sessionLock;
+static VcSeekIndex              *seekIndex                  = NULL;
+static guint                    loadGeneration              = 0;    // bumped on every unload, stale index builds are dropped
+
+typedef struct
+{
+    gchar           *pPath;
+    guint           generation;
+
+} VcIndexBuild;
+
+typedef struct
+{
+    VcOggBuffer     *buffer;
+    size_t          position;
+    gint64          timeout;    // > 0 makes reads wait for the encoder, only while opening
+    bool            bGrowing;   // the encoder is still appending to the buffer
+
+} VcMemorySource;
 
-static OggVorbis_File   vf;
-static GThread          *audioIoThread              = NULL;
-static GThread          *decoderThread              = NULL;
-static gboolean         initialized                 = false;
-static int              bitstream                   = 0;
-static gint             events                      = 0;
+static VcMemorySource           memorySource                = { 0 };
 
 typedef enum
 {
@@ -21,50 +63,164 @@ typedef enum
 
 } VcAudioIoEvents;
 
-static struct SoundIoRingBuffer *rb = NULL;
+static struct SoundIo           *soundio    = NULL;
+static struct SoundIoDevice     *device     = NULL;
+static struct SoundIoOutStream  *outstream  = NULL;
+static struct SoundIoRingBuffer *rb         = NULL;
+static VcPlaybackTelemetry      telemetry;
+
+static size_t VcMemoryRead(void *ptr, size_t size, size_t nmemb, void *datasource)
+{
+    VcMemorySource *source = (VcMemorySource *)datasource;
+    size_t nBytes = source->timeout > 0 
+        ? VcOggBufferReadWait(source->buffer, source->position, ptr, size * nmemb, source->timeout)
+        : VcOggBufferRead(source->buffer, source->position, ptr, size * nmemb);
+
+    // vorbisfile treats a short read with errno set as a read error
+    errno = 0;
+    source->position += nBytes;
+    return nBytes / size;
+}
+
+static int VcMemorySeek(void *datasource, ogg_int64_t offset, int whence)
+{
+    VcMemorySource *source = (VcMemorySource *)datasource;
+    ogg_int64_t size = VcOggBufferGetSize(source->buffer);
+    ogg_int64_t position;
+    switch (whence)
+    {
+        case SEEK_SET: position = offset; break;
+        case SEEK_CUR: position = source->position + offset; break;
+        case SEEK_END: position = size + offset; break;
+        default: return -1;
+    }
+
+    if (position < 0 || position > size)
+    {
+        return -1;
+    }
+
+    source->position = position;
+    return 0;
+}
+
+static long VcMemoryTell(void *datasource)
+{
+    return ((VcMemorySource *)datasource)->position;
+}
+
+static int VcMemoryClose(void *datasource)
+{
+    VcMemorySource *source = (VcMemorySource *)datasource;
+    VcOggBufferUnref(source->buffer);
+    source->buffer = NULL;
+    source->position = 0;
+    source->timeout = 0;
+    source->bGrowing = false;
+    return 0;
+}
+
+static const ov_callbacks vcMemoryCallbacks = 
+{
+    .read_func  = VcMemoryRead,
+    .seek_func  = VcMemorySeek,
+    .close_func = VcMemoryClose,
+    .tell_func  = VcMemoryTell,
+};
+
+// A buffer that is still growing can't be seeked or measured, vorbisfile streams it instead
+static const ov_callbacks vcGrowingCallbacks = 
+{
+    .read_func  = VcMemoryRead,
+    .seek_func  = NULL,
+    .close_func = VcMemoryClose,
+    .tell_func  = NULL,
+};
+
+static bool VcAudioIoIsGrowing()
+{
+    return memorySource.buffer != NULL && memorySource.bGrowing && !VcOggBufferIsFinished(memorySource.buffer);
+}
 
 gpointer VcDecodeCallback(gpointer data)
 {
     char buffer[4092];
     char *writePtr;
-    struct SoundIoOutStream *outstream = (struct SoundIoOutStream *)data; 
     while (!(g_atomic_int_get(&events) & VC_AUDIO_IO_STOP))
     {
+        g_mutex_lock(&sessionLock);
+        if (!loaded || outstream == NULL)
+        {
+            g_mutex_unlock(&sessionLock);
+            g_usleep(1000);
+            continue;
+        }
+
         if ((g_atomic_int_get(&events) & VC_AUDIO_IO_RESET))
         {
-            writePtr = soundio_ring_buffer_write_ptr(rb);
-            int bytesToSet = soundio_ring_buffer_free_count(rb);
-            memset(writePtr, 0, bytesToSet);
             soundio_outstream_pause(outstream, true);
+            paused = true;
             g_atomic_int_set(&events, (VC_AUDIO_IO_PAUSE));
-            ov_time_seek(&vf, 0);
+            if (ov_seekable(&vf))
+            {
+                ov_time_seek(&vf, 0);
+            }
+
+            else if (memorySource.buffer != NULL)
+            {
+                // Streams can't be rewound, start decoding the buffer over instead
+                VcOggBuffer *buffer = VcOggBufferRef(memorySource.buffer);
+                bool growing = memorySource.bGrowing;
+                ov_clear(&vf);
+                memorySource.buffer = buffer;
+                memorySource.bGrowing = growing;
+                if (ov_open_callbacks(&memorySource, &vf, NULL, 0, vcGrowingCallbacks) < 0)
+                {
+                    VcMemoryClose(&memorySource);
+                    loaded = false;
+                }
+            }
             soundio_ring_buffer_clear(rb);
             soundio_outstream_clear_buffer(outstream);
         }
         
-        int bytesAvailable = soundio_ring_buffer_free_count(rb);
+        // Only keep the requested latency worth of audio queued, the ring buffer itself
+        // is rounded up to the page size and may hold a lot more than that.
+        int bytesAvailable = rbTargetBytes - soundio_ring_buffer_fill_count(rb);
+        if (bytesAvailable <= 0 || (g_atomic_int_get(&events) & VC_AUDIO_IO_EOS))
+        {
+            g_mutex_unlock(&sessionLock);
+            g_usleep(500);
+            continue;
+        }
+
         int length = 4092 < bytesAvailable ? 4092 : bytesAvailable;
+        gint64 decodeStart = g_get_monotonic_time();
         long nBytes = ov_read(&vf, buffer, length, 0, 2, 1, &bitstream);
-        if (nBytes == 0)
+        VcTelemetryRecord(&telemetry.decodeTime, (gint)(g_get_monotonic_time() - decodeStart));
+        if (nBytes == 0 && VcAudioIoIsGrowing())
+        {
+            // Caught up with the encoder. Reads don't wait under the lock, the main thread would
+            // stall on it, so the wait for more pages happens here after unlocking.
+            VcOggBuffer *growing = VcOggBufferRef(memorySource.buffer);
+            size_t position = memorySource.position;
+            g_mutex_unlock(&sessionLock);
+            VcOggBufferWait(growing, position, VC_GROWING_READ_TIMEOUT);
+            VcOggBufferUnref(growing);
+            continue;
+        }
+        else if (nBytes == 0)
         {
             g_atomic_int_or(&events, VC_AUDIO_IO_EOS);
         }
         else if (nBytes > 0)
         {
             writePtr = soundio_ring_buffer_write_ptr(rb);
-            if (writePtr == NULL)
-            {
-                return NULL;
-            }
-            
             memcpy(writePtr, buffer, nBytes);
-            if (nBytes < bytesAvailable)
-            {
-                memset(writePtr + nBytes, 0, bytesAvailable - nBytes);
-            }
-
             soundio_ring_buffer_advance_write_ptr(rb, nBytes);
         }
+
+        g_mutex_unlock(&sessionLock);
     }
 
     return NULL;
@@ -81,8 +237,11 @@ static void VcAudioIoWriteCallback
     struct SoundIoChannelArea *areas;
     int framesLeft = frameCountMax;
     int error;
+    gint64 callbackStart = g_get_monotonic_time();
+
+    VcTelemetryRecord(&telemetry.bufferFill, soundio_ring_buffer_fill_count(rb) / outstream->bytes_per_frame);
 
-    while(framesLeft > 0 && !((g_atomic_int_get(&events) & VC_AUDIO_IO_EOS))) {
+    while(framesLeft > 0) {
 
         int frameCount = framesLeft;
 
@@ -98,29 +257,31 @@ static void VcAudioIoWriteCallback
         }
 
         int available = soundio_ring_buffer_fill_count(rb);
-        int requested = frameCount * layout->channel_count * 2;
-        char *readPtr = soundio_ring_buffer_read_ptr(rb);
-        
-        int16_t *pcm = (int16_t *)readPtr;
+        int requested = frameCount * outstream->bytes_per_frame;
+        int bytesToRead = available < requested ? available : requested;
+        int framesToCopy = bytesToRead / outstream->bytes_per_frame;
+        int16_t *pcm = (int16_t *)soundio_ring_buffer_read_ptr(rb);
 
-        for (size_t i = 0; i < available / 2; i++)
+        for (int frame = 0; frame < framesToCopy; frame++)
         {
-            int ch = i % layout->channel_count;
-            int16_t *ptr = (int16_t *)(areas[ch].ptr + i / layout->channel_count * areas[ch].step);
-            *ptr = pcm[i];
+            for (int ch = 0; ch < layout->channel_count; ch++)
+            {
+                int16_t *ptr = (int16_t *)(areas[ch].ptr + frame * areas[ch].step);
+                *ptr = pcm[frame * layout->channel_count + ch];
+            }
         }
 
-        if (available < requested)
+        // Pad with silence if the decoder couldn't keep up
+        for (int frame = framesToCopy; frame < frameCount; frame++)
         {
-            for (size_t ch = 0; ch < layout->channel_count; ch++)
+            for (int ch = 0; ch < layout->channel_count; ch++)
             {
-                int16_t *ptr = (int16_t *)(areas[ch].ptr + available / 2 * areas[ch].step);
-                memset(ptr, 0, (requested - available) / 2);
+                int16_t *ptr = (int16_t *)(areas[ch].ptr + frame * areas[ch].step);
+                *ptr = 0;
             }
-        }        
+        }
 
-        int bytesToWrite = available < requested ? available : requested;
-        soundio_ring_buffer_advance_read_ptr(rb, bytesToWrite);
+        soundio_ring_buffer_advance_read_ptr(rb, framesToCopy * outstream->bytes_per_frame);
         
         if ((error = soundio_outstream_end_write(outstream))) 
         {
@@ -130,23 +291,155 @@ static void VcAudioIoWriteCallback
         
         framesLeft -= frameCount;
     }
+
+    VcTelemetryRecord(&telemetry.callbackTime, (gint)(g_get_monotonic_time() - callbackStart));
+}
+
+static void VcAudioIoUnderflowCallback(struct SoundIoOutStream *outstream)
+{
+    g_atomic_int_inc(&telemetry.underflows);
 }
 
-gpointer VcInitAudioIoCallback(gpointer data) 
+static void VcAudioIoErrorCallback(struct SoundIoOutStream *outstream, int error)
+{
+    g_atomic_int_inc(&telemetry.errors);
+    g_atomic_int_set(&telemetry.lastError, error);
+    g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Output stream error: %s", soundio_strerror(error));
+}
+
+gpointer VcAudioIoEventLoop(gpointer data) 
+{
+    while (true)
+    {
+        soundio_flush_events(soundio);
+        int ev = g_atomic_int_get(&events);
+        if (ev & VC_AUDIO_IO_STOP)
+        {
+            break;
+        }
+
+        g_mutex_lock(&sessionLock);
+        if (outstream != NULL)
+        {
+            if ((ev & VC_AUDIO_IO_PAUSE) && !paused)
+            {
+                soundio_outstream_pause(outstream, true);
+                paused = true;
+            }
+
+            // Prefill the ring buffer before unpausing so playback doesn't start with an underrun
+            if ((ev & VC_AUDIO_IO_PLAY) && paused 
+                && (soundio_ring_buffer_fill_count(rb) >= rbTargetBytes || (ev & VC_AUDIO_IO_EOS)))
+            {
+                soundio_outstream_pause(outstream, false);
+                paused = false;
+            }
+        }
+        g_mutex_unlock(&sessionLock);
+
+        g_usleep(500);
+    }
+
+    return NULL;
+}
+
+static void VcAudioIoCloseStream()
+{
+    if (outstream != NULL)
+    {
+        soundio_outstream_destroy(outstream);
+        outstream = NULL;
+    }
+
+    if (rb != NULL)
+    {
+        soundio_ring_buffer_destroy(rb);
+        rb = NULL;
+    }
+
+    streamRate = 0;
+    streamChannels = 0;
+    paused = true;
+}
+
+// Must be called with the session lock held
+static int VcAudioIoConfigureStream(int rate, int channels)
 {
     int error;
-    g_atomic_int_set(&events, 0);
-    
-    vorbis_info *info = (vorbis_info *)data;
-    struct SoundIo *soundio = soundio_create();
+    if (outstream != NULL && rate == streamRate && channels == streamChannels && streamLatency == requestedLatency)
+    {
+        return 0;
+    }
+
+    VcAudioIoCloseStream();
+    VcTelemetryReset(&telemetry);
+
+    outstream                           = soundio_outstream_create(device);
+    outstream->format                   = SoundIoFormatS16LE;
+    outstream->write_callback           = VcAudioIoWriteCallback;
+    outstream->underflow_callback       = VcAudioIoUnderflowCallback;
+    outstream->error_callback           = VcAudioIoErrorCallback;
+    outstream->sample_rate              = rate;
+    outstream->bytes_per_frame          = 2 * channels;
+    outstream->layout                   = *soundio_channel_layout_get_default(channels);
+    outstream->software_latency         = requestedLatency * (1.0 - VC_RING_LATENCY_SHARE);
+
+    if ((error = soundio_outstream_open(outstream))) 
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, soundio_strerror(error));
+        VcAudioIoCloseStream();
+        return -1;
+    }
+
+    if (outstream->layout_error)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, soundio_strerror(outstream->layout_error));
+        VcAudioIoCloseStream();
+        return -1;
+    }
+
+    // The ring gets what the device left of the budget. Sized in frames so the latency doesn't
+    // depend on the channel count.
+    double ringLatency = MAX(requestedLatency - outstream->software_latency, requestedLatency * VC_RING_LATENCY_SHARE);
+    int latencyFrames = (int)ceil(ringLatency * rate);
+    rbTargetBytes = latencyFrames * outstream->bytes_per_frame;
+    rb = soundio_ring_buffer_create(soundio, rbTargetBytes);
+    achievedLatency = outstream->software_latency + (double)latencyFrames / rate;
+
+    g_log(G_LOG_DOMAIN, G_LOG_LEVEL_INFO, "Playback latency: %.1f ms (device %.1f ms, buffer %.1f ms)", 
+        achievedLatency * 1000.0, outstream->software_latency * 1000.0, (double)latencyFrames / rate * 1000.0);
+
+    if ((error = soundio_outstream_start(outstream))) 
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, soundio_strerror(error));
+        VcAudioIoCloseStream();
+        return -1;
+    }
+
+    soundio_outstream_pause(outstream, true);
+    paused = true;
+
+    streamRate = rate;
+    streamChannels = channels;
+    streamLatency = requestedLatency;
+
+    return 0;
+}
+
+static int VcAudioIoStartSession()
+{
+    int error;
+    soundio = soundio_create();
     if (!soundio) {
         g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "failed to create sound io sturct");
-        return NULL;
+        return -1;
     }
 
     if ((error = soundio_connect(soundio))) {
         g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, soundio_strerror(error));
-        return NULL;
+        soundio_destroy(soundio);
+        soundio = NULL;
+        return -1;
     }
 
     soundio_flush_events(soundio);
@@ -154,82 +447,181 @@ gpointer VcInitAudioIoCallback(gpointer data)
     int default_out_device_index = soundio_default_output_device_index(soundio);
     if (default_out_device_index < 0) {
         g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "no output device found");
-        return NULL;
+        soundio_destroy(soundio);
+        soundio = NULL;
+        return -1;
     }
 
-    struct SoundIoDevice *device = soundio_get_output_device(soundio, default_out_device_index);
+    device = soundio_get_output_device(soundio, default_out_device_index);
     if (!device) {
         g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "couldn't get output device");
-        return NULL;
+        soundio_destroy(soundio);
+        soundio = NULL;
+        return -1;
     }
 
     g_log(G_LOG_DOMAIN, G_LOG_LEVEL_INFO, "Output Audio Device: %s", device->name);
 
-    struct SoundIoOutStream *outstream  = soundio_outstream_create(device);
-    outstream->format                   = SoundIoFormatS16LE;
-    outstream->write_callback           = VcAudioIoWriteCallback;
-    outstream->sample_rate              = info->rate;
-    outstream->bytes_per_frame          = 2 * info->channels;
-    outstream->layout                   = *soundio_channel_layout_get_default(info->channels);
+    audioIoThread = g_thread_new("audio-io", VcAudioIoEventLoop, NULL);
+    decoderThread = g_thread_new("decoder", VcDecodeCallback, NULL);
+    sessionStarted = true;
 
-    if ((error = soundio_outstream_open(outstream))) 
+    return 0;
+}
+
+static void VcAudioIoUnload()
+{
+    if (loaded)
     {
-        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, soundio_strerror(error));
-        return NULL;
+        ov_clear(&vf);
+        loaded = false;
     }
 
-    if (outstream->layout_error)
+    VcSeekIndexFree(seekIndex);
+    seekIndex = NULL;
+    loadGeneration++;
+}
+
+// Scans a file that wasn't indexed while encoding without holding the session lock, seeks
+// bisect with ov_pcm_seek until the finished index is swapped in
+static gpointer VcIndexBuildCallback(gpointer data)
+{
+    VcIndexBuild *build = (VcIndexBuild *)data;
+    VcSeekIndex *index = VcSeekIndexNew();
+    if (VcSeekIndexBuild(index, build->pPath) < 0 || VcSeekIndexIsEmpty(index))
     {
-        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, soundio_strerror(outstream->layout_error));
-        return NULL;
+        VcSeekIndexFree(index);
+        index = NULL;
     }
 
-    g_atomic_int_set(&events, (VC_AUDIO_IO_PAUSE));
+    g_mutex_lock(&sessionLock);
+    if (index != NULL && loaded && seekIndex == NULL && build->generation == loadGeneration)
+    {
+        seekIndex = index;
+        index = NULL;
+    }
+    g_mutex_unlock(&sessionLock);
 
-    rb = soundio_ring_buffer_create(soundio, info->rate * 0.2);
-    decoderThread = g_thread_new("decoder", VcDecodeCallback, outstream);
-        
-    if ((error = soundio_outstream_start(outstream))) {
-        soundio_strerror(outstream->layout_error);
-        return NULL;
+    VcSeekIndexFree(index);
+    g_free(build->pPath);
+    g_free(build);
+
+    return NULL;
+}
+
+// Must be called with the session lock held, drops the current file and silences the stream
+static void VcAudioIoPrepareOpen()
+{
+    VcAudioIoUnload();
+
+    g_atomic_int_set(&events, VC_AUDIO_IO_PAUSE);
+
+    if (outstream != NULL)
+    {
+        soundio_outstream_pause(outstream, true);
+        paused = true;
+        soundio_ring_buffer_clear(rb);
+        soundio_outstream_clear_buffer(outstream);
     }
+}
 
-    initialized = true;
+// Must be called with the session lock held, after vf was opened successfully
+static void VcAudioIoFinishOpen(VcSeekIndex *index)
+{
+    loaded = true;
+    seekIndex = index;
 
-    while (true)
+    // Reconfigure right away if the device is already open so the first play is instant
+    if (outstream != NULL)
     {
-        soundio_flush_events(soundio);
-        int ev = g_atomic_int_get(&events);
-        if (ev & VC_AUDIO_IO_STOP)
-        {
-            break;
-        }
+        vorbis_info *info = ov_info(&vf, -1);
+        VcAudioIoConfigureStream(info->rate, info->channels);
+    }
+}
 
-        if (ev & VC_AUDIO_IO_PAUSE)
-        {
-            soundio_outstream_pause(outstream, true);
-        }
+bool VcAudioIoOpen(const char *vcPath, VcSeekIndex *index)
+{
+    g_mutex_lock(&sessionLock);
 
-        if (ev & VC_AUDIO_IO_PLAY)
-        {
-            soundio_outstream_pause(outstream, false);
-        }
+    VcAudioIoPrepareOpen();
+
+    if (ov_fopen(vcPath, &vf) < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't open %s for playback", vcPath);
+        VcSeekIndexFree(index);
+        g_mutex_unlock(&sessionLock);
+        return false;
     }
 
-    g_atomic_int_set(&events, 0);
-    soundio_ring_buffer_destroy(rb);
-    soundio_outstream_clear_buffer(outstream);
-    soundio_outstream_destroy(outstream);
-    soundio_device_unref(device);
-    soundio_destroy(soundio);
-    
-    return NULL;
+    VcAudioIoFinishOpen(index);
+
+    if (index == NULL)
+    {
+        VcIndexBuild *build = g_new0(VcIndexBuild, 1);
+        build->pPath = g_strdup(vcPath);
+        build->generation = loadGeneration;
+        g_thread_unref(g_thread_new("seek-index", VcIndexBuildCallback, build));
+    }
+
+    g_mutex_unlock(&sessionLock);
+    return true;
+}
+
+bool VcAudioIoOpenBuffer(VcOggBuffer *buffer, VcSeekIndex *index)
+{
+    g_mutex_lock(&sessionLock);
+
+    VcAudioIoPrepareOpen();
+
+    memorySource.buffer = VcOggBufferRef(buffer);
+    memorySource.position = 0;
+    if (ov_open_callbacks(&memorySource, &vf, NULL, 0, vcMemoryCallbacks) < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't open the encoded buffer for playback");
+        VcMemoryClose(&memorySource);
+        VcSeekIndexFree(index);
+        g_mutex_unlock(&sessionLock);
+        return false;
+    }
+
+    VcAudioIoFinishOpen(index);
+
+    g_mutex_unlock(&sessionLock);
+    return true;
+}
+
+bool VcAudioIoOpenGrowingBuffer(VcOggBuffer *buffer)
+{
+    g_mutex_lock(&sessionLock);
+
+    VcAudioIoPrepareOpen();
+
+    // Opened once the encoder has marked the headers written, so this doesn't wait on the main thread
+    memorySource.buffer = VcOggBufferRef(buffer);
+    memorySource.position = 0;
+    memorySource.timeout = VC_GROWING_OPEN_TIMEOUT;
+    if (ov_open_callbacks(&memorySource, &vf, NULL, 0, vcGrowingCallbacks) < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't open the stream being encoded for playback");
+        VcMemoryClose(&memorySource);
+        g_mutex_unlock(&sessionLock);
+        return false;
+    }
+
+    memorySource.timeout = 0;
+    memorySource.bGrowing = true;
+    VcAudioIoFinishOpen(NULL);
+
+    g_mutex_unlock(&sessionLock);
+    return true;
 }
 
-void VcAudioIoInit(const char *vcPath)
+// Drops whatever is loaded, like the preview of an encode that failed
+void VcAudioIoClose()
 {
-    ov_fopen(vcPath, &vf);
-    audioIoThread = g_thread_new("audio-io", VcInitAudioIoCallback, ov_info(&vf, -1));
+    g_mutex_lock(&sessionLock);
+    VcAudioIoPrepareOpen();
+    g_mutex_unlock(&sessionLock);
 }
 
 void VcAudioIoFinalize() 
@@ -245,12 +637,27 @@ void VcAudioIoFinalize()
     {
         g_thread_join(audioIoThread);
     }
+
+    VcAudioIoCloseStream();
+
+    if (device)
+    {
+        soundio_device_unref(device);
+    }
+
+    if (soundio)
+    {
+        soundio_destroy(soundio);
+    }
     
-    ov_clear(&vf);
+    VcAudioIoUnload();
     
-    initialized = false;
+    g_atomic_int_set(&events, 0);
+    sessionStarted = false;
     audioIoThread = NULL;
     decoderThread = NULL;
+    device = NULL;
+    soundio = NULL;
 }
 
 void VcAudioIoReset()
@@ -258,13 +665,152 @@ void VcAudioIoReset()
     g_atomic_int_or(&events, VC_AUDIO_IO_RESET);
 }
 
+void VcAudioIoSetLatency(double seconds)
+{
+    g_mutex_lock(&sessionLock);
+    requestedLatency = CLAMP(seconds, VC_AUDIO_IO_MIN_LATENCY, VC_AUDIO_IO_MAX_LATENCY);
+    if (outstream != NULL && loaded)
+    {
+        vorbis_info *info = ov_info(&vf, -1);
+        VcAudioIoConfigureStream(info->rate, info->channels);
+    }
+    g_mutex_unlock(&sessionLock);
+}
+
+bool VcAudioIoSeek(double seconds)
+{
+    char buffer[4096];
+    g_mutex_lock(&sessionLock);
+    if (!loaded || !ov_seekable(&vf))
+    {
+        g_mutex_unlock(&sessionLock);
+        return false;
+    }
+
+    vorbis_info *info = ov_info(&vf, -1);
+    ogg_int64_t target = (ogg_int64_t)(seconds * info->rate);
+    int64_t offset = seekIndex != NULL ? VcSeekIndexFind(seekIndex, target) : -1;
+    int status = offset >= 0 ? ov_raw_seek(&vf, offset) : ov_pcm_seek(&vf, target);
+    if (status < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Seek failed: %d", status);
+        g_mutex_unlock(&sessionLock);
+        return false;
+    }
+
+    // A chain whose links don't start at granule 0 throws the index off, vorbisfile knows the real positions
+    ogg_int64_t position = ov_pcm_tell(&vf);
+    if (offset >= 0 && position > target && ov_pcm_seek(&vf, target) == 0)
+    {
+        position = ov_pcm_tell(&vf);
+    }
+
+    // The page start is at most a page before the target, decode up to the exact sample
+    int bytesPerFrame = 2 * info->channels;
+    while (position < target)
+    {
+        ogg_int64_t bytesToSkip = (target - position) * bytesPerFrame;
+        int length = bytesToSkip < (ogg_int64_t)sizeof(buffer) ? (int)bytesToSkip : (int)(sizeof(buffer) / bytesPerFrame * bytesPerFrame);
+        long nBytes = ov_read(&vf, buffer, length, 0, 2, 1, &bitstream);
+        if (nBytes <= 0)
+        {
+            break;
+        }
+
+        position += nBytes / bytesPerFrame;
+    }
+
+    g_atomic_int_and(&events, ~(VC_AUDIO_IO_EOS | VC_AUDIO_IO_RESET));
+
+    if (outstream != NULL)
+    {
+        // Let the event loop prefill again before resuming
+        soundio_outstream_pause(outstream, true);
+        paused = true;
+        soundio_ring_buffer_clear(rb);
+        soundio_outstream_clear_buffer(outstream);
+    }
+
+    g_mutex_unlock(&sessionLock);
+    return true;
+}
+
+double VcAudioIoGetPosition()
+{
+    g_mutex_lock(&sessionLock);
+    double position = 0.0;
+    if (loaded)
+    {
+        vorbis_info *info = ov_info(&vf, -1);
+        ogg_int64_t frames = ov_pcm_tell(&vf);
+        if (rb != NULL)
+        {
+            frames -= soundio_ring_buffer_fill_count(rb) / (2 * info->channels);
+        }
+
+        position = frames > 0 ? (double)frames / info->rate : 0.0;
+    }
+    g_mutex_unlock(&sessionLock);
+
+    return position;
+}
+
+double VcAudioIoGetDuration()
+{
+    g_mutex_lock(&sessionLock);
+    double duration = loaded && ov_seekable(&vf) ? ov_time_total(&vf, -1) : 0.0;
+    g_mutex_unlock(&sessionLock);
+
+    return duration;
+}
+
+double VcAudioIoGetLatency()
+{
+    g_mutex_lock(&sessionLock);
+    double latency = achievedLatency;
+    g_mutex_unlock(&sessionLock);
+
+    return latency;
+}
+
+VcPlaybackTelemetry *VcAudioIoGetTelemetry()
+{
+    return &telemetry;
+}
+
+bool VcAudioIoIsPlaying()
+{
+    return loaded && (g_atomic_int_get(&events) & VC_AUDIO_IO_PLAY);
+}
+
 bool VcAudioIoIsInitialized() 
 { 
-    return initialized; 
+    return loaded; 
 }
 
 bool VcAudioIoTogglePlayback() 
 {
+    if (!loaded)
+    {
+        return false;
+    }
+
+    if (!sessionStarted && VcAudioIoStartSession() < 0)
+    {
+        return false;
+    }
+
+    // The decode thread can drop the stream in between, a growing buffer it failed to reopen
+    g_mutex_lock(&sessionLock);
+    vorbis_info *info = loaded ? ov_info(&vf, -1) : NULL;
+    int status = info != NULL ? VcAudioIoConfigureStream(info->rate, info->channels) : -1;
+    g_mutex_unlock(&sessionLock);
+
+    if (status < 0)
+    {
+        return false;
+    }
+
     int ev = g_atomic_int_get(&events);
     bool playing = false;
     if (ev & VC_AUDIO_IO_PAUSE)
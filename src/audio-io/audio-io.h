@@ -4,11 +4,29 @@
 #include <gtk-4.0/gtk/gtk.h>
 #include <soundio/soundio.h>
 #include <stdbool.h>
+#include "telemetry.h"
+#include "../encoding/seek-index.h"
+#include "../encoding/ogg-buffer.h"
 
-void    VcAudioIoInit(const char *vcPath);
+#define VC_AUDIO_IO_MIN_LATENCY     0.005
+#define VC_AUDIO_IO_MAX_LATENCY     0.5
+#define VC_AUDIO_IO_DEFAULT_LATENCY 0.2
+
+bool    VcAudioIoOpen(const char *vcPath, VcSeekIndex *index);
+bool    VcAudioIoOpenBuffer(VcOggBuffer *buffer, VcSeekIndex *index);
+bool    VcAudioIoOpenGrowingBuffer(VcOggBuffer *buffer);
+void    VcAudioIoClose();
 bool    VcAudioIoIsInitialized();
+bool    VcAudioIoIsPlaying();
 bool    VcAudioIoTogglePlayback();
 void    VcAudioIoFinalize();
 void    VcAudioIoReset();
+bool    VcAudioIoSeek(double seconds);
+double  VcAudioIoGetPosition();
+double  VcAudioIoGetDuration();
+void    VcAudioIoSetLatency(double seconds);
+double  VcAudioIoGetLatency();
+
+VcPlaybackTelemetry *VcAudioIoGetTelemetry();
 
 #endif // VC_AUDIO_IO_H
\ No newline at end of file
@@ -0,0 +1,417 @@
+#include "capture.h"
+#include "../gui/log-view.h"
+#include <string.h>
+
+typedef struct
+{
+    VcCaptureOptions            *options;
+    struct SoundIoRingBuffer    *ring;
+    gint                        captured;       // frames the callback got, wraps after a few hours at 48 kHz
+    gint                        dropped;
+    gint                        overflows;
+    gint                        errors;
+    gint                        lastError;      // SoundIoError of the latest error callback
+
+    // Copied from the stream so the ring can still be drained once it is destroyed
+    int                         nChannels;
+    int                         nBytesPerFrame;
+    enum SoundIoFormat          format;
+
+} VcCaptureState;
+
+// Runs on the backend's real-time thread: no locks, no allocation, frames that don't fit are counted and dropped
+static void VcCaptureReadCallback(struct SoundIoInStream *instream, int frameCountMin, int frameCountMax)
+{
+    VcCaptureState *state = (VcCaptureState *)instream->userdata;
+    int bytesPerFrame = instream->bytes_per_frame;
+    int bytesPerSample = instream->bytes_per_sample;
+    int freeFrames = soundio_ring_buffer_free_count(state->ring) / bytesPerFrame;
+    char *write = soundio_ring_buffer_write_ptr(state->ring);
+    int left = frameCountMax;
+
+    while (left > 0)
+    {
+        struct SoundIoChannelArea *areas;
+        int frameCount = left;
+        if (soundio_instream_begin_read(instream, &areas, &frameCount) != 0)
+        {
+            g_atomic_int_inc(&state->errors);
+            break;
+        }
+
+        if (frameCount == 0)
+        {
+            break;
+        }
+
+        int keep = MIN(frameCount, freeFrames);
+
+        // A hole in the input reads as silence
+        if (areas == NULL)
+        {
+            memset(write, 0, (size_t)keep * bytesPerFrame);
+            write += keep * bytesPerFrame;
+        }
+
+        else
+        {
+            for (int frame = 0; frame < keep; frame++)
+            {
+                for (int ch = 0; ch < instream->layout.channel_count; ch++)
+                {
+                    memcpy(write, areas[ch].ptr, bytesPerSample);
+                    areas[ch].ptr += areas[ch].step;
+                    write += bytesPerSample;
+                }
+            }
+        }
+
+        freeFrames -= keep;
+        g_atomic_int_add(&state->captured, frameCount);
+        if (keep < frameCount)
+        {
+            g_atomic_int_add(&state->dropped, frameCount - keep);
+        }
+
+        soundio_instream_end_read(instream);
+        left -= frameCount;
+    }
+
+    soundio_ring_buffer_advance_write_ptr(state->ring, (int)(write - soundio_ring_buffer_write_ptr(state->ring)));
+}
+
+static void VcCaptureOverflowCallback(struct SoundIoInStream *instream)
+{
+    VcCaptureState *state = (VcCaptureState *)instream->userdata;
+    g_atomic_int_inc(&state->overflows);
+}
+
+static void VcCaptureErrorCallback(struct SoundIoInStream *instream, int error)
+{
+    // Real-time thread as well, the capture loop reports it
+    VcCaptureState *state = (VcCaptureState *)instream->userdata;
+    g_atomic_int_set(&state->lastError, error);
+    g_atomic_int_inc(&state->errors);
+}
+
+// Deinterleaves up to one block from the ring into the analysis buffer, returns the frames encoded
+static int VcCaptureEncodeBlock(VcCaptureState *state, VcVorbisEncoder *encoder, GError **error)
+{
+    int bytesPerFrame = state->nBytesPerFrame;
+    int frames = MIN(soundio_ring_buffer_fill_count(state->ring) / bytesPerFrame, VC_CAPTURE_BLOCK_FRAMES);
+    if (frames == 0)
+    {
+        return 0;
+    }
+
+    int channels = state->nChannels;
+    float **buffer = VcVorbisEncoderBuffer(encoder, frames);
+    const char *read = soundio_ring_buffer_read_ptr(state->ring);
+    if (state->format == SoundIoFormatFloat32NE)
+    {
+        const float *pcm = (const float *)read;
+        for (int frame = 0; frame < frames; frame++)
+        {
+            for (int ch = 0; ch < channels; ch++)
+            {
+                buffer[ch][frame] = pcm[frame * channels + ch];
+            }
+        }
+    }
+
+    else
+    {
+        const int16_t *pcm = (const int16_t *)read;
+        for (int frame = 0; frame < frames; frame++)
+        {
+            for (int ch = 0; ch < channels; ch++)
+            {
+                buffer[ch][frame] = pcm[frame * channels + ch] / 32768.0f;
+            }
+        }
+    }
+
+    soundio_ring_buffer_advance_read_ptr(state->ring, frames * bytesPerFrame);
+    return VcVorbisEncoderWrote(encoder, frames, error) < 0 ? -1 : frames;
+}
+
+static struct SoundIoInStream *VcCaptureOpenStream(VcCaptureOptions *options, struct SoundIoDevice *device, VcCaptureState *state)
+{
+    const struct SoundIoChannelLayout *layout = soundio_channel_layout_get_default(options->nChannels);
+    if (layout == NULL || !soundio_device_supports_layout(device, layout))
+    {
+        layout = &device->current_layout;
+    }
+
+    enum SoundIoFormat format = soundio_device_supports_format(device, SoundIoFormatFloat32NE) ? SoundIoFormatFloat32NE
+        : soundio_device_supports_format(device, SoundIoFormatS16NE) ? SoundIoFormatS16NE
+        : SoundIoFormatInvalid;
+    if (format == SoundIoFormatInvalid)
+    {
+        VcLogViewPostLine(options->pLogView, "%s has no float or 16-bit sample format", device->name);
+        return NULL;
+    }
+
+    struct SoundIoInStream *instream = soundio_instream_create(device);
+    if (instream == NULL)
+    {
+        return NULL;
+    }
+
+    instream->format            = format;
+    instream->sample_rate       = soundio_device_nearest_sample_rate(device, VC_CAPTURE_RATE);
+    instream->layout            = *layout;
+    instream->software_latency  = VC_CAPTURE_LATENCY;
+    instream->read_callback     = VcCaptureReadCallback;
+    instream->overflow_callback = VcCaptureOverflowCallback;
+    instream->error_callback    = VcCaptureErrorCallback;
+    instream->userdata          = state;
+    instream->name              = "Vorbis capture";
+
+    int error = soundio_instream_open(instream);
+    if (error == 0 && instream->layout_error)
+    {
+        error = instream->layout_error;
+    }
+
+    if (error != 0)
+    {
+        VcLogViewPostLine(options->pLogView, "Couldn't open %s for capture: %s", device->name, soundio_strerror(error));
+        soundio_instream_destroy(instream);
+        return NULL;
+    }
+
+    state->nChannels        = instream->layout.channel_count;
+    state->nBytesPerFrame   = instream->bytes_per_frame;
+    state->format           = instream->format;
+    return instream;
+}
+
+static int VcCaptureOpenOutput(VcCaptureOptions *options, VcVorbisEncoder *encoder, GError **error)
+{
+    GFile *file = g_file_new_for_path(options->pOutPath);
+    GFileOutputStream *stream = g_file_replace(file, NULL, false, G_FILE_CREATE_REPLACE_DESTINATION, NULL, error);
+    g_object_unref(file);
+    if (stream == NULL)
+    {
+        return -1;
+    }
+
+    encoder->pOut = G_OUTPUT_STREAM(stream);
+    return VcVorbisEncoderWriteHeaders(encoder, error);
+}
+
+// Lag is the captured audio still waiting in the ring, it stays near zero while encoding keeps up
+static void VcCaptureUpdate(VcCaptureState *state, guint *lastCaptured)
+{
+    VcCaptureOptions *options = state->options;
+    guint captured = (guint)g_atomic_int_get(&state->captured);
+    options->nCapturedFrames += (guint)(captured - *lastCaptured);
+    options->nDroppedFrames = (guint)g_atomic_int_get(&state->dropped);
+    options->nOverflows = g_atomic_int_get(&state->overflows);
+    *lastCaptured = captured;
+
+    double lag = (double)(options->nCapturedFrames - options->nDroppedFrames - options->nEncodedFrames) / options->nRate;
+    options->dMaxLag = MAX(options->dMaxLag, lag);
+}
+
+static int VcCaptureRun(VcCaptureState *state, struct SoundIoInStream *instream, VcVorbisEncoder *encoder, GError **error)
+{
+    VcCaptureOptions *options = state->options;
+    int64_t nextReport = (int64_t)(VC_CAPTURE_REPORT_SECONDS * options->nRate);
+    guint lastCaptured = 0;
+    int reportedErrors = 0;
+    int status = 0;
+
+    while (status == 0 && !g_atomic_int_get(&options->stop))
+    {
+        int frames = VcCaptureEncodeBlock(state, encoder, error);
+        if (frames < 0)
+        {
+            status = -1;
+            break;
+        }
+
+        options->nEncodedFrames += frames;
+        VcCaptureUpdate(state, &lastCaptured);
+
+        int errors = g_atomic_int_get(&state->errors);
+        if (errors > reportedErrors)
+        {
+            int code = g_atomic_int_get(&state->lastError);
+            VcLogViewPostLine(options->pLogView, "Input stream error: %s", code != 0 ? soundio_strerror(code) : "couldn't read from the device");
+            reportedErrors = errors;
+        }
+
+        if (options->nCapturedFrames >= nextReport)
+        {
+            VcLogViewPostLine(options->pLogView, "Recorded %.0fs: lag %.3fs (max %.3fs), %" G_GINT64_FORMAT " frames dropped, %d overruns",
+                (double)options->nCapturedFrames / options->nRate, 
+                (double)(options->nCapturedFrames - options->nDroppedFrames - options->nEncodedFrames) / options->nRate,
+                options->dMaxLag, options->nDroppedFrames, options->nOverflows);
+            nextReport += (int64_t)(VC_CAPTURE_REPORT_SECONDS * options->nRate);
+        }
+
+        if (frames == 0)
+        {
+            g_usleep(VC_CAPTURE_POLL);
+        }
+    }
+
+    // No more callbacks once the stream is gone, what is left in the ring still goes into the file
+    soundio_instream_destroy(instream);
+    VcCaptureUpdate(state, &lastCaptured);
+
+    int frames = 0;
+    while (status == 0 && (frames = VcCaptureEncodeBlock(state, encoder, error)) > 0)
+    {
+        options->nEncodedFrames += frames;
+    }
+
+    if (status == 0 && frames < 0)
+    {
+        status = -1;
+    }
+
+    return status == 0 ? VcVorbisEncoderFinish(encoder, error) : -1;
+}
+
+gpointer VcCaptureCallback(gpointer data)
+{
+    VcCaptureOptions *options = (VcCaptureOptions *)data;
+    VcCaptureState state = { .options = options };
+    VcVorbisEncoder encoder = { 0 };
+    struct SoundIoDevice *device = NULL;
+    struct SoundIoInStream *instream = NULL;
+    GError *error = NULL;
+
+    options->nRate = 0;
+    options->nCapturedFrames = 0;
+    options->nEncodedFrames = 0;
+    options->nDroppedFrames = 0;
+    options->nOverflows = 0;
+    options->dMaxLag = 0.0;
+    options->nBytes = 0;
+
+    struct SoundIo *soundio = soundio_create();
+    int status = soundio != NULL ? 0 : -1;
+    if (status == 0)
+    {
+        int result = options->bDummyBackend ? soundio_connect_backend(soundio, SoundIoBackendDummy) : soundio_connect(soundio);
+        if (result != 0)
+        {
+            VcLogViewPostLine(options->pLogView, "Couldn't connect to the audio backend: %s", soundio_strerror(result));
+            status = -1;
+        }
+    }
+
+    if (status == 0)
+    {
+        soundio_flush_events(soundio);
+        int index = soundio_default_input_device_index(soundio);
+        device = index >= 0 ? soundio_get_input_device(soundio, index) : NULL;
+        if (device == NULL)
+        {
+            VcLogViewPostLine(options->pLogView, "No input device found");
+            status = -1;
+        }
+    }
+
+    if (status == 0)
+    {
+        instream = VcCaptureOpenStream(options, device, &state);
+        status = instream != NULL ? 0 : -1;
+    }
+
+    if (status == 0)
+    {
+        options->nRate = instream->sample_rate;
+        state.ring = soundio_ring_buffer_create(soundio, (int)(VC_CAPTURE_RING_SECONDS * options->nRate) * state.nBytesPerFrame);
+        status = state.ring != NULL ? VcVorbisEncoderInitTuned(&encoder, state.nChannels, options->nRate, &options->tuning) : -1;
+    }
+
+    if (status == 0)
+    {
+        status = VcCaptureOpenOutput(options, &encoder, &error);
+    }
+
+    if (status == 0)
+    {
+        int result = soundio_instream_start(instream);
+        if (result != 0)
+        {
+            VcLogViewPostLine(options->pLogView, "Couldn't start capturing: %s", soundio_strerror(result));
+            status = -1;
+        }
+    }
+
+    if (status == 0)
+    {
+        VcLogViewPostLine(options->pLogView, "Recording %s at %ld Hz, %d channels, %s samples", 
+            device->name, options->nRate, state.nChannels, state.format == SoundIoFormatFloat32NE ? "float" : "16-bit");
+
+        status = VcCaptureRun(&state, instream, &encoder, &error);
+        instream = NULL;
+    }
+
+    if (g_atomic_int_get(&state.errors) > 0)
+    {
+        VcLogViewPostLine(options->pLogView, "The input stream reported %d errors", g_atomic_int_get(&state.errors));
+    }
+
+    if (encoder.pOut != NULL && !g_output_stream_close(encoder.pOut, NULL, error == NULL ? &error : NULL))
+    {
+        status = -1;
+    }
+
+    if (error != NULL)
+    {
+        VcLogViewPostLine(options->pLogView, "%s", error->message);
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+    }
+
+    options->nBytes = encoder.nBytesWritten;
+    options->status = status;
+
+    if (encoder.pOut != NULL)
+    {
+        g_object_unref(encoder.pOut);
+    }
+    VcVorbisEncoderClear(&encoder);
+
+    if (instream != NULL)
+    {
+        soundio_instream_destroy(instream);
+    }
+
+    if (state.ring != NULL)
+    {
+        soundio_ring_buffer_destroy(state.ring);
+    }
+
+    if (device != NULL)
+    {
+        soundio_device_unref(device);
+    }
+
+    if (soundio != NULL)
+    {
+        soundio_destroy(soundio);
+    }
+
+    g_main_context_invoke(NULL, options->cbOnFinished, options);
+    return NULL;
+}
+
+GThread *VcCaptureStart(VcCaptureOptions *options)
+{
+    g_atomic_int_set(&options->stop, 0);
+    return g_thread_new("capture", VcCaptureCallback, options);
+}
+
+// Ends the recording, the frames already captured are still encoded
+void VcCaptureStop(VcCaptureOptions *options)
+{
+    g_atomic_int_set(&options->stop, 1);
+}
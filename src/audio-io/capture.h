@@ -0,0 +1,44 @@
+#ifndef VC_CAPTURE_H
+#define VC_CAPTURE_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <soundio/soundio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "../encoding/vorbis-encoder.h"
+
+#define VC_CAPTURE_RATE             48000   // asked for first, the device's nearest rate otherwise
+#define VC_CAPTURE_LATENCY          0.02    // seconds the device may hold before the read callback runs
+#define VC_CAPTURE_RING_SECONDS     4.0     // how far encoding may fall behind before frames are dropped
+#define VC_CAPTURE_BLOCK_FRAMES     4096
+#define VC_CAPTURE_POLL             2000    // microseconds the encoder sleeps when the ring is empty
+#define VC_CAPTURE_REPORT_SECONDS   5.0
+
+// Records the default input device straight to Ogg Vorbis. The read callback only copies
+// frames into a soundio ring buffer, the encoder thread drains it until it is stopped.
+typedef struct
+{
+    gchar               *pOutPath;
+    GtkTextView         *pLogView;
+    GSourceFunc         cbOnFinished;
+    VcEncoderTuning     tuning;
+    int                 nChannels;          // asked for, the device's own layout if it can't do it
+    bool                bDummyBackend;      // capture from libsoundio's dummy backend, silence in real time
+    gint                stop;
+
+    // results
+    int                 status;
+    long                nRate;
+    int64_t             nCapturedFrames;
+    int64_t             nEncodedFrames;
+    int64_t             nDroppedFrames;     // didn't fit in the ring, encoding fell too far behind
+    int                 nOverflows;         // reported by the device, frames lost before the callback saw them
+    double              dMaxLag;            // seconds of captured audio waiting to be encoded, at worst
+    int64_t             nBytes;
+
+} VcCaptureOptions;
+
+GThread *VcCaptureStart(VcCaptureOptions *options);
+void    VcCaptureStop(VcCaptureOptions *options);
+
+#endif // VC_CAPTURE_H
@@ -0,0 +1,126 @@
+#include "telemetry.h"
+#include <string.h>
+#include <math.h>
+
+static void VcTelemetryMetricReset(VcTelemetryMetric *metric)
+{
+    g_atomic_int_set(&metric->count, 0);
+    g_atomic_pointer_set(&metric->sum, 0);
+    g_atomic_int_set(&metric->min, G_MAXINT);
+    g_atomic_int_set(&metric->max, 0);
+    for (size_t i = 0; i < VC_TELEMETRY_BUCKETS; i++)
+    {
+        g_atomic_int_set(&metric->histogram[i], 0);
+    }
+}
+
+void VcTelemetryReset(VcPlaybackTelemetry *telemetry)
+{
+    g_atomic_int_set(&telemetry->underflows, 0);
+    g_atomic_int_set(&telemetry->errors, 0);
+    g_atomic_int_set(&telemetry->lastError, 0);
+    VcTelemetryMetricReset(&telemetry->callbackTime);
+    VcTelemetryMetricReset(&telemetry->bufferFill);
+    VcTelemetryMetricReset(&telemetry->decodeTime);
+}
+
+static int VcTelemetryBucket(gint value)
+{
+    if (value <= 0)
+    {
+        return 0;
+    }
+
+    int bucket = (int)(log2f((float)value + 1.0f) * VC_TELEMETRY_BUCKETS_PER_OCTAVE);
+    return bucket < VC_TELEMETRY_BUCKETS ? bucket : VC_TELEMETRY_BUCKETS - 1;
+}
+
+static double VcTelemetryBucketUpperBound(int bucket)
+{
+    return exp2((double)(bucket + 1) / VC_TELEMETRY_BUCKETS_PER_OCTAVE) - 1.0;
+}
+
+void VcTelemetryRecord(VcTelemetryMetric *metric, gint value)
+{
+    g_atomic_int_inc(&metric->count);
+    g_atomic_pointer_add(&metric->sum, value);
+    g_atomic_int_inc(&metric->histogram[VcTelemetryBucket(value)]);
+
+    gint current = g_atomic_int_get(&metric->min);
+    while (value < current && !g_atomic_int_compare_and_exchange(&metric->min, current, value))
+    {
+        current = g_atomic_int_get(&metric->min);
+    }
+
+    current = g_atomic_int_get(&metric->max);
+    while (value > current && !g_atomic_int_compare_and_exchange(&metric->max, current, value))
+    {
+        current = g_atomic_int_get(&metric->max);
+    }
+}
+
+void VcTelemetrySummarize(VcTelemetryMetric *metric, VcTelemetrySummary *summary)
+{
+    memset(summary, 0, sizeof(VcTelemetrySummary));
+    summary->count = g_atomic_int_get(&metric->count);
+    if (summary->count == 0)
+    {
+        return;
+    }
+
+    summary->min = g_atomic_int_get(&metric->min);
+    summary->max = g_atomic_int_get(&metric->max);
+    summary->avg = (double)(gsize)g_atomic_pointer_get(&metric->sum) / summary->count;
+
+    // The histogram is only approximate, the bucket bound is clamped to the exact maximum
+    int threshold = (int)ceil(summary->count * 0.99);
+    int seen = 0;
+    for (int i = 0; i < VC_TELEMETRY_BUCKETS; i++)
+    {
+        seen += g_atomic_int_get(&metric->histogram[i]);
+        if (seen >= threshold)
+        {
+            summary->p99 = MIN(VcTelemetryBucketUpperBound(i), summary->max);
+            break;
+        }
+    }
+}
+
+gchar *VcTelemetryFormat(VcPlaybackTelemetry *telemetry)
+{
+    VcTelemetrySummary callback, fill, decode;
+    VcTelemetrySummarize(&telemetry->callbackTime, &callback);
+    VcTelemetrySummarize(&telemetry->bufferFill, &fill);
+    VcTelemetrySummarize(&telemetry->decodeTime, &decode);
+
+    return g_strdup_printf(
+        "Underflows: %d  Errors: %d\n"
+        "Callback (us): min %.0f avg %.1f max %.0f p99 %.0f\n"
+        "Buffer fill (frames): min %.0f avg %.1f max %.0f\n"
+        "Decode (us): min %.0f avg %.1f max %.0f p99 %.0f",
+        g_atomic_int_get(&telemetry->underflows), g_atomic_int_get(&telemetry->errors),
+        callback.min, callback.avg, callback.max, callback.p99,
+        fill.min, fill.avg, fill.max,
+        decode.min, decode.avg, decode.max, decode.p99
+    );
+}
+
+gchar *VcTelemetryFormatCsv(VcPlaybackTelemetry *telemetry)
+{
+    const char *names[] = { "callback_us", "buffer_fill_frames", "decode_us" };
+    VcTelemetryMetric *metrics[] = { &telemetry->callbackTime, &telemetry->bufferFill, &telemetry->decodeTime };
+
+    GString *csv = g_string_new("metric,count,min,avg,max,p99\n");
+    g_string_append_printf(csv, "underflows,%d,,,,\n", g_atomic_int_get(&telemetry->underflows));
+    g_string_append_printf(csv, "errors,%d,,,,\n", g_atomic_int_get(&telemetry->errors));
+
+    for (size_t i = 0; i < G_N_ELEMENTS(metrics); i++)
+    {
+        VcTelemetrySummary summary;
+        VcTelemetrySummarize(metrics[i], &summary);
+        g_string_append_printf(csv, "%s,%d,%.0f,%.2f,%.0f,%.0f\n", 
+            names[i], summary.count, summary.min, summary.avg, summary.max, summary.p99);
+    }
+
+    return g_string_free(csv, false);
+}
@@ -0,0 +1,48 @@
+#ifndef VC_TELEMETRY_H
+#define VC_TELEMETRY_H
+
+#include <glib.h>
+#include <stdbool.h>
+
+#define VC_TELEMETRY_BUCKETS            128
+#define VC_TELEMETRY_BUCKETS_PER_OCTAVE 8
+
+// Lock-free accumulator, safe to feed from the real-time thread
+typedef struct
+{
+    gint        count;
+    gsize       sum;
+    gint        min;
+    gint        max;
+    gint        histogram[VC_TELEMETRY_BUCKETS];
+
+} VcTelemetryMetric;
+
+typedef struct
+{
+    gint                underflows;
+    gint                errors;
+    gint                lastError;
+    VcTelemetryMetric   callbackTime;   // microseconds spent in the write callback
+    VcTelemetryMetric   bufferFill;     // frames queued in the ring buffer when the callback runs
+    VcTelemetryMetric   decodeTime;     // microseconds spent in a single ov_read
+
+} VcPlaybackTelemetry;
+
+typedef struct
+{
+    int         count;
+    double      min;
+    double      avg;
+    double      max;
+    double      p99;
+
+} VcTelemetrySummary;
+
+void    VcTelemetryReset(VcPlaybackTelemetry *telemetry);
+void    VcTelemetryRecord(VcTelemetryMetric *metric, gint value);
+void    VcTelemetrySummarize(VcTelemetryMetric *metric, VcTelemetrySummary *summary);
+gchar   *VcTelemetryFormat(VcPlaybackTelemetry *telemetry);
+gchar   *VcTelemetryFormatCsv(VcPlaybackTelemetry *telemetry);
+
+#endif // VC_TELEMETRY_H
@@ -0,0 +1,307 @@
+#include "decoding.h"
+#include "../encoding/wave.h"
+#include "../dsp/channel-mix.h"
+#include "../encoding/atomic-output.h"
+#include <vorbis/vorbisfile.h>
+#include <string.h>
+
+// "music/song.ogg" into "out" becomes "out/song.wav", or "out/song-2.wav" for number 2
+static gchar *VcDecodeNumberedPath(const char *inPath, const char *outDir, int number)
+{
+    gchar *name = g_path_get_basename(inPath);
+    char *dot = strrchr(name, '.');
+    if (dot != NULL && dot != name)
+    {
+        *dot = '\0';
+    }
+
+    gchar *fileName = number > 0 ? g_strdup_printf("%s-%d.wav", name, number) : g_strconcat(name, ".wav", NULL);
+    gchar *path = g_build_filename(outDir, fileName, NULL);
+    g_free(fileName);
+    g_free(name);
+    return path;
+}
+
+gchar *VcDecodeOutputPath(const char *inPath, const char *outDir)
+{
+    return VcDecodeNumberedPath(inPath, outDir, 0);
+}
+
+// Case is ignored since the output directory may be on a file system that ignores it too
+static bool VcDecodeOutputTaken(VcDecodeOptions *options, const char *outPath)
+{
+    for (guint i = 0; i < options->jobs->len; i++)
+    {
+        VcDecodeJob *job = g_ptr_array_index(options->jobs, i);
+        if (g_ascii_strcasecmp(job->pOutPath, outPath) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void VcDecodeJobFree(gpointer data)
+{
+    VcDecodeJob *job = (VcDecodeJob *)data;
+    g_free(job->pInPath);
+    g_free(job->pOutPath);
+    g_free(job->pError);
+    g_free(job);
+}
+
+void VcDecodeAddJob(VcDecodeOptions *options, const char *inPath, const char *outDir)
+{
+    if (options->jobs == NULL)
+    {
+        options->jobs = g_ptr_array_new_with_free_func(VcDecodeJobFree);
+    }
+
+    VcDecodeJob *job = g_new0(VcDecodeJob, 1);
+    job->pInPath = g_strdup(inPath);
+    job->pOutPath = VcDecodeOutputPath(inPath, outDir);
+
+    // Files with the same name from different directories would be decoded over each other at the same time
+    for (int number = 1; VcDecodeOutputTaken(options, job->pOutPath); number++)
+    {
+        g_free(job->pOutPath);
+        job->pOutPath = VcDecodeNumberedPath(inPath, outDir, number);
+    }
+
+    g_ptr_array_add(options->jobs, job);
+}
+
+void VcDecodeJobsClear(VcDecodeOptions *options)
+{
+    if (options->jobs != NULL)
+    {
+        g_ptr_array_unref(options->jobs);
+        options->jobs = NULL;
+    }
+}
+
+// Rounds to nearest and saturates, written so the compiler can vectorize it
+static inline int32_t VcQuantize(float sample, float scale)
+{
+    float value = sample * scale;
+    value = value > scale - 1.0f ? scale - 1.0f : value < -scale ? -scale : value;
+    return (int32_t)(value + (value >= 0.0f ? 0.5f : -0.5f));
+}
+
+// Planar vorbis frames to interleaved WAV frames, order maps every WAV channel to its vorbis channel.
+// One channel at a time, so each inner loop is a single quantize pass with a constant store stride.
+static void VcDecodeInterleave(float **pcm, const int *order, int channels, long frames, VcDecodeFormat format, uint8_t *dst)
+{
+    for (int ch = 0; ch < channels; ch++)
+    {
+        const float *restrict in = pcm[order[ch]];
+        switch (format)
+        {
+            case VC_DECODE_FLOAT32:
+            {
+                float *restrict out = (float *)dst + ch;
+                for (long i = 0; i < frames; i++)
+                {
+                    out[i * channels] = in[i];
+                }
+                break;
+            }
+
+            case VC_DECODE_PCM16:
+            {
+                int16_t *restrict out = (int16_t *)dst + ch;
+                for (long i = 0; i < frames; i++)
+                {
+                    out[i * channels] = (int16_t)VcQuantize(in[i], 32768.0f);
+                }
+                break;
+            }
+
+            case VC_DECODE_PCM24:
+            {
+                uint8_t *restrict out = dst + ch * 3;
+                for (long i = 0; i < frames; i++)
+                {
+                    int32_t sample = VcQuantize(in[i], 8388608.0f);
+                    out[i * channels * 3]       = (uint8_t)sample;
+                    out[i * channels * 3 + 1]   = (uint8_t)(sample >> 8);
+                    out[i * channels * 3 + 2]   = (uint8_t)(sample >> 16);
+                }
+                break;
+            }
+        }
+    }
+}
+
+static int VcDecodeFail(VcDecodeJob *job, const char *message)
+{
+    if (job->pError == NULL)
+    {
+        job->pError = g_strdup(message);
+    }
+
+    return job->status = -1;
+}
+
+static int VcDecodeStream(VcDecodeJob *job, OggVorbis_File *vf, GOutputStream *out, VcDecodeFormat format, GError **error)
+{
+    static const uint16_t bits[] = { 16, 24, 32 };
+
+    int order[VC_MIX_MAX_CHANNELS];
+    uint32_t mask = VcWaveOrder(job->nChannels, order);
+    int64_t expected = ov_seekable(vf) ? ov_pcm_total(vf, -1) : 0;
+
+    VcWaveHeaderCommon common;
+    common.wFormatTag       = format == VC_DECODE_FLOAT32 ? VC_WAVE_FORMAT_IEEE_FLOAT : VC_WAVE_FORMAT_PCM;
+    common.nChannels        = (uint16_t)job->nChannels;
+    common.nSamplesPerSec   = (uint32_t)job->nRate;
+    common.wBitsPerSample   = bits[format];
+    common.nBlockAlign      = common.nChannels * common.wBitsPerSample / 8;
+    common.nAvgBytesPerSec  = common.nSamplesPerSec * common.nBlockAlign;
+
+    if (VcWaveWriteHeader(out, &common, mask, expected, error) < 0)
+    {
+        return -1;
+    }
+
+    int status = 0;
+    int bitstream = 0;
+    uint8_t *chunk = g_malloc((size_t)VC_DECODE_CHUNK_FRAMES * common.nBlockAlign);
+    while (status == 0)
+    {
+        float **pcm;
+        long frames = ov_read_float(vf, &pcm, VC_DECODE_CHUNK_FRAMES, &bitstream);
+        if (frames == 0)
+        {
+            break;
+        }
+
+        // vorbisfile resyncs after a hole, the gap just goes missing from the output
+        if (frames == OV_HOLE)
+        {
+            continue;
+        }
+
+        if (frames < 0)
+        {
+            status = VcDecodeFail(job, "Corrupt audio data");
+            break;
+        }
+
+        vorbis_info *info = ov_info(vf, bitstream);
+        if (info->channels != job->nChannels || info->rate != job->nRate)
+        {
+            status = VcDecodeFail(job, "Chained streams with different formats can't go into one WAV file");
+            break;
+        }
+
+        VcDecodeInterleave(pcm, order, job->nChannels, frames, format, chunk);
+        if (!g_output_stream_write_all(out, chunk, (size_t)frames * common.nBlockAlign, NULL, NULL, error))
+        {
+            status = -1;
+            break;
+        }
+
+        job->nFrames += frames;
+    }
+    g_free(chunk);
+
+    // Unseekable or damaged input, the sizes in the header are only known now
+    if (status == 0 && job->nFrames != expected)
+    {
+        GSeekable *seekable = G_SEEKABLE(out);
+        status = g_seekable_seek(seekable, 0, G_SEEK_SET, NULL, error)
+            && VcWaveWriteHeader(out, &common, mask, job->nFrames, error) == 0 ? 0 : -1;
+    }
+
+    return status;
+}
+
+int VcDecodeFile(VcDecodeJob *job, VcDecodeFormat format)
+{
+    OggVorbis_File vf;
+    if (ov_fopen(job->pInPath, &vf) < 0)
+    {
+        return VcDecodeFail(job, "Not an Ogg Vorbis file");
+    }
+
+    vorbis_info *info = ov_info(&vf, -1);
+    job->nChannels = info->channels;
+    job->nRate = info->rate;
+    job->nFrames = 0;
+    if (job->nChannels <= 0 || job->nChannels > VC_MIX_MAX_CHANNELS)
+    {
+        ov_clear(&vf);
+        return VcDecodeFail(job, "Unsupported number of channels");
+    }
+
+    // Written next to its destination and renamed into place, a failed decode leaves no partial file
+    GError *error = NULL;
+    VcAtomicOutput output;
+    GFile *file = g_file_new_for_path(job->pOutPath);
+    GFileOutputStream *fileStream = VcAtomicOutputOpen(&output, file, &error);
+    g_object_unref(file);
+
+    job->status = -1;
+    if (fileStream != NULL)
+    {
+        // Large writes instead of one per chunk, the buffer flushes on seek and close
+        GOutputStream *out = g_buffered_output_stream_new_sized(G_OUTPUT_STREAM(fileStream), VC_DECODE_WRITE_BUFFER);
+        job->status = VcDecodeStream(job, &vf, out, format, &error);
+
+        if (!g_output_stream_close(out, NULL, error == NULL ? &error : NULL))
+        {
+            job->status = -1;
+        }
+        g_object_unref(out);
+
+        if (job->status < 0)
+        {
+            VcAtomicOutputAbort(&output);
+        }
+        else if (VcAtomicOutputCommit(&output, &error) < 0)
+        {
+            job->status = -1;
+        }
+    }
+
+    if (error != NULL)
+    {
+        VcDecodeFail(job, error->message);
+        g_error_free(error);
+    }
+
+    ov_clear(&vf);
+    return job->status;
+}
+
+static void VcDecodeWorker(gpointer data, gpointer userData)
+{
+    VcDecodeOptions *options = (VcDecodeOptions *)userData;
+    VcDecodeFile((VcDecodeJob *)data, options->format);
+}
+
+gpointer VcDecodeBatchCallback(gpointer data)
+{
+    VcDecodeOptions *options = (VcDecodeOptions *)data;
+    guint count = options->jobs != NULL ? options->jobs->len : 0;
+    int threads = options->nThreads > 0 ? options->nThreads : (int)g_get_num_processors();
+
+    GThreadPool *pool = g_thread_pool_new(VcDecodeWorker, options, MAX(1, MIN(threads, (int)count)), false, NULL);
+    for (guint i = 0; i < count; i++)
+    {
+        g_thread_pool_push(pool, g_ptr_array_index(options->jobs, i), NULL);
+    }
+
+    // Waits for every queued file
+    g_thread_pool_free(pool, false, true);
+
+    g_main_context_invoke(NULL, options->cbOnFinished, options);
+    return NULL;
+}
+
+GThread *VcDecodeBatch(VcDecodeOptions *options)
+{
+    return g_thread_new("decoder", VcDecodeBatchCallback, options);
+}
@@ -0,0 +1,47 @@
+#ifndef VC_DECODING_H
+#define VC_DECODING_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <stdint.h>
+
+#define VC_DECODE_CHUNK_FRAMES      4096
+#define VC_DECODE_WRITE_BUFFER      (1 << 20)   // bytes gathered before each write to the output file
+
+typedef enum
+{
+    VC_DECODE_PCM16 = 0,
+    VC_DECODE_PCM24,
+    VC_DECODE_FLOAT32,
+
+} VcDecodeFormat;
+
+typedef struct
+{
+    gchar               *pInPath;
+    gchar               *pOutPath;
+    int                 status;
+    int64_t             nFrames;
+    long                nRate;
+    int                 nChannels;
+    gchar               *pError;            // why the file failed, if it did
+
+} VcDecodeJob;
+
+// A batch of Ogg Vorbis files decoded back to WAV, one file per core at a time
+typedef struct
+{
+    GtkTextView         *pLogView;
+    GSourceFunc         cbOnFinished;
+    VcDecodeFormat      format;
+    int                 nThreads;           // 0 uses every core
+    GPtrArray           *jobs;              // VcDecodeJob
+
+} VcDecodeOptions;
+
+gchar       *VcDecodeOutputPath(const char *inPath, const char *outDir);
+void        VcDecodeAddJob(VcDecodeOptions *options, const char *inPath, const char *outDir);
+int         VcDecodeFile(VcDecodeJob *job, VcDecodeFormat format);
+GThread     *VcDecodeBatch(VcDecodeOptions *options);
+void        VcDecodeJobsClear(VcDecodeOptions *options);
+
+#endif // VC_DECODING_H
@@ -0,0 +1,208 @@
+#include "channel-mix.h"
+#include <string.h>
+
+#define FL  VC_SPEAKER_FRONT_LEFT
+#define FR  VC_SPEAKER_FRONT_RIGHT
+#define FC  VC_SPEAKER_FRONT_CENTER
+#define LFE VC_SPEAKER_LOW_FREQUENCY
+#define BL  VC_SPEAKER_BACK_LEFT
+#define BR  VC_SPEAKER_BACK_RIGHT
+#define BC  VC_SPEAKER_BACK_CENTER
+#define SL  VC_SPEAKER_SIDE_LEFT
+#define SR  VC_SPEAKER_SIDE_RIGHT
+
+// Channel order the vorbis spec mandates for one to eight channels
+static const uint32_t vcVorbisOrder[VC_MIX_MAX_CHANNELS][VC_MIX_MAX_CHANNELS] =
+{
+    { FC },
+    { FL, FR },
+    { FL, FC, FR },
+    { FL, FR, BL, BR },
+    { FL, FC, FR, BL, BR },
+    { FL, FC, FR, BL, BR, LFE },
+    { FL, FC, FR, SL, SR, BC, LFE },
+    { FL, FC, FR, SL, SR, BL, BR, LFE },
+};
+
+// Stereo fold-down gains per speaker bit, surrounds at -3 dB and LFE dropped
+static const float vcStereoGains[VC_SPEAKER_COUNT][2] =
+{
+    { 1.0f,   0.0f   },     // front left
+    { 0.0f,   1.0f   },     // front right
+    { 0.707f, 0.707f },     // front center
+    { 0.0f,   0.0f   },     // low frequency
+    { 0.707f, 0.0f   },     // back left
+    { 0.0f,   0.707f },     // back right
+    { 1.0f,   0.0f   },     // front left of center
+    { 0.0f,   1.0f   },     // front right of center
+    { 0.5f,   0.5f   },     // back center
+    { 0.707f, 0.0f   },     // side left
+    { 0.0f,   0.707f },     // side right
+    { 0.5f,   0.5f   },     // top center
+    { 0.707f, 0.0f   },     // top front left
+    { 0.5f,   0.5f   },     // top front center
+    { 0.0f,   0.707f },     // top front right
+    { 0.707f, 0.0f   },     // top back left
+    { 0.5f,   0.5f   },     // top back center
+    { 0.0f,   0.707f },     // top back right
+};
+
+uint32_t VcDefaultChannelMask(int channels)
+{
+    static const uint32_t masks[VC_MIX_MAX_CHANNELS] = 
+    {
+        FC,
+        FL | FR,
+        FL | FR | FC,
+        FL | FR | BL | BR,
+        FL | FR | FC | BL | BR,
+        FL | FR | FC | LFE | BL | BR,
+        FL | FR | FC | LFE | BC | SL | SR,
+        FL | FR | FC | LFE | BL | BR | SL | SR,
+    };
+
+    return channels >= 1 && channels <= VC_MIX_MAX_CHANNELS ? masks[channels - 1] : 0;
+}
+
+// The other way round, for writing decoded vorbis out as WAV: source gets the vorbis channel
+// that goes in each WAV position, returns the channel mask describing them
+uint32_t VcWaveOrder(int channels, int *source)
+{
+    uint32_t mask = VcDefaultChannelMask(channels);
+    for (int ch = 0, bit = 0; ch < channels; bit++)
+    {
+        if (!(mask & (1u << bit)))
+        {
+            continue;
+        }
+
+        source[ch] = ch;
+        for (int in = 0; in < channels; in++)
+        {
+            if (vcVorbisOrder[channels - 1][in] == 1u << bit)
+            {
+                source[ch] = in;
+            }
+        }
+        ch++;
+    }
+
+    return mask;
+}
+
+// 5.1 and quad are as often tagged with side as with back speakers, vorbis only has one pair for them
+static int VcFindSpeaker(const uint32_t *speakers, int channels, uint32_t speaker)
+{
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int ch = 0; ch < channels; ch++)
+        {
+            if (speakers[ch] == speaker)
+            {
+                return ch;
+            }
+        }
+
+        speaker = speaker == BL ? SL : speaker == BR ? SR : speaker == SL ? BL : speaker == SR ? BR : speaker;
+    }
+
+    return -1;
+}
+
+static void VcChannelMixRoute(VcChannelMix *mix, int out, int in)
+{
+    mix->matrix[out][in] = 1.0f;
+    mix->source[out] = in;
+}
+
+int VcChannelMixInit(VcChannelMix *mix, int channels, uint32_t channelMask, VcMixLayout layout)
+{
+    uint32_t speakers[VC_MIX_MAX_CHANNELS];
+    memset(mix, 0, sizeof(VcChannelMix));
+    if (channels <= 0 || channels > VC_MIX_MAX_CHANNELS)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Unsupported number of channels: %d", channels);
+        return -1;
+    }
+
+    // A mask that doesn't name exactly one speaker per channel is no better than none
+    if (channelMask == 0 || __builtin_popcount(channelMask) != channels)
+    {
+        channelMask = VcDefaultChannelMask(channels);
+    }
+
+    for (int ch = 0, bit = 0; ch < channels; bit++)
+    {
+        if (channelMask & (1u << bit))
+        {
+            speakers[ch++] = 1u << bit;
+        }
+    }
+
+    mix->nInChannels = channels;
+    for (int ch = 0; ch < VC_MIX_MAX_CHANNELS; ch++)
+    {
+        mix->source[ch] = -1;
+    }
+
+    if (layout == VC_MIX_KEEP || (layout == VC_MIX_STEREO && channels == 2) || (layout == VC_MIX_MONO && channels == 1))
+    {
+        mix->nOutChannels = channels;
+        for (int out = 0; out < channels; out++)
+        {
+            int in = VcFindSpeaker(speakers, channels, vcVorbisOrder[channels - 1][out]);
+            if (in < 0)
+            {
+                // Layouts vorbis has no order for go through as they are
+                memset(mix->matrix, 0, sizeof(mix->matrix));
+                for (int ch = 0; ch < channels; ch++)
+                {
+                    VcChannelMixRoute(mix, ch, ch);
+                }
+                break;
+            }
+
+            VcChannelMixRoute(mix, out, in);
+        }
+
+        return 0;
+    }
+
+    if (channels == 1)
+    {
+        mix->nOutChannels = 2;
+        VcChannelMixRoute(mix, 0, 0);
+        VcChannelMixRoute(mix, 1, 0);
+        return 0;
+    }
+
+    // Fold down to stereo, each side is scaled back so a full scale input can't clip
+    for (int side = 0; side < 2; side++)
+    {
+        float sum = 0.0f;
+        for (int in = 0; in < channels; in++)
+        {
+            int bit = __builtin_ctz(speakers[in]);
+            mix->matrix[side][in] = bit < VC_SPEAKER_COUNT ? vcStereoGains[bit][side] : 0.0f;
+            sum += mix->matrix[side][in];
+        }
+
+        for (int in = 0; in < channels && sum > 1.0f; in++)
+        {
+            mix->matrix[side][in] /= sum;
+        }
+    }
+    mix->nOutChannels = 2;
+
+    if (layout == VC_MIX_MONO)
+    {
+        for (int in = 0; in < channels; in++)
+        {
+            mix->matrix[0][in] = (mix->matrix[0][in] + mix->matrix[1][in]) * 0.5f;
+            mix->matrix[1][in] = 0.0f;
+        }
+        mix->nOutChannels = 1;
+    }
+
+    return 0;
+}
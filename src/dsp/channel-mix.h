@@ -0,0 +1,46 @@
+#ifndef VC_CHANNEL_MIX_H
+#define VC_CHANNEL_MIX_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <stdint.h>
+
+#define VC_MIX_MAX_CHANNELS 8
+
+// WAVE_FORMAT_EXTENSIBLE speaker positions, channels are stored in the order of their bits
+#define VC_SPEAKER_FRONT_LEFT               0x1
+#define VC_SPEAKER_FRONT_RIGHT              0x2
+#define VC_SPEAKER_FRONT_CENTER             0x4
+#define VC_SPEAKER_LOW_FREQUENCY            0x8
+#define VC_SPEAKER_BACK_LEFT                0x10
+#define VC_SPEAKER_BACK_RIGHT               0x20
+#define VC_SPEAKER_FRONT_LEFT_OF_CENTER     0x40
+#define VC_SPEAKER_FRONT_RIGHT_OF_CENTER    0x80
+#define VC_SPEAKER_BACK_CENTER              0x100
+#define VC_SPEAKER_SIDE_LEFT                0x200
+#define VC_SPEAKER_SIDE_RIGHT               0x400
+#define VC_SPEAKER_COUNT                    18
+
+typedef enum
+{
+    VC_MIX_KEEP = 0,        // every channel, reordered to the vorbis layout
+    VC_MIX_STEREO,
+    VC_MIX_MONO,
+
+} VcMixLayout;
+
+// Matrix from interleaved input channels to planar output channels, applied by the WAV reader
+// as it converts. Rows that only route one input through unscaled are marked in source.
+typedef struct
+{
+    int                 nInChannels;
+    int                 nOutChannels;
+    float               matrix[VC_MIX_MAX_CHANNELS][VC_MIX_MAX_CHANNELS];
+    int                 source[VC_MIX_MAX_CHANNELS];
+
+} VcChannelMix;
+
+uint32_t    VcDefaultChannelMask(int channels);
+uint32_t    VcWaveOrder(int channels, int *source);
+int         VcChannelMixInit(VcChannelMix *mix, int channels, uint32_t channelMask, VcMixLayout layout);
+
+#endif // VC_CHANNEL_MIX_H
@@ -0,0 +1,89 @@
+#include "fft.h"
+#include <math.h>
+#include <string.h>
+
+int VcFftInit(VcFft *fft, int size)
+{
+    memset(fft, 0, sizeof(VcFft));
+    if (size < 2 || size > VC_FFT_MAX_SIZE || (size & (size - 1)) != 0)
+    {
+        return -1;
+    }
+
+    int bits = 0;
+    while ((1 << bits) < size)
+    {
+        bits++;
+    }
+
+    fft->nSize = size;
+    fft->pReverse = g_new(int, size);
+    for (int i = 0; i < size; i++)
+    {
+        int reversed = 0;
+        for (int b = 0; b < bits; b++)
+        {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        fft->pReverse[i] = reversed;
+    }
+
+    // Stage with half span h uses twiddles [h - 1, 2h - 1)
+    fft->pCos = g_new(float, size);
+    fft->pSin = g_new(float, size);
+    for (int half = 1; half < size; half <<= 1)
+    {
+        for (int k = 0; k < half; k++)
+        {
+            double angle = -M_PI * k / half;
+            fft->pCos[half - 1 + k] = (float)cos(angle);
+            fft->pSin[half - 1 + k] = (float)sin(angle);
+        }
+    }
+
+    return 0;
+}
+
+void VcFftForward(const VcFft *fft, float *re, float *im)
+{
+    int n = fft->nSize;
+    for (int i = 0; i < n; i++)
+    {
+        int j = fft->pReverse[i];
+        if (j > i)
+        {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for (int half = 1; half < n; half <<= 1)
+    {
+        const float *restrict wr = fft->pCos + half - 1;
+        const float *restrict wi = fft->pSin + half - 1;
+        for (int start = 0; start < n; start += half << 1)
+        {
+            float *restrict ar = re + start;
+            float *restrict ai = im + start;
+            float *restrict br = re + start + half;
+            float *restrict bi = im + start + half;
+            for (int k = 0; k < half; k++)
+            {
+                float tr = br[k] * wr[k] - bi[k] * wi[k];
+                float ti = br[k] * wi[k] + bi[k] * wr[k];
+                br[k] = ar[k] - tr;
+                bi[k] = ai[k] - ti;
+                ar[k] += tr;
+                ai[k] += ti;
+            }
+        }
+    }
+}
+
+void VcFftClear(VcFft *fft)
+{
+    g_free(fft->pReverse);
+    g_free(fft->pCos);
+    g_free(fft->pSin);
+    memset(fft, 0, sizeof(VcFft));
+}
@@ -0,0 +1,23 @@
+#ifndef VC_FFT_H
+#define VC_FFT_H
+
+#include <gtk-4.0/gtk/gtk.h>
+
+#define VC_FFT_MAX_SIZE 65536
+
+// In-place radix-2 complex FFT on split real / imaginary arrays. Twiddles are stored per
+// stage so every butterfly loop walks contiguous memory and vectorizes.
+typedef struct
+{
+    int                 nSize;
+    int                 *pReverse;          // bit reversed index of every bin
+    float               *pCos;              // nSize - 1 twiddles, stage after stage
+    float               *pSin;
+
+} VcFft;
+
+int     VcFftInit(VcFft *fft, int size);
+void    VcFftForward(const VcFft *fft, float *re, float *im);
+void    VcFftClear(VcFft *fft);
+
+#endif // VC_FFT_H
@@ -0,0 +1,243 @@
+#include "loudness.h"
+#include <math.h>
+#include <string.h>
+
+// BS.1770 channel weights for the vorbis layouts, surrounds count 1.41 and LFE is left out
+static const double vcLoudnessWeights[VC_MIX_MAX_CHANNELS][VC_MIX_MAX_CHANNELS] =
+{
+    { 1.0 },
+    { 1.0, 1.0 },
+    { 1.0, 1.0, 1.0 },
+    { 1.0, 1.0, 1.41, 1.41 },
+    { 1.0, 1.0, 1.0, 1.41, 1.41 },
+    { 1.0, 1.0, 1.0, 1.41, 1.41, 0.0 },
+    { 1.0, 1.0, 1.0, 1.41, 1.41, 1.0, 0.0 },
+    { 1.0, 1.0, 1.0, 1.41, 1.41, 1.0, 1.0, 0.0 },
+};
+
+// The K-weighting filters are specified at 48 kHz, these are their bilinear designs for any rate
+static void VcLoudnessDesign(VcLoudnessMeter *meter, long rate)
+{
+    double f0 = 1681.974450955533;
+    double gain = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = tan(M_PI * f0 / rate);
+    double vh = pow(10.0, gain / 20.0);
+    double vb = pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+
+    meter->shelf[0] = (vh + vb * k / q + k * k) / a0;
+    meter->shelf[1] = 2.0 * (k * k - vh) / a0;
+    meter->shelf[2] = (vh - vb * k / q + k * k) / a0;
+    meter->shelf[3] = 2.0 * (k * k - 1.0) / a0;
+    meter->shelf[4] = (1.0 - k / q + k * k) / a0;
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan(M_PI * f0 / rate);
+    a0 = 1.0 + k / q + k * k;
+
+    meter->highpass[0] = 1.0;
+    meter->highpass[1] = -2.0;
+    meter->highpass[2] = 1.0;
+    meter->highpass[3] = 2.0 * (k * k - 1.0) / a0;
+    meter->highpass[4] = (1.0 - k / q + k * k) / a0;
+}
+
+int VcLoudnessInit(VcLoudnessMeter *meter, int channels, long rate)
+{
+    memset(meter, 0, sizeof(VcLoudnessMeter));
+    if (channels <= 0 || channels > VC_MIX_MAX_CHANNELS || rate <= 0)
+    {
+        return -1;
+    }
+
+    if (VcResamplerInit(&meter->oversampler, channels, rate, rate * VC_LOUDNESS_OVERSAMPLING, VC_RESAMPLE_FAST, VC_LOUDNESS_CHUNK_FRAMES) < 0)
+    {
+        return -1;
+    }
+
+    meter->nChannels = channels;
+    memcpy(meter->weights, vcLoudnessWeights[channels - 1], sizeof(meter->weights));
+    VcLoudnessDesign(meter, rate);
+    meter->nSubBlockFrames = MAX(1, (rate + 5) / 10);
+    meter->blocks = g_array_new(false, false, sizeof(double));
+
+    long oversampled = VcResamplerMaxOutput(&meter->oversampler, VC_LOUDNESS_CHUNK_FRAMES);
+    meter->pOversampled = g_new(float *, channels);
+    for (int ch = 0; ch < channels; ch++)
+    {
+        meter->pOversampled[ch] = g_new(float, oversampled);
+    }
+
+    return 0;
+}
+
+static inline double VcBiquad(const double *c, double *z, double x)
+{
+    double y = c[0] * x + z[0];
+    z[0] = c[1] * x - c[3] * y + z[1];
+    z[1] = c[2] * x - c[4] * y;
+    return y;
+}
+
+static void VcLoudnessMeasure(VcLoudnessMeter *meter, float **pcm, long frames)
+{
+    for (long i = 0; i < frames; i++)
+    {
+        double energy = 0.0;
+        for (int ch = 0; ch < meter->nChannels; ch++)
+        {
+            float sample = pcm[ch][i];
+            meter->samplePeak = MAX(meter->samplePeak, fabsf(sample));
+            if (meter->weights[ch] == 0.0)
+            {
+                continue;
+            }
+
+            double y = VcBiquad(meter->highpass, meter->state[ch] + 2, VcBiquad(meter->shelf, meter->state[ch], sample));
+            energy += meter->weights[ch] * y * y;
+        }
+
+        meter->subBlockSum += energy;
+        if (++meter->nSubBlockFill < meter->nSubBlockFrames)
+        {
+            continue;
+        }
+
+        // A gating block is the last four sub-blocks, a new one starts every 100 ms
+        double subBlock = meter->subBlockSum / meter->nSubBlockFrames;
+        if (meter->nRecent == 3)
+        {
+            double block = (meter->recent[0] + meter->recent[1] + meter->recent[2] + subBlock) / 4.0;
+            g_array_append_val(meter->blocks, block);
+            meter->recent[0] = meter->recent[1];
+            meter->recent[1] = meter->recent[2];
+            meter->recent[2] = subBlock;
+        }
+
+        else
+        {
+            meter->recent[meter->nRecent++] = subBlock;
+        }
+
+        meter->subBlockSum = 0.0;
+        meter->nSubBlockFill = 0;
+    }
+}
+
+void VcLoudnessAdd(VcLoudnessMeter *meter, float **pcm, long frames)
+{
+    float *chunk[VC_MIX_MAX_CHANNELS];
+    for (long offset = 0; offset < frames; offset += VC_LOUDNESS_CHUNK_FRAMES)
+    {
+        long count = MIN(VC_LOUDNESS_CHUNK_FRAMES, frames - offset);
+        for (int ch = 0; ch < meter->nChannels; ch++)
+        {
+            chunk[ch] = pcm[ch] + offset;
+        }
+
+        VcLoudnessMeasure(meter, chunk, count);
+
+        // Inter-sample peaks show up once the signal is interpolated
+        long oversampled = VcResamplerProcess(&meter->oversampler, chunk, count, meter->pOversampled);
+        for (int ch = 0; ch < meter->nChannels; ch++)
+        {
+            for (long i = 0; i < oversampled; i++)
+            {
+                meter->truePeak = MAX(meter->truePeak, fabsf(meter->pOversampled[ch][i]));
+            }
+        }
+    }
+}
+
+static double VcBlockLoudness(double meanSquare)
+{
+    return -0.691 + 10.0 * log10(meanSquare);
+}
+
+void VcLoudnessGetResult(VcLoudnessMeter *meter, VcLoudnessResult *result)
+{
+    long oversampled = VcResamplerFlush(&meter->oversampler, meter->pOversampled);
+    for (int ch = 0; ch < meter->nChannels; ch++)
+    {
+        for (long i = 0; i < oversampled; i++)
+        {
+            meter->truePeak = MAX(meter->truePeak, fabsf(meter->pOversampled[ch][i]));
+        }
+    }
+
+    memset(result, 0, sizeof(VcLoudnessResult));
+    result->dSamplePeak = meter->samplePeak;
+    result->dTruePeak = MAX(meter->truePeak, meter->samplePeak);
+    result->dIntegrated = -70.0;
+
+    // Absolute gate at -70 LUFS, then a relative gate 10 LU under the loudness of what passed it
+    double *blocks = (double *)meter->blocks->data;
+    double sum = 0.0;
+    long count = 0;
+    for (guint i = 0; i < meter->blocks->len; i++)
+    {
+        if (blocks[i] > 0.0 && VcBlockLoudness(blocks[i]) > -70.0)
+        {
+            sum += blocks[i];
+            count++;
+        }
+    }
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    double relativeGate = VcBlockLoudness(sum / count) - 10.0;
+    double gatedSum = 0.0;
+    long gatedCount = 0;
+    for (guint i = 0; i < meter->blocks->len; i++)
+    {
+        if (blocks[i] > 0.0 && VcBlockLoudness(blocks[i]) > -70.0 && VcBlockLoudness(blocks[i]) > relativeGate)
+        {
+            gatedSum += blocks[i];
+            gatedCount++;
+        }
+    }
+
+    if (gatedCount > 0)
+    {
+        result->dIntegrated = VcBlockLoudness(gatedSum / gatedCount);
+        result->bValid = true;
+    }
+}
+
+void VcLoudnessClear(VcLoudnessMeter *meter)
+{
+    for (int ch = 0; ch < meter->nChannels && meter->pOversampled != NULL; ch++)
+    {
+        g_free(meter->pOversampled[ch]);
+    }
+
+    g_free(meter->pOversampled);
+    if (meter->blocks != NULL)
+    {
+        g_array_free(meter->blocks, true);
+    }
+
+    VcResamplerClear(&meter->oversampler);
+    memset(meter, 0, sizeof(VcLoudnessMeter));
+}
+
+// Every value is printed at a fixed width, so tags written before the measurement can be 
+// replaced by the real ones without changing the size of the comment header
+void VcLoudnessTag(const VcLoudnessResult *result, vorbis_comment *comment)
+{
+    char value[32];
+    double gain = result->bValid ? VC_REPLAYGAIN_REFERENCE - result->dIntegrated : 0.0;
+    double r128 = result->bValid ? (VC_R128_REFERENCE - result->dIntegrated) * 256.0 : 0.0;
+
+    g_snprintf(value, sizeof(value), "%+06.2f dB", CLAMP(gain, -99.99, 99.99));
+    vorbis_comment_add_tag(comment, "REPLAYGAIN_TRACK_GAIN", value);
+    g_snprintf(value, sizeof(value), "%.6f", CLAMP(result->dTruePeak, 0.0, 9.999999));
+    vorbis_comment_add_tag(comment, "REPLAYGAIN_TRACK_PEAK", value);
+    g_snprintf(value, sizeof(value), "%+06d", (int)CLAMP(lround(r128), -32768, 32767));
+    vorbis_comment_add_tag(comment, "R128_TRACK_GAIN", value);
+}
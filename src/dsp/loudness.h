@@ -0,0 +1,53 @@
+#ifndef VC_LOUDNESS_H
+#define VC_LOUDNESS_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <vorbis/codec.h>
+#include <stdbool.h>
+#include "resampler.h"
+#include "channel-mix.h"
+
+#define VC_LOUDNESS_CHUNK_FRAMES    1024
+#define VC_LOUDNESS_OVERSAMPLING    4       // true peak is measured at four times the sample rate
+#define VC_REPLAYGAIN_REFERENCE     -18.0   // LUFS
+#define VC_R128_REFERENCE           -23.0   // LUFS
+
+// EBU R128 / ITU-R BS.1770 meter fed block by block with planar frames in vorbis channel order
+typedef struct
+{
+    int                 nChannels;
+    double              weights[VC_MIX_MAX_CHANNELS];
+    double              shelf[5];           // K-weighting stage 1: b0 b1 b2 a1 a2
+    double              highpass[5];        // K-weighting stage 2
+    double              state[VC_MIX_MAX_CHANNELS][4];
+
+    long                nSubBlockFrames;    // 100 ms
+    long                nSubBlockFill;
+    double              subBlockSum;
+    double              recent[3];          // the sub-blocks before the current one
+    int                 nRecent;
+    GArray              *blocks;            // mean square of every 400 ms block, 75% overlapped
+
+    float               samplePeak;
+    float               truePeak;
+    VcResampler         oversampler;
+    float               **pOversampled;
+
+} VcLoudnessMeter;
+
+typedef struct
+{
+    bool                bValid;             // false when the input was shorter than one gating block
+    double              dIntegrated;        // LUFS
+    double              dSamplePeak;        // linear
+    double              dTruePeak;          // linear
+
+} VcLoudnessResult;
+
+int     VcLoudnessInit(VcLoudnessMeter *meter, int channels, long rate);
+void    VcLoudnessAdd(VcLoudnessMeter *meter, float **pcm, long frames);
+void    VcLoudnessGetResult(VcLoudnessMeter *meter, VcLoudnessResult *result);
+void    VcLoudnessClear(VcLoudnessMeter *meter);
+void    VcLoudnessTag(const VcLoudnessResult *result, vorbis_comment *comment);
+
+#endif // VC_LOUDNESS_H
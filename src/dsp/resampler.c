@@ -0,0 +1,211 @@
+#include "resampler.h"
+#include <math.h>
+#include <string.h>
+
+typedef struct
+{
+    int                 nTaps;              // at the input rate when upsampling
+    double              dBeta;              // kaiser window shape
+    double              dRolloff;           // passband edge relative to the lower nyquist
+
+} VcResampleProfile;
+
+static const VcResampleProfile vcResampleProfiles[] = 
+{
+    [VC_RESAMPLE_FAST]      = { 16, 6.0,  0.85  },
+    [VC_RESAMPLE_MEDIUM]    = { 32, 8.0,  0.91  },
+    [VC_RESAMPLE_BEST]      = { 64, 10.0, 0.945 },
+};
+
+static long VcGcd(long a, long b)
+{
+    while (b != 0)
+    {
+        long t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+// Zeroth order modified bessel function, the series converges quickly for the betas used here
+static double VcBesselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50 && term > sum * 1e-12; k++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+// Kaiser windowed sinc at the upsampled rate, split into phases. Each phase is stored reversed and
+// right aligned so it lines up with the input history in memory order, the padding stays zero.
+// The length is kept odd so the delay is a whole number of upsampled steps. Returns that delay.
+static int VcResamplerDesign(VcResampler *resampler, const VcResampleProfile *profile, int taps)
+{
+    int up = resampler->nUp;
+    int length = up * taps - (up * taps + 1) % 2;
+    double center = (length - 1) / 2.0;
+    double cutoff = profile->dRolloff * 0.5 / MAX(resampler->nUp, resampler->nDown);
+    double norm = VcBesselI0(profile->dBeta);
+
+    for (int m = 0; m < length; m++)
+    {
+        double x = m - center;
+        double r = x / (center + 1.0);
+        double window = VcBesselI0(profile->dBeta * sqrt(MAX(0.0, 1.0 - r * r))) / norm;
+        double sinc = x == 0.0 ? 1.0 : sin(2.0 * M_PI * cutoff * x) / (2.0 * M_PI * cutoff * x);
+
+        // The gain of up makes up for the zeros stuffed between input frames
+        int phase = m % up, tap = m / up;
+        resampler->pFilter[phase * resampler->nTaps + (resampler->nTaps - 1 - tap)] = (float)(2.0 * cutoff * sinc * window * up);
+    }
+
+    return (length - 1) / 2;
+}
+
+int VcResamplerInit(VcResampler *resampler, int channels, long inRate, long outRate, VcResampleQuality quality, int maxInputFrames)
+{
+    memset(resampler, 0, sizeof(VcResampler));
+    if (channels <= 0 || inRate <= 0 || outRate <= 0)
+    {
+        return -1;
+    }
+
+    long gcd = VcGcd(inRate, outRate);
+    resampler->nChannels = channels;
+    resampler->nInRate = inRate;
+    resampler->nOutRate = outRate;
+    resampler->nUp = (int)(outRate / gcd);
+    resampler->nDown = (int)(inRate / gcd);
+    if (resampler->nUp > VC_RESAMPLER_MAX_PHASES)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Can't resample from %ld to %ld Hz", inRate, outRate);
+        return -1;
+    }
+
+    // Downsampling narrows the passband, the filter gets longer by the same factor to keep its transition band
+    const VcResampleProfile *profile = &vcResampleProfiles[CLAMP(quality, VC_RESAMPLE_FAST, VC_RESAMPLE_BEST)];
+    int taps = (int)ceil(profile->nTaps * MAX(1.0, (double)resampler->nDown / resampler->nUp));
+    resampler->nTaps = (taps + VC_RESAMPLER_LANES - 1) / VC_RESAMPLER_LANES * VC_RESAMPLER_LANES;
+    resampler->pFilter = g_new0(float, (gsize)resampler->nUp * resampler->nTaps);
+    int delay = VcResamplerDesign(resampler, profile, taps);
+
+    // Starting with a full window of silence keeps the filter causal, nTime starts half a filter in to cancel its delay
+    resampler->nCapacity = resampler->nTaps - 1 + MAX(maxInputFrames, resampler->nTaps);
+    resampler->history = g_new(float *, channels);
+    for (int ch = 0; ch < channels; ch++)
+    {
+        resampler->history[ch] = g_new0(float, resampler->nCapacity);
+    }
+    resampler->nFilled = resampler->nTaps - 1;
+    resampler->nTime = (int64_t)(resampler->nTaps - 1) * resampler->nUp + delay;
+
+    return 0;
+}
+
+long VcResamplerMaxOutput(VcResampler *resampler, long inFrames)
+{
+    return (long)(((int64_t)inFrames * resampler->nUp + resampler->nDown - 1) / resampler->nDown) + 1;
+}
+
+// Independent partial sums per lane let the compiler keep them in one vector register
+static inline float VcDot(const float *restrict a, const float *restrict b, int n)
+{
+    float acc[VC_RESAMPLER_LANES] = { 0 };
+    for (int i = 0; i < n; i += VC_RESAMPLER_LANES)
+    {
+        for (int l = 0; l < VC_RESAMPLER_LANES; l++)
+        {
+            acc[l] += a[i + l] * b[i + l];
+        }
+    }
+
+    float sum = 0.0f;
+    for (int l = 0; l < VC_RESAMPLER_LANES; l++)
+    {
+        sum += acc[l];
+    }
+
+    return sum;
+}
+
+// in may hold at most the maxInputFrames given at init, out needs room for VcResamplerMaxOutput frames
+long VcResamplerProcess(VcResampler *resampler, float **in, long inFrames, float **out)
+{
+    int taps = resampler->nTaps;
+    for (int ch = 0; ch < resampler->nChannels; ch++)
+    {
+        memcpy(resampler->history[ch] + resampler->nFilled, in[ch], inFrames * sizeof(float));
+    }
+    resampler->nFilled += inFrames;
+    resampler->nFramesIn += inFrames;
+
+    long produced = 0;
+    while (resampler->nTime / resampler->nUp < resampler->nFilled)
+    {
+        int64_t index = resampler->nTime / resampler->nUp;
+        const float *phase = resampler->pFilter + (resampler->nTime % resampler->nUp) * taps;
+        for (int ch = 0; ch < resampler->nChannels; ch++)
+        {
+            out[ch][produced] = VcDot(phase, resampler->history[ch] + index - taps + 1, taps);
+        }
+
+        produced++;
+        resampler->nTime += resampler->nDown;
+    }
+
+    // Only the frames the next output still reaches back to are kept
+    int drop = (int)CLAMP(resampler->nTime / resampler->nUp - (taps - 1), 0, resampler->nFilled);
+    for (int ch = 0; ch < resampler->nChannels && drop > 0; ch++)
+    {
+        memmove(resampler->history[ch], resampler->history[ch] + drop, (resampler->nFilled - drop) * sizeof(float));
+    }
+    resampler->nFilled -= drop;
+    resampler->nTime -= (int64_t)drop * resampler->nUp;
+    resampler->nFramesOut += produced;
+
+    return produced;
+}
+
+// Pushes silence through to drain the filter delay, out needs room for VcResamplerMaxOutput(nTaps) frames
+long VcResamplerFlush(VcResampler *resampler, float **out)
+{
+    int64_t expected = (resampler->nFramesIn * resampler->nUp + resampler->nDown - 1) / resampler->nDown;
+    int64_t framesIn = resampler->nFramesIn;
+    int64_t framesOut = resampler->nFramesOut;
+
+    float **silence = g_new(float *, resampler->nChannels);
+    for (int ch = 0; ch < resampler->nChannels; ch++)
+    {
+        silence[ch] = g_new0(float, resampler->nTaps);
+    }
+
+    long produced = VcResamplerProcess(resampler, silence, resampler->nTaps, out);
+
+    for (int ch = 0; ch < resampler->nChannels; ch++)
+    {
+        g_free(silence[ch]);
+    }
+    g_free(silence);
+
+    resampler->nFramesIn = framesIn;
+    resampler->nFramesOut = MIN(resampler->nFramesOut, expected);
+    return (long)CLAMP(expected - framesOut, 0, produced);
+}
+
+void VcResamplerClear(VcResampler *resampler)
+{
+    for (int ch = 0; ch < resampler->nChannels && resampler->history != NULL; ch++)
+    {
+        g_free(resampler->history[ch]);
+    }
+
+    g_free(resampler->history);
+    g_free(resampler->pFilter);
+    memset(resampler, 0, sizeof(VcResampler));
+}
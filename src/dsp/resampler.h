@@ -0,0 +1,46 @@
+#ifndef VC_RESAMPLER_H
+#define VC_RESAMPLER_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <stdint.h>
+
+#define VC_RESAMPLER_MAX_PHASES 1024    // rate pairs needing more filter phases than this are refused
+#define VC_RESAMPLER_LANES      8       // taps are padded to a multiple of this so the dot product vectorizes
+
+typedef enum
+{
+    VC_RESAMPLE_FAST = 0,
+    VC_RESAMPLE_MEDIUM,
+    VC_RESAMPLE_BEST,
+
+} VcResampleQuality;
+
+// Streaming polyphase windowed-sinc resampler for planar float frames. The rate ratio is 
+// reduced to nUp / nDown, every output frame is one filter phase dotted with the latest input.
+typedef struct
+{
+    int                 nChannels;
+    long                nInRate;
+    long                nOutRate;
+    int                 nUp;
+    int                 nDown;
+    int                 nTaps;              // per phase
+    float               *pFilter;           // nUp phases of nTaps, stored reversed
+
+    float               **history;          // nTaps - 1 frames of context followed by unconsumed input
+    int                 nFilled;
+    int                 nCapacity;
+    int64_t             nTime;              // next output position in upsampled units, relative to history
+
+    int64_t             nFramesIn;
+    int64_t             nFramesOut;
+
+} VcResampler;
+
+int     VcResamplerInit(VcResampler *resampler, int channels, long inRate, long outRate, VcResampleQuality quality, int maxInputFrames);
+long    VcResamplerMaxOutput(VcResampler *resampler, long inFrames);
+long    VcResamplerProcess(VcResampler *resampler, float **in, long inFrames, float **out);
+long    VcResamplerFlush(VcResampler *resampler, float **out);
+void    VcResamplerClear(VcResampler *resampler);
+
+#endif // VC_RESAMPLER_H
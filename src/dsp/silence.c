@@ -0,0 +1,216 @@
+#include "silence.h"
+#include <math.h>
+#include <string.h>
+
+int VcSilenceTrimmerInit(VcSilenceTrimmer *trimmer, int channels, double thresholdDb, double minSeconds, long rate, bool trimLeading, bool trimTrailing)
+{
+    memset(trimmer, 0, sizeof(VcSilenceTrimmer));
+    if (channels <= 0 || channels > VC_MIX_MAX_CHANNELS)
+    {
+        return -1;
+    }
+
+    trimmer->nChannels = channels;
+    trimmer->fThreshold = (float)pow(10.0, thresholdDb / 20.0);
+    trimmer->nMinFrames = MAX(1, (uint64_t)(minSeconds * rate));
+    trimmer->bTrimLeading = trimLeading;
+    trimmer->bTrimTrailing = trimTrailing;
+    trimmer->nMaxHeld = MAX(trimmer->nMinFrames, VC_SILENCE_MAX_HELD_SAMPLES / channels);
+    trimmer->bDroppingLeading = false;
+    trimmer->spans = g_array_new(false, false, sizeof(VcSilentSpan));
+
+    return 0;
+}
+
+// One byte per frame, set when any channel is over the threshold. Each channel pass is a 
+// compare and or over contiguous floats, which the compiler vectorizes.
+static void VcSilenceMask(VcSilenceTrimmer *trimmer, float **pcm, long frames)
+{
+    if (frames > trimmer->nMaskCapacity)
+    {
+        trimmer->pMask = g_realloc(trimmer->pMask, frames);
+        trimmer->nMaskCapacity = frames;
+    }
+
+    uint8_t *restrict mask = trimmer->pMask;
+    float threshold = trimmer->fThreshold;
+    memset(mask, 0, frames);
+    for (int ch = 0; ch < trimmer->nChannels; ch++)
+    {
+        const float *restrict samples = pcm[ch];
+        for (long i = 0; i < frames; i++)
+        {
+            mask[i] |= fabsf(samples[i]) > threshold;
+        }
+    }
+}
+
+static int VcSilenceFlushHeld(VcSilenceTrimmer *trimmer, VcPcmSink sink, gpointer data)
+{
+    int status = trimmer->nHeld > 0 ? sink(data, trimmer->held, (long)trimmer->nHeld) : 0;
+    trimmer->nHeld = 0;
+    return status;
+}
+
+static int VcSilenceHold(VcSilenceTrimmer *trimmer, float **pcm, long frames, VcPcmSink sink, gpointer data)
+{
+    // Leading silence only has to be held until it's long enough to be dropped for good
+    if (trimmer->bDroppingLeading)
+    {
+        return 0;
+    }
+
+    if (!trimmer->bAudioSeen && trimmer->bTrimLeading && trimmer->nRunLength >= trimmer->nMinFrames)
+    {
+        trimmer->bDroppingLeading = true;
+        trimmer->nHeld = 0;
+        return 0;
+    }
+
+    // Past the limit the run is passed on, only the rest of it can still be trimmed off the end
+    if (trimmer->nHeld + frames > trimmer->nMaxHeld && VcSilenceFlushHeld(trimmer, sink, data) < 0)
+    {
+        return -1;
+    }
+
+    if (trimmer->nHeld + frames > trimmer->nHeldCapacity)
+    {
+        trimmer->nHeldCapacity = MAX(trimmer->nHeld + frames, trimmer->nHeldCapacity * 2);
+        for (int ch = 0; ch < trimmer->nChannels; ch++)
+        {
+            trimmer->held[ch] = g_renew(float, trimmer->held[ch], trimmer->nHeldCapacity);
+        }
+    }
+
+    for (int ch = 0; ch < trimmer->nChannels; ch++)
+    {
+        memcpy(trimmer->held[ch] + trimmer->nHeld, pcm[ch], frames * sizeof(float));
+    }
+    trimmer->nHeld += frames;
+
+    return 0;
+}
+
+// Closes the current run, trailing decides whether it reached the end of the stream
+static int VcSilenceEndRun(VcSilenceTrimmer *trimmer, bool trailing, VcPcmSink sink, gpointer data)
+{
+    if (trimmer->nRunLength == 0)
+    {
+        return 0;
+    }
+
+    bool leading = !trimmer->bAudioSeen;
+    bool trim = trimmer->nRunLength >= trimmer->nMinFrames && ((leading && trimmer->bTrimLeading) || (trailing && trimmer->bTrimTrailing));
+    if (trimmer->nRunLength >= trimmer->nMinFrames)
+    {
+        // A trailing run that outgrew the held limit was partly passed on already
+        uint64_t end = trimmer->nRunStart + trimmer->nRunLength;
+        uint64_t cut = !trim ? end : leading ? trimmer->nRunStart : end - trimmer->nHeld;
+        VcSilentSpan kept = { trimmer->nRunStart, cut, false };
+        VcSilentSpan trimmed = { cut, end, true };
+        if (cut > trimmer->nRunStart)
+        {
+            g_array_append_val(trimmer->spans, kept);
+        }
+
+        if (cut < end)
+        {
+            g_array_append_val(trimmer->spans, trimmed);
+        }
+    }
+
+    int status = 0;
+    if (trim)
+    {
+        trimmer->nHeld = 0;
+    }
+
+    else
+    {
+        status = VcSilenceFlushHeld(trimmer, sink, data);
+    }
+
+    trimmer->nRunLength = 0;
+    trimmer->bDroppingLeading = false;
+    return status;
+}
+
+int VcSilenceTrimmerProcess(VcSilenceTrimmer *trimmer, float **pcm, long frames, VcPcmSink sink, gpointer data)
+{
+    float *view[VC_MIX_MAX_CHANNELS];
+    VcSilenceMask(trimmer, pcm, frames);
+
+    long i = 0;
+    while (i < frames)
+    {
+        uint8_t loud = trimmer->pMask[i];
+        const uint8_t *next = memchr(trimmer->pMask + i, !loud, frames - i);
+        long end = next != NULL ? next - trimmer->pMask : frames;
+        for (int ch = 0; ch < trimmer->nChannels; ch++)
+        {
+            view[ch] = pcm[ch] + i;
+        }
+
+        int status;
+        if (loud)
+        {
+            status = VcSilenceEndRun(trimmer, false, sink, data);
+            trimmer->bAudioSeen = true;
+            status = status == 0 ? sink(data, view, end - i) : status;
+        }
+
+        else
+        {
+            if (trimmer->nRunLength == 0)
+            {
+                trimmer->nRunStart = trimmer->nPosition + i;
+            }
+
+            trimmer->nRunLength += end - i;
+            status = VcSilenceHold(trimmer, view, end - i, sink, data);
+        }
+
+        if (status < 0)
+        {
+            return -1;
+        }
+
+        i = end;
+    }
+
+    trimmer->nPosition += frames;
+    return 0;
+}
+
+int VcSilenceTrimmerFinish(VcSilenceTrimmer *trimmer, VcPcmSink sink, gpointer data)
+{
+    return VcSilenceEndRun(trimmer, true, sink, data);
+}
+
+uint64_t VcSilenceTrimmedFrames(VcSilenceTrimmer *trimmer)
+{
+    uint64_t trimmed = 0;
+    for (guint i = 0; i < trimmer->spans->len; i++)
+    {
+        VcSilentSpan *span = &g_array_index(trimmer->spans, VcSilentSpan, i);
+        trimmed += span->bTrimmed ? span->nEnd - span->nStart : 0;
+    }
+
+    return trimmed;
+}
+
+void VcSilenceTrimmerClear(VcSilenceTrimmer *trimmer)
+{
+    for (int ch = 0; ch < VC_MIX_MAX_CHANNELS; ch++)
+    {
+        g_free(trimmer->held[ch]);
+    }
+
+    g_free(trimmer->pMask);
+    if (trimmer->spans != NULL)
+    {
+        g_array_free(trimmer->spans, true);
+    }
+
+    memset(trimmer, 0, sizeof(VcSilenceTrimmer));
+}
@@ -0,0 +1,56 @@
+#ifndef VC_SILENCE_H
+#define VC_SILENCE_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "channel-mix.h"
+
+#define VC_SILENCE_MAX_HELD_SAMPLES (16 * 1024 * 1024)   // bounds the silence held back in case it turns out to be trailing
+
+// Receives the frames that survive trimming, returns -1 to stop
+typedef int (*VcPcmSink)(gpointer data, float **pcm, long frames);
+
+typedef struct
+{
+    uint64_t            nStart;             // frames from the start of the stream
+    uint64_t            nEnd;
+    bool                bTrimmed;
+
+} VcSilentSpan;
+
+// Finds runs where every channel stays at or under the threshold. Runs of at least the minimum
+// length are reported, and dropped when they lead or trail the stream and trimming is on for that end.
+typedef struct
+{
+    int                 nChannels;
+    float               fThreshold;         // linear
+    uint64_t            nMinFrames;
+    bool                bTrimLeading;
+    bool                bTrimTrailing;
+
+    uint64_t            nPosition;
+    bool                bAudioSeen;
+    uint64_t            nRunStart;
+    uint64_t            nRunLength;
+
+    // The part of the current run not passed on yet
+    float               *held[VC_MIX_MAX_CHANNELS];
+    uint64_t            nHeld;
+    uint64_t            nHeldCapacity;
+    uint64_t            nMaxHeld;
+    bool                bDroppingLeading;
+
+    uint8_t             *pMask;
+    long                nMaskCapacity;
+    GArray              *spans;             // VcSilentSpan
+
+} VcSilenceTrimmer;
+
+int     VcSilenceTrimmerInit(VcSilenceTrimmer *trimmer, int channels, double thresholdDb, double minSeconds, long rate, bool trimLeading, bool trimTrailing);
+int     VcSilenceTrimmerProcess(VcSilenceTrimmer *trimmer, float **pcm, long frames, VcPcmSink sink, gpointer data);
+int     VcSilenceTrimmerFinish(VcSilenceTrimmer *trimmer, VcPcmSink sink, gpointer data);
+uint64_t VcSilenceTrimmedFrames(VcSilenceTrimmer *trimmer);
+void    VcSilenceTrimmerClear(VcSilenceTrimmer *trimmer);
+
+#endif // VC_SILENCE_H
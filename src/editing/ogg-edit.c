@@ -0,0 +1,505 @@
+#include "ogg-edit.h"
+#include "../gui/log-view.h"
+#include <string.h>
+
+void VcOggPacketReaderInit(VcOggPacketReader *reader, GInputStream *in)
+{
+    memset(reader, 0, sizeof(VcOggPacketReader));
+    reader->in = in;
+    reader->nLastGranule = -1;
+    ogg_sync_init(&reader->sync);
+    vorbis_info_init(&reader->info);
+    vorbis_comment_init(&reader->comment);
+    g_queue_init(&reader->pending);
+    g_queue_init(&reader->ready);
+}
+
+void VcOggPacketFree(VcOggPacket *packet)
+{
+    if (packet != NULL)
+    {
+        g_free(packet->packet.packet);
+        g_free(packet);
+    }
+}
+
+static VcOggPacket *VcOggPacketCopy(const ogg_packet *source)
+{
+    VcOggPacket *packet = g_new0(VcOggPacket, 1);
+    packet->packet = *source;
+    packet->packet.packet = g_memdup2(source->packet, source->bytes);
+    return packet;
+}
+
+// Pending packets get their positions and move on to the ready queue. On the last page the granule
+// only trims the final packet, everywhere else it is where the last packet ends.
+static void VcOggReaderPlace(VcOggPacketReader *reader, int64_t granule, bool last)
+{
+    if (last)
+    {
+        int64_t end = MAX(reader->nLastGranule, 0);
+        for (GList *link = reader->pending.head; link != NULL; link = link->next)
+        {
+            VcOggPacket *packet = (VcOggPacket *)link->data;
+            end += packet->nSamples;
+            packet->nEnd = granule >= 0 ? MIN(end, granule) : end;
+        }
+    }
+
+    else
+    {
+        int64_t end = granule;
+        for (GList *link = reader->pending.tail; link != NULL; link = link->prev)
+        {
+            VcOggPacket *packet = (VcOggPacket *)link->data;
+            packet->nEnd = end;
+            end -= packet->nSamples;
+        }
+    }
+
+    VcOggPacket *packet;
+    while ((packet = g_queue_pop_head(&reader->pending)) != NULL)
+    {
+        g_queue_push_tail(&reader->ready, packet);
+        reader->nLastGranule = packet->nEnd;
+    }
+}
+
+// Reads one page of the stream, returns 0 at the end of the first logical stream
+static int VcOggReaderReadPage(VcOggPacketReader *reader, GError **error)
+{
+    ogg_page page;
+    while (ogg_sync_pageout(&reader->sync, &page) != 1)
+    {
+        char *buffer = ogg_sync_buffer(&reader->sync, VC_OGG_EDIT_READ_SIZE);
+        gssize read = g_input_stream_read(reader->in, buffer, VC_OGG_EDIT_READ_SIZE, NULL, error);
+        if (read <= 0)
+        {
+            return read < 0 ? -1 : 0;
+        }
+        ogg_sync_wrote(&reader->sync, (long)read);
+    }
+
+    if (!reader->bStreamReady)
+    {
+        if (!ogg_page_bos(&page))
+        {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Doesn't start with the first page of a stream");
+            return -1;
+        }
+
+        ogg_stream_init(&reader->stream, ogg_page_serialno(&page));
+        reader->bStreamReady = true;
+    }
+
+    // Pages of other streams are skipped, the next link of a chained file ends this one
+    else if (ogg_page_serialno(&page) != reader->stream.serialno)
+    {
+        return ogg_page_bos(&page) ? 0 : 1;
+    }
+
+    if (ogg_stream_pagein(&reader->stream, &page) < 0)
+    {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Corrupt page");
+        return -1;
+    }
+
+    ogg_packet source;
+    int result;
+    while ((result = ogg_stream_packetout(&reader->stream, &source)) != 0)
+    {
+        if (result < 0)
+        {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Pages are missing from the stream");
+            return -1;
+        }
+
+        VcOggPacket *packet = VcOggPacketCopy(&source);
+        if (reader->nHeaders < 3)
+        {
+            if (vorbis_synthesis_headerin(&reader->info, &reader->comment, &source) < 0)
+            {
+                g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Not an Ogg Vorbis stream");
+                VcOggPacketFree(packet);
+                return -1;
+            }
+
+            packet->bHeader = true;
+            reader->nHeaders++;
+            g_queue_push_tail(&reader->ready, packet);
+            continue;
+        }
+
+        long block = vorbis_packet_blocksize(&reader->info, &source);
+        if (block < 0)
+        {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Corrupt audio packet");
+            VcOggPacketFree(packet);
+            return -1;
+        }
+
+        // Each packet completes the overlap with the one before it
+        packet->nSamples = reader->nPreviousBlock > 0 ? (int)((reader->nPreviousBlock + block) / 4) : 0;
+        reader->nPreviousBlock = block;
+        g_queue_push_tail(&reader->pending, packet);
+    }
+
+    int64_t granule = ogg_page_granulepos(&page);
+    bool eos = ogg_page_eos(&page) != 0;
+    if (granule >= 0 && !g_queue_is_empty(&reader->pending))
+    {
+        VcOggReaderPlace(reader, granule, eos);
+    }
+
+    return eos ? 0 : 1;
+}
+
+// 1 with the next packet, 0 at the end of the stream
+int VcOggPacketReaderNext(VcOggPacketReader *reader, VcOggPacket **packet, GError **error)
+{
+    while (g_queue_is_empty(&reader->ready))
+    {
+        if (reader->bEnded)
+        {
+            return 0;
+        }
+
+        int status = VcOggReaderReadPage(reader, error);
+        if (status < 0)
+        {
+            return -1;
+        }
+
+        // A truncated file leaves packets no page ever placed
+        if (status == 0)
+        {
+            reader->bEnded = true;
+            VcOggReaderPlace(reader, -1, true);
+        }
+    }
+
+    *packet = g_queue_pop_head(&reader->ready);
+    return 1;
+}
+
+void VcOggPacketReaderClear(VcOggPacketReader *reader)
+{
+    g_queue_clear_full(&reader->pending, (GDestroyNotify)VcOggPacketFree);
+    g_queue_clear_full(&reader->ready, (GDestroyNotify)VcOggPacketFree);
+    if (reader->bStreamReady)
+    {
+        ogg_stream_clear(&reader->stream);
+    }
+    vorbis_comment_clear(&reader->comment);
+    vorbis_info_clear(&reader->info);
+    ogg_sync_clear(&reader->sync);
+}
+
+static int VcOggWritePage(GOutputStream *out, ogg_page *page, VcOggEditOptions *stats, GError **error)
+{
+    if (!g_output_stream_write_all(out, page->header, page->header_len, NULL, NULL, error)
+        || !g_output_stream_write_all(out, page->body, page->body_len, NULL, NULL, error))
+    {
+        return -1;
+    }
+
+    stats->nPages++;
+    stats->nBytes += page->header_len + page->body_len;
+    return 0;
+}
+
+static int VcOggWritePages(ogg_stream_state *stream, GOutputStream *out, bool flush, VcOggEditOptions *stats, GError **error)
+{
+    ogg_page page;
+    while (flush ? ogg_stream_flush(stream, &page) : ogg_stream_pageout(stream, &page))
+    {
+        if (VcOggWritePage(out, &page, stats, error) < 0)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// Copies the packets covering [start, end) into a new stream with the same serial, end < 0 keeps
+// up to the end. The packet before the range is kept to prime the decoder, the first page's granule
+// then makes decoders drop what comes before start and the final granule cuts the end sample exact.
+int VcOggCut(GInputStream *in, GOutputStream *out, int64_t start, int64_t end, VcOggEditOptions *stats, GError **error)
+{
+    VcOggPacketReader reader;
+    ogg_stream_state stream;
+    bool streamReady = false;
+    VcOggPacket *packet = NULL;
+    VcOggPacket *prime = NULL;
+    VcOggPacket *held = NULL;
+    bool done = false;
+    int headers = 0;
+    int status;
+
+    VcOggPacketReaderInit(&reader, in);
+    while (!done && (status = VcOggPacketReaderNext(&reader, &packet, error)) > 0)
+    {
+        if (!streamReady)
+        {
+            ogg_stream_init(&stream, reader.stream.serialno);
+            streamReady = true;
+        }
+
+        if (packet->bHeader)
+        {
+            packet->packet.granulepos = 0;
+            ogg_stream_packetin(&stream, &packet->packet);
+            VcOggPacketFree(packet);
+
+            // Audio has to start on a fresh page
+            if (++headers == 3 && VcOggWritePages(&stream, out, true, stats, error) < 0)
+            {
+                status = -1;
+                break;
+            }
+            continue;
+        }
+
+        if (held == NULL && packet->nEnd <= start)
+        {
+            VcOggPacketFree(prime);
+            prime = packet;
+            continue;
+        }
+
+        // Every packet goes out one behind, so the last one can still be marked
+        VcOggPacket *previous = held != NULL ? held : prime;
+        if (previous != NULL)
+        {
+            previous->packet.granulepos = MAX(previous->nEnd - start, 0);
+            previous->packet.e_o_s = 0;
+            ogg_stream_packetin(&stream, &previous->packet);
+            VcOggPacketFree(previous);
+            prime = NULL;
+
+            if (VcOggWritePages(&stream, out, false, stats, error) < 0)
+            {
+                held = packet;
+                status = -1;
+                break;
+            }
+        }
+
+        held = packet;
+        done = end >= 0 && packet->nEnd >= end;
+    }
+
+    if (status >= 0 && held == NULL)
+    {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Nothing to keep, the cut starts past the end");
+        status = -1;
+    }
+
+    if (status >= 0)
+    {
+        int64_t last = end >= 0 ? MIN(end, held->nEnd) : held->nEnd;
+        held->packet.granulepos = last - start;
+        held->packet.e_o_s = 1;
+        ogg_stream_packetin(&stream, &held->packet);
+        stats->nFrames = last - start;
+        stats->nRate = reader.info.rate;
+        status = VcOggWritePages(&stream, out, true, stats, error);
+    }
+
+    VcOggPacketFree(held);
+    VcOggPacketFree(prime);
+    if (streamReady)
+    {
+        ogg_stream_clear(&stream);
+    }
+    VcOggPacketReaderClear(&reader);
+
+    return status < 0 ? -1 : 0;
+}
+
+// Page by page copy of every input into one chained stream. Links whose serial is already taken
+// get a fresh one, written into the page header with its checksum redone.
+int VcOggJoin(GInputStream **inputs, int count, GOutputStream *out, VcOggEditOptions *stats, GError **error)
+{
+    GHashTable *used = g_hash_table_new(g_direct_hash, NULL);
+    int status = 0;
+
+    for (int i = 0; i < count && status == 0; i++)
+    {
+        GHashTable *links = g_hash_table_new(g_direct_hash, NULL);
+        ogg_sync_state sync;
+        ogg_page page;
+        ogg_sync_init(&sync);
+
+        while (status == 0)
+        {
+            if (ogg_sync_pageout(&sync, &page) != 1)
+            {
+                char *buffer = ogg_sync_buffer(&sync, VC_OGG_EDIT_READ_SIZE);
+                gssize read = g_input_stream_read(inputs[i], buffer, VC_OGG_EDIT_READ_SIZE, NULL, error);
+                if (read <= 0)
+                {
+                    status = read < 0 ? -1 : 0;
+                    break;
+                }
+                ogg_sync_wrote(&sync, (long)read);
+                continue;
+            }
+
+            guint serial = (guint)ogg_page_serialno(&page);
+            gpointer mapped;
+            if (!g_hash_table_lookup_extended(links, GUINT_TO_POINTER(serial), NULL, &mapped))
+            {
+                if (!ogg_page_bos(&page))
+                {
+                    g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Input %d doesn't start with the first page of a stream", i + 1);
+                    status = -1;
+                    break;
+                }
+
+                guint fresh = serial;
+                while (g_hash_table_contains(used, GUINT_TO_POINTER(fresh)))
+                {
+                    fresh = g_random_int();
+                }
+
+                mapped = GUINT_TO_POINTER(fresh);
+                g_hash_table_insert(used, mapped, NULL);
+                g_hash_table_insert(links, GUINT_TO_POINTER(serial), mapped);
+            }
+
+            guint outSerial = GPOINTER_TO_UINT(mapped);
+            if (outSerial != serial)
+            {
+                page.header[14] = (unsigned char)outSerial;
+                page.header[15] = (unsigned char)(outSerial >> 8);
+                page.header[16] = (unsigned char)(outSerial >> 16);
+                page.header[17] = (unsigned char)(outSerial >> 24);
+                ogg_page_checksum_set(&page);
+            }
+
+            status = VcOggWritePage(out, &page, stats, error);
+        }
+
+        ogg_sync_clear(&sync);
+        g_hash_table_destroy(links);
+    }
+
+    g_hash_table_destroy(used);
+    return status;
+}
+
+// The rate is needed to turn seconds into granules before cutting
+static long VcOggReadRate(GInputStream *in, GError **error)
+{
+    VcOggPacketReader reader;
+    VcOggPacket *packet;
+    VcOggPacketReaderInit(&reader, in);
+
+    long rate = VcOggPacketReaderNext(&reader, &packet, error) > 0 ? reader.info.rate : -1;
+    if (rate > 0)
+    {
+        VcOggPacketFree(packet);
+    }
+    VcOggPacketReaderClear(&reader);
+
+    if (rate > 0 && !g_seekable_seek(G_SEEKABLE(in), 0, G_SEEK_SET, NULL, error))
+    {
+        return -1;
+    }
+
+    return rate;
+}
+
+gpointer VcOggEditCallback(gpointer data)
+{
+    VcOggEditOptions *options = (VcOggEditOptions *)data;
+    int count = (int)options->inPaths->len;
+    GInputStream **inputs = g_new0(GInputStream *, count);
+    GError *error = NULL;
+
+    options->status = 0;
+    options->nPages = 0;
+    options->nBytes = 0;
+    for (int i = 0; i < count && options->status == 0; i++)
+    {
+        GFile *file = g_file_new_for_path(g_ptr_array_index(options->inPaths, i));
+        inputs[i] = G_INPUT_STREAM(g_file_read(file, NULL, &error));
+        options->status = inputs[i] != NULL ? 0 : -1;
+        g_object_unref(file);
+    }
+
+    GOutputStream *out = NULL;
+    if (options->status == 0)
+    {
+        GFile *file = g_file_new_for_path(options->pOutPath);
+        GFileOutputStream *fileStream = g_file_replace(file, NULL, false, G_FILE_CREATE_REPLACE_DESTINATION, NULL, &error);
+        g_object_unref(file);
+
+        if (fileStream != NULL)
+        {
+            out = g_buffered_output_stream_new_sized(G_OUTPUT_STREAM(fileStream), VC_OGG_EDIT_BUFFER);
+            g_object_unref(fileStream);
+        }
+        options->status = out != NULL ? 0 : -1;
+    }
+
+    if (options->status == 0 && options->mode == VC_OGG_CUT)
+    {
+        long rate = count == 1 ? VcOggReadRate(inputs[0], &error) : -1;
+        options->status = rate > 0
+            ? VcOggCut(inputs[0], out, (int64_t)(options->dStart * rate), options->dEnd > 0.0 ? (int64_t)(options->dEnd * rate) : -1, options, &error)
+            : -1;
+    }
+
+    else if (options->status == 0)
+    {
+        options->status = VcOggJoin(inputs, count, out, options, &error);
+    }
+
+    if (out != NULL)
+    {
+        if (!g_output_stream_close(out, NULL, error == NULL ? &error : NULL))
+        {
+            options->status = -1;
+        }
+        g_object_unref(out);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (inputs[i] != NULL)
+        {
+            g_object_unref(inputs[i]);
+        }
+    }
+    g_free(inputs);
+
+    if (error != NULL)
+    {
+        VcLogViewPostLine(options->pLogView, "%s", error->message);
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+    }
+
+    g_main_context_invoke(NULL, options->cbOnFinished, options);
+    return NULL;
+}
+
+GThread *VcOggEdit(VcOggEditOptions *options)
+{
+    return g_thread_new("ogg-edit", VcOggEditCallback, options);
+}
+
+void VcOggEditClear(VcOggEditOptions *options)
+{
+    if (options->inPaths != NULL)
+    {
+        g_ptr_array_unref(options->inPaths);
+        options->inPaths = NULL;
+    }
+
+    g_free(options->pOutPath);
+    options->pOutPath = NULL;
+}
@@ -0,0 +1,78 @@
+#ifndef VC_OGG_EDIT_H
+#define VC_OGG_EDIT_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <vorbis/codec.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define VC_OGG_EDIT_READ_SIZE   65536
+#define VC_OGG_EDIT_BUFFER      (1 << 20)   // bytes gathered before each write to the output file
+
+typedef enum
+{
+    VC_OGG_CUT = 0,
+    VC_OGG_JOIN,
+
+} VcOggEditMode;
+
+// A packet copied out of libogg with the sample range it decodes to
+typedef struct
+{
+    ogg_packet          packet;             // owns packet.packet
+    int64_t             nEnd;               // granule position after this packet
+    int                 nSamples;           // samples it adds once decoded, 0 for headers and the first audio packet
+    bool                bHeader;
+
+} VcOggPacket;
+
+// Packets of the first logical Vorbis stream in order, each placed on the sample timeline.
+// Positions come from the granule of the page a packet ends on, counted back over the block
+// sizes, except on the last page where the granule may cut the final packet short.
+typedef struct
+{
+    GInputStream        *in;
+    ogg_sync_state      sync;
+    ogg_stream_state    stream;
+    bool                bStreamReady;
+    vorbis_info         info;
+    vorbis_comment      comment;
+    int                 nHeaders;
+    long                nPreviousBlock;
+    int64_t             nLastGranule;       // -1 until the first audio page
+    GQueue              pending;            // packets waiting for their page to end
+    GQueue              ready;
+    bool                bEnded;
+
+} VcOggPacketReader;
+
+typedef struct
+{
+    VcOggEditMode       mode;
+    GPtrArray           *inPaths;           // gchar *, one file to cut or the files to join in order
+    gchar               *pOutPath;
+    double              dStart;             // seconds, cut only
+    double              dEnd;               // seconds, 0 keeps up to the end
+    GtkTextView         *pLogView;
+    GSourceFunc         cbOnFinished;
+
+    // results
+    int                 status;
+    uint64_t            nPages;
+    uint64_t            nBytes;
+    int64_t             nFrames;            // length of a cut
+    long                nRate;
+
+} VcOggEditOptions;
+
+void    VcOggPacketReaderInit(VcOggPacketReader *reader, GInputStream *in);
+int     VcOggPacketReaderNext(VcOggPacketReader *reader, VcOggPacket **packet, GError **error);
+void    VcOggPacketReaderClear(VcOggPacketReader *reader);
+void    VcOggPacketFree(VcOggPacket *packet);
+
+int     VcOggCut(GInputStream *in, GOutputStream *out, int64_t start, int64_t end, VcOggEditOptions *stats, GError **error);
+int     VcOggJoin(GInputStream **inputs, int count, GOutputStream *out, VcOggEditOptions *stats, GError **error);
+GThread *VcOggEdit(VcOggEditOptions *options);
+void    VcOggEditClear(VcOggEditOptions *options);
+
+#endif // VC_OGG_EDIT_H
@@ -0,0 +1,85 @@
+#include "atomic-output.h"
+#include <string.h>
+
+static void VcAtomicOutputClear(VcAtomicOutput *output)
+{
+    g_clear_object(&output->stream);
+    g_clear_object(&output->temp);
+    g_clear_object(&output->file);
+}
+
+// The temporary file sits in the same directory so the final rename never crosses file systems
+GFileOutputStream *VcAtomicOutputOpen(VcAtomicOutput *output, GFile *file, GError **error)
+{
+    memset(output, 0, sizeof(VcAtomicOutput));
+
+    GFile *parent = g_file_get_parent(file);
+    char *name = g_file_get_basename(file);
+    char *tempName = g_strdup_printf(".%s.%08x.part", name, g_random_int());
+    output->file = g_object_ref(file);
+    output->temp = g_file_get_child(parent, tempName);
+    output->stream = g_file_create(output->temp, G_FILE_CREATE_NONE, NULL, error);
+    g_free(tempName);
+    g_free(name);
+    g_object_unref(parent);
+
+    if (output->stream == NULL)
+    {
+        VcAtomicOutputClear(output);
+        return NULL;
+    }
+
+    return output->stream;
+}
+
+// Closes the stream and moves the finished file into place, the temporary file is removed on failure
+int VcAtomicOutputCommit(VcAtomicOutput *output, GError **error)
+{
+    if (output->stream == NULL)
+    {
+        return -1;
+    }
+
+    if (!g_output_stream_close(G_OUTPUT_STREAM(output->stream), NULL, error)
+        || !g_file_move(output->temp, output->file, G_FILE_COPY_OVERWRITE, NULL, NULL, NULL, error))
+    {
+        g_file_delete(output->temp, NULL, NULL);
+        VcAtomicOutputClear(output);
+        return -1;
+    }
+
+    VcAtomicOutputClear(output);
+    return 0;
+}
+
+void VcAtomicOutputAbort(VcAtomicOutput *output)
+{
+    if (output->stream != NULL)
+    {
+        g_output_stream_close(G_OUTPUT_STREAM(output->stream), NULL, NULL);
+        g_file_delete(output->temp, NULL, NULL);
+    }
+
+    VcAtomicOutputClear(output);
+}
+
+// Matches the names VcAtomicOutputOpen gives its temporary files, ".<name>.<8 hex digits>.part"
+bool VcAtomicOutputIsTemp(const char *name)
+{
+    size_t length = strlen(name);
+    const size_t suffix = strlen(".00000000.part");
+    if (name[0] != '.' || length <= suffix + 1 || !g_str_has_suffix(name, ".part") || name[length - suffix] != '.')
+    {
+        return false;
+    }
+
+    for (size_t i = length - suffix + 1; i < length - strlen(".part"); i++)
+    {
+        if (!g_ascii_isxdigit(name[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
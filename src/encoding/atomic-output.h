@@ -0,0 +1,22 @@
+#ifndef VC_ATOMIC_OUTPUT_H
+#define VC_ATOMIC_OUTPUT_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <stdbool.h>
+
+// An output file that only appears under its name once it is complete: everything goes to a
+// hidden temporary file next to it, which is renamed over the destination on commit
+typedef struct
+{
+    GFile               *file;
+    GFile               *temp;
+    GFileOutputStream   *stream;
+
+} VcAtomicOutput;
+
+GFileOutputStream   *VcAtomicOutputOpen(VcAtomicOutput *output, GFile *file, GError **error);
+int                 VcAtomicOutputCommit(VcAtomicOutput *output, GError **error);
+void                VcAtomicOutputAbort(VcAtomicOutput *output);
+bool                VcAtomicOutputIsTemp(const char *name);
+
+#endif // VC_ATOMIC_OUTPUT_H
@@ -0,0 +1,312 @@
+#include "auto-quality.h"
+#include "wave.h"
+#include "preview.h"
+#include "../dsp/silence.h"
+#include <string.h>
+
+typedef struct
+{
+    VcPcmClip           *clip;
+    uint64_t            nRangeFrames;       // the clip's share of the range, after trimming
+    uint64_t            nClipFrames;        // clip length before resampling, in the same units
+    VcEncoderTuning     tuning;
+    float               fQuality;
+    int                 status;
+    int64_t             nPredictedBytes;
+
+} VcQualityProbe;
+
+// Short segments spread evenly over the range stand in for the whole of it
+static int VcReadSampleClip(VcPcmClip *clip, GInputStream *stream, uint64_t startFrame, uint64_t endFrame, long rate, VcMixLayout layout)
+{
+    uint64_t segmentFrames = (uint64_t)rate * VC_AUTO_QUALITY_SEGMENT_SECONDS;
+    uint64_t rangeFrames = endFrame - startFrame;
+    memset(clip, 0, sizeof(VcPcmClip));
+
+    if (rangeFrames <= segmentFrames * VC_AUTO_QUALITY_SEGMENTS)
+    {
+        return VcPcmClipRead(clip, stream, startFrame, endFrame, layout, NULL);
+    }
+
+    uint64_t stride = (rangeFrames - segmentFrames) / (VC_AUTO_QUALITY_SEGMENTS - 1);
+    for (int i = 0; i < VC_AUTO_QUALITY_SEGMENTS; i++)
+    {
+        VcPcmClip part;
+        uint64_t segmentStart = startFrame + i * stride;
+        if (VcPcmClipRead(&part, stream, segmentStart, segmentStart + segmentFrames, layout, NULL) < 0)
+        {
+            VcPcmClipClear(clip);
+            return -1;
+        }
+
+        clip->nChannels = part.nChannels;
+        clip->nRate = part.nRate;
+        VcPcmClipAppend(clip, part.channels, part.nFrames);
+        VcPcmClipClear(&part);
+    }
+
+    return 0;
+}
+
+static int VcPcmClipSinkWrite(gpointer data, float **pcm, long frames)
+{
+    VcPcmClipAppend((VcPcmClip *)data, pcm, frames);
+    return 0;
+}
+
+static void VcPcmClipReplace(VcPcmClip *clip, VcPcmClip *with)
+{
+    VcPcmClipClear(clip);
+    *clip = *with;
+}
+
+// Leading and trailing silence of the range lie in the first and last segment, so trimming the
+// joined sample drops the same frames the encode will. Returns the frames trimmed or -1.
+static int64_t VcTrimClip(VcPcmClip *clip, VcAutoQualityOptions *options)
+{
+    VcSilenceTrimmer trimmer = { 0 };
+    VcPcmClip kept = { NULL, clip->nChannels, clip->nRate, 0 };
+    float *block[VC_MIX_MAX_CHANNELS];
+
+    int status = VcSilenceTrimmerInit(&trimmer, clip->nChannels, options->dSilenceThreshold, options->dMinSilence, 
+        clip->nRate, options->bTrimLeading, options->bTrimTrailing);
+    for (uint64_t offset = 0; status == 0 && offset < clip->nFrames; offset += VC_WAVE_BLOCK_FRAMES)
+    {
+        for (int ch = 0; ch < clip->nChannels; ch++)
+        {
+            block[ch] = clip->channels[ch] + offset;
+        }
+
+        status = VcSilenceTrimmerProcess(&trimmer, block, (long)MIN(VC_WAVE_BLOCK_FRAMES, clip->nFrames - offset), VcPcmClipSinkWrite, &kept);
+    }
+
+    if (status == 0)
+    {
+        status = VcSilenceTrimmerFinish(&trimmer, VcPcmClipSinkWrite, &kept);
+    }
+
+    int64_t trimmed = status == 0 ? (int64_t)VcSilenceTrimmedFrames(&trimmer) : -1;
+    VcSilenceTrimmerClear(&trimmer);
+    if (status == 0)
+    {
+        VcPcmClipReplace(clip, &kept);
+    }
+    else
+    {
+        VcPcmClipClear(&kept);
+    }
+
+    return trimmed;
+}
+
+static int VcResampleClip(VcPcmClip *clip, long rate, VcResampleQuality quality)
+{
+    VcResampler resampler = { 0 };
+    VcPcmClip resampled = { NULL, clip->nChannels, rate, 0 };
+    float *in[VC_MIX_MAX_CHANNELS], *out[VC_MIX_MAX_CHANNELS];
+
+    if (VcResamplerInit(&resampler, clip->nChannels, clip->nRate, rate, quality, VC_WAVE_BLOCK_FRAMES) < 0)
+    {
+        return -1;
+    }
+
+    long capacity = VcResamplerMaxOutput(&resampler, MAX(VC_WAVE_BLOCK_FRAMES, resampler.nTaps));
+    for (int ch = 0; ch < clip->nChannels; ch++)
+    {
+        out[ch] = g_new(float, capacity);
+    }
+
+    for (uint64_t offset = 0; offset < clip->nFrames; offset += VC_WAVE_BLOCK_FRAMES)
+    {
+        for (int ch = 0; ch < clip->nChannels; ch++)
+        {
+            in[ch] = clip->channels[ch] + offset;
+        }
+
+        long produced = VcResamplerProcess(&resampler, in, (long)MIN(VC_WAVE_BLOCK_FRAMES, clip->nFrames - offset), out);
+        VcPcmClipAppend(&resampled, out, produced);
+    }
+
+    VcPcmClipAppend(&resampled, out, VcResamplerFlush(&resampler, out));
+
+    for (int ch = 0; ch < clip->nChannels; ch++)
+    {
+        g_free(out[ch]);
+    }
+    VcResamplerClear(&resampler);
+    VcPcmClipReplace(clip, &resampled);
+
+    return 0;
+}
+
+// The sample goes through the stages between the reader and the encoder: the downmix already
+// happened as it was read, silence trimming and resampling follow here in the encode's order
+static int VcPrepareClip(VcPcmClip *clip, VcAutoQualityOptions *options, uint64_t *rangeFrames)
+{
+    if (options->bTrimLeading || options->bTrimTrailing)
+    {
+        int64_t trimmed = VcTrimClip(clip, options);
+        if (trimmed < 0)
+        {
+            return -1;
+        }
+
+        *rangeFrames -= MIN((uint64_t)trimmed, *rangeFrames);
+    }
+
+    return options->nOutputRate > 0 && options->nOutputRate != clip->nRate 
+        ? VcResampleClip(clip, options->nOutputRate, options->resampleQuality) 
+        : 0;
+}
+
+// Scales the audio bytes of the sample up to the full range, headers are only written once
+gpointer VcQualityProbeCallback(gpointer data)
+{
+    VcQualityProbe *probe = (VcQualityProbe *)data;
+    size_t bytes = 0, headerBytes = 0;
+
+    probe->tuning.fQuality = probe->fQuality;
+    probe->status = VcPcmClipEncode(probe->clip, &probe->tuning, NULL, &bytes, &headerBytes);
+    if (probe->status == 0 && probe->nClipFrames > 0)
+    {
+        double scale = (double)probe->nRangeFrames / probe->nClipFrames;
+        probe->nPredictedBytes = headerBytes + (int64_t)((bytes - headerBytes) * scale);
+    }
+
+    return NULL;
+}
+
+static int VcRunProbes(VcQualityProbe *probes, int count)
+{
+    GThread *workers[VC_AUTO_QUALITY_PROBES];
+    for (int i = 0; i < count; i++)
+    {
+        workers[i] = g_thread_new("quality-probe", VcQualityProbeCallback, &probes[i]);
+    }
+
+    int status = 0;
+    for (int i = 0; i < count; i++)
+    {
+        g_thread_join(workers[i]);
+        status = MIN(status, probes[i].status);
+    }
+
+    return status;
+}
+
+int VcAutoQualityCallback(VcAutoQualityOptions *options)
+{
+    VcWaveInfo info;
+    VcPcmClip clip;
+    VcQualityProbe probes[VC_AUTO_QUALITY_PROBES];
+
+    options->status = -1;
+    options->fQuality = -0.1f;
+    options->nPredictedBytes = 0;
+    options->bFits = false;
+    options->dSampledSeconds = 0.0;
+
+    GInputStream *stream = G_INPUT_STREAM(options->pInFileStream);
+    if (VcReadWaveInfo(stream, &info, NULL) < 0)
+    {
+        g_main_context_invoke(NULL, options->cbOnFinished, options);
+        return -1;
+    }
+
+    uint64_t totalFrames = VcWaveFrameCount(&info);
+    uint64_t endFrame = options->nEndFrame == 0 ? totalFrames : MIN(options->nEndFrame, totalFrames);
+    uint64_t startFrame = MIN(options->nStartFrame, endFrame);
+    double duration = (double)(endFrame - startFrame) / info.common.nSamplesPerSec;
+
+    int64_t target = options->nTargetBytes > 0 ? options->nTargetBytes : (int64_t)(options->dTargetBitrate * 1000.0 / 8.0 * duration);
+    if (target <= 0 || endFrame == startFrame || VcReadSampleClip(&clip, stream, startFrame, endFrame, info.common.nSamplesPerSec, options->mixLayout) < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't sample the input for the quality search");
+        g_main_context_invoke(NULL, options->cbOnFinished, options);
+        return -1;
+    }
+
+    // Trimming is counted at the input rate, the same units as the range
+    uint64_t rangeFrames = endFrame - startFrame;
+    if (VcPrepareClip(&clip, options, &rangeFrames) < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't prepare the sample for the quality search");
+        VcPcmClipClear(&clip);
+        g_main_context_invoke(NULL, options->cbOnFinished, options);
+        return -1;
+    }
+    double sampledSeconds = (double)clip.nFrames / clip.nRate;
+    uint64_t clipFrames = (uint64_t)(sampledSeconds * info.common.nSamplesPerSec + 0.5);
+
+    // Output size grows with quality, so every round narrows the bracket around the target.
+    // The first round covers the whole scale including its ends, later ones only the inside.
+    float lo = -0.1f, hi = 1.0f;
+    for (int round = 0; round < VC_AUTO_QUALITY_ROUNDS; round++)
+    {
+        for (int i = 0; i < VC_AUTO_QUALITY_PROBES; i++)
+        {
+            probes[i].clip = &clip;
+            probes[i].nRangeFrames = rangeFrames;
+            probes[i].nClipFrames = clipFrames;
+            probes[i].tuning = options->tuning;
+            probes[i].tuning.mode = VC_RATE_VBR;
+            probes[i].fQuality = round == 0
+                ? lo + (hi - lo) * i / (VC_AUTO_QUALITY_PROBES - 1)
+                : lo + (hi - lo) * (i + 1) / (VC_AUTO_QUALITY_PROBES + 1);
+            probes[i].nPredictedBytes = 0;
+        }
+
+        if (VcRunProbes(probes, VC_AUTO_QUALITY_PROBES) < 0)
+        {
+            VcPcmClipClear(&clip);
+            g_main_context_invoke(NULL, options->cbOnFinished, options);
+            return -1;
+        }
+
+        int best = -1;
+        for (int i = 0; i < VC_AUTO_QUALITY_PROBES && probes[i].nPredictedBytes <= target; i++)
+        {
+            best = i;
+        }
+
+        if (round == 0 && best < 0)
+        {
+            options->nPredictedBytes = probes[0].nPredictedBytes;
+            break;
+        }
+
+        if (best >= 0)
+        {
+            options->fQuality = probes[best].fQuality;
+            options->nPredictedBytes = probes[best].nPredictedBytes;
+            options->bFits = true;
+        }
+
+        if (best == VC_AUTO_QUALITY_PROBES - 1 && round == 0)
+        {
+            break;
+        }
+
+        if (best >= 0)
+        {
+            lo = probes[best].fQuality;
+        }
+
+        if (best + 1 < VC_AUTO_QUALITY_PROBES)
+        {
+            hi = probes[best + 1].fQuality;
+        }
+    }
+
+    options->dSampledSeconds = sampledSeconds;
+    VcPcmClipClear(&clip);
+    options->status = 0;
+    g_main_context_invoke(NULL, options->cbOnFinished, options);
+
+    return 0;
+}
+
+GThread *VcSearchQuality(VcAutoQualityOptions *options)
+{
+    return g_thread_new("quality-search", VcAutoQualityCallback, options);
+}
@@ -0,0 +1,46 @@
+#ifndef VC_AUTO_QUALITY_H
+#define VC_AUTO_QUALITY_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "vorbis-encoder.h"
+#include "../dsp/resampler.h"
+#include "../dsp/channel-mix.h"
+
+#define VC_AUTO_QUALITY_SEGMENTS        8       // excerpts sampled across the range
+#define VC_AUTO_QUALITY_SEGMENT_SECONDS 4
+#define VC_AUTO_QUALITY_PROBES          6       // trial encodes run in parallel per round
+#define VC_AUTO_QUALITY_ROUNDS          3
+
+typedef struct 
+{
+    GFileInputStream    *pInFileStream;
+    GSourceFunc         cbOnFinished;
+    uint64_t            nStartFrame;
+    uint64_t            nEndFrame;          // 0 searches up to the end of the file
+    int64_t             nTargetBytes;       // size limit of the output
+    double              dTargetBitrate;     // kbit/s, only used when nTargetBytes is 0
+
+    // The encode's own settings, the sample goes through the same stages before it is probed
+    VcEncoderTuning     tuning;             // quality is what's searched for, the other knobs apply as they are
+    long                nOutputRate;
+    VcResampleQuality   resampleQuality;
+    VcMixLayout         mixLayout;
+    bool                bTrimLeading;
+    bool                bTrimTrailing;
+    double              dSilenceThreshold;
+    double              dMinSilence;
+
+    // Results
+    int                 status;
+    float               fQuality;           // highest quality predicted to fit, -0.1 if none does
+    int64_t             nPredictedBytes;
+    bool                bFits;
+    double              dSampledSeconds;
+
+} VcAutoQualityOptions;
+
+GThread     *VcSearchQuality(VcAutoQualityOptions *options);
+
+#endif // VC_AUTO_QUALITY_H
@@ -1,469 +1,563 @@
 #include "encoding.h"
+#include "wave.h"
+#include "vorbis-encoder.h"
+#include "verify.h"
+#include "integrity.h"
+#include "segments.h"
+#include "live.h"
+#include "../dsp/resampler.h"
+#include "../dsp/loudness.h"
+#include "../dsp/silence.h"
 #include "../gui/log-view.h"
 #include <stdio.h>
-#include <vorbis/codec.h>
-#include <vorbis/vorbisenc.h>
 #include <string.h>
-#include <time.h>
+#include <math.h>
 
-typedef enum
+static GThread *encoderThread = NULL;
+
+void VcEncoderFinalize(VcEncodeOptions *options)
 {
-    VC_WAVE_FORMAT_PCM          = 1,
-    VC_WAVE_FORMAT_IEEE_FLOAT   = 3,
-    VC_WAVE_FORMAT_ALAW         = 6,
-    VC_WAVE_FORMAT_MULAW        = 7,
-    VC_WAVE_FORMAT_EXTENSIBLE   = 0xfffe
+    g_input_stream_close(G_INPUT_STREAM(options->pInFileStream), NULL, NULL);
 
-} VcWaveFormat;
+    if (options->pOggBuffer != NULL)
+    {
+        VcOggBufferFinish(options->pOggBuffer);
+    }
 
-typedef struct
-{
-    uint16_t    wFormatTag;
-    uint8_t     padding[14];
+    // Callers running the encode on their own thread leave it unset
+    if (options->cbOnFinished != NULL)
+    {
+        g_main_context_invoke(NULL, options->cbOnFinished, options);
+    }
+}
 
-} VcWaveSubFormat;
+GThread *VcGetEncoderThread() 
+{ 
+    return encoderThread; 
+}
 
+// Where converted blocks go once they leave the reader, through the resampler if one is set
 typedef struct
 {
-    uint16_t        wFormatTag;
-	uint16_t        nChannels; 	
-	uint32_t        nSamplesPerSec;
-	uint32_t        nAvgBytesPerSec;
-	uint16_t        nBlockAlign;
-	uint16_t        wBitsPerSample;
+    VcVorbisEncoder     *encoder;
+    VcResampler         *resampler;
+    VcLoudnessMeter     *meter;
+    VcVerifier          *verifier;
+    GError              **error;
+    gint                *pAbort;
 
-} VcWaveHeaderCommon;
+} VcEncodeSink;
 
-typedef struct 
+// Checked once per block read, so giving up takes at most one block
+static bool VcEncodeAborted(VcEncodeSink *sink, GError **error)
 {
-    // Input and output files
-    GFileInputStream    *pInfile;
-    GFileOutputStream   *pOutfile;
-    
-    // Input file data
-    uint32_t            nDataSize;
-    VcWaveHeaderCommon  common;
-
-    // Ogg vorbis structures
-    vorbis_info         vi;
-    vorbis_dsp_state    dsp;
-    vorbis_comment      comment;
-    vorbis_block        block;
-    ogg_stream_state    stream;
-    ogg_packet          packet;
-    ogg_page            page;
-
-} VcEncodingContext;
-
-static VcEncodingContext vcCtx = { 0 };
-static uint8_t vcReadBuffer[VC_BUFFER_SIZE];
-static GThread *encoderThread = NULL;
+    if (sink->pAbort == NULL || !g_atomic_int_get(sink->pAbort))
+    {
+        return false;
+    }
 
-int VcReadHeader(GtkTextView *logView)
+    g_set_error(error, G_IO_ERROR, G_IO_ERROR_CANCELLED, "Encoding was stopped");
+    return true;
+}
+
+// Blocks about to be analysed are measured and handed to the verifier first
+static void VcEncodeSinkObserve(VcEncodeSink *sink, float **pcm, long frames)
 {
-    VcLogViewWriteLine(logView, "Reading header...");
+    if (sink->meter != NULL)
+    {
+        VcLoudnessAdd(sink->meter, pcm, frames);
+    }
 
-    GError *error = NULL;
-    size_t nBytes;
-    g_seekable_seek(G_SEEKABLE(vcCtx.pInfile), 20, G_SEEK_SET, NULL, &error);
-    if (error != NULL)
+    if (sink->verifier != NULL)
     {
-        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
-        VcLogViewWriteLine(logView, error->message);
-        return -1;
+        VcVerifierPush(sink->verifier, pcm, frames);
     }
+}
 
-    nBytes = g_input_stream_read(G_INPUT_STREAM(vcCtx.pInfile), &vcCtx.common, 16, NULL, &error);
-    if (error != NULL || nBytes < 16)
+// Converts the reader's frames straight into the encoder's analysis buffer until the end of the range
+static int VcEncodeStream(VcWaveReader *reader, VcEncodeSink *sink, GError **error)
+{
+    while (true)
     {
-        if (error)
+        float **buffer = VcVorbisEncoderBuffer(sink->encoder, VC_WAVE_BLOCK_FRAMES);
+        long frames = VcWaveReaderRead(reader, buffer, VC_WAVE_BLOCK_FRAMES, error);
+        if (frames < 0 || VcEncodeAborted(sink, error))
         {
-            g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
-            VcLogViewWriteLine(logView, error->message);
+            return -1;
         }
 
-        else
-        {
-            g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Failed to read header");
-            VcLogViewWriteLine(logView, "Failed to read header");
-        }
-        
-        
-        return -1;
-    }
+        VcEncodeSinkObserve(sink, buffer, frames);
 
-    if (vcCtx.common.wFormatTag == VC_WAVE_FORMAT_EXTENSIBLE)
-    {
-        g_seekable_seek(G_SEEKABLE(vcCtx.pInfile), 8, G_SEEK_CUR, NULL, &error);
-        VcWaveSubFormat subFormat;
-        nBytes = g_input_stream_read(G_INPUT_STREAM(vcCtx.pInfile), &subFormat, 16, NULL, &error);
-        if (error != NULL)
+        if (VcVorbisEncoderWrote(sink->encoder, frames, error) < 0)
         {
-            g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
-            VcLogViewWriteLine(logView, error->message);
             return -1;
         }
 
-        vcCtx.common.wFormatTag = subFormat.wFormatTag;
-    }
-    
-    else if (vcCtx.common.wFormatTag == VC_WAVE_FORMAT_PCM)
-    {
-        g_seekable_seek(G_SEEKABLE(vcCtx.pInfile), 40, G_SEEK_SET, NULL, &error);
+        if (frames == 0)
+        {
+            return 0;
+        }
     }
+}
 
-    else
+// Takes at most VC_WAVE_BLOCK_FRAMES, 0 frames drains the resampler
+static int VcEncodeSinkSubmit(VcEncodeSink *sink, float **pcm, long frames)
+{
+    float **buffer;
+    long produced;
+    if (sink->resampler != NULL)
     {
-        VcLogViewWriteLine(logView, "Format not recognized");
-        return -1;
-        
+        buffer = VcVorbisEncoderBuffer(sink->encoder, VcResamplerMaxOutput(sink->resampler, MAX(frames, sink->resampler->nTaps)));
+        produced = frames > 0 
+            ? VcResamplerProcess(sink->resampler, pcm, frames, buffer) 
+            : VcResamplerFlush(sink->resampler, buffer);
     }
-    
-    
-    if (error != NULL)
+
+    else if (frames == 0)
     {
-        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
-        VcLogViewWriteLine(logView, error->message);
-        return -1;
+        return 0;
     }
 
-    nBytes = g_input_stream_read(G_INPUT_STREAM(vcCtx.pInfile), &vcCtx.nDataSize, 4, NULL, &error);
-    if (nBytes < 4)
+    else
     {
-        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
-        VcLogViewWriteLine(logView, error->message);
-        return -1;
+        buffer = VcVorbisEncoderBuffer(sink->encoder, frames);
+        for (int ch = 0; ch < sink->encoder->vi.channels; ch++)
+        {
+            memcpy(buffer[ch], pcm[ch], frames * sizeof(float));
+        }
+        produced = frames;
     }
 
-    VcLogViewWriteLine(logView, "Header processed:");
-    VcLogViewWriteLine(logView, "Number of channels: %d", vcCtx.common.nChannels);
-    VcLogViewWriteLine(logView, "Bits per sample: %d", vcCtx.common.wBitsPerSample);
-    VcLogViewWriteLine(logView, "Sample rate: %d", vcCtx.common.nSamplesPerSec);
+    VcEncodeSinkObserve(sink, buffer, produced);
 
-    return 0;
+    // Zero frames would end the stream early
+    return produced > 0 ? VcVorbisEncoderWrote(sink->encoder, produced, sink->error) : 0;
 }
 
-void VcWriteBufferPCM(size_t n_bytes)
+static int VcEncodeSinkWrite(gpointer data, float **pcm, long frames)
 {
-    float **channels = vorbis_analysis_buffer(&vcCtx.dsp, VC_BUFFER_SIZE);
-    uint16_t bytesPerSample = vcCtx.common.wBitsPerSample / 8;
-    uint16_t stride = bytesPerSample * vcCtx.common.nChannels;
-    for(size_t i = 0; i < n_bytes / stride; i++)
+    VcEncodeSink *sink = (VcEncodeSink *)data;
+    float *chunk[VC_MIX_MAX_CHANNELS];
+    for (long offset = 0; offset < frames; offset += VC_WAVE_BLOCK_FRAMES)
     {
-        for (size_t ch = 0; ch < vcCtx.common.nChannels; ch++)
+        for (int ch = 0; ch < sink->encoder->vi.channels; ch++)
         {
-            switch (bytesPerSample)
-            {
-                case 1:
-                {
-                    uint8_t sample = (uint8_t) (vcReadBuffer[i * stride + ch]);
-                    channels[ch][i] = sample / 256.0f;
-                    break;
-                }
-
-                case 2:
-                {
-                    uint16_t sample = (((uint16_t) vcReadBuffer[i * stride + ch * bytesPerSample]) 
-                    | ((uint16_t) vcReadBuffer[i * stride + ch * bytesPerSample + 1] << 8));
-                    channels[ch][i] = ((int16_t) sample) / 32768.0f;
-                    break;
-                }
-
-                case 3:
-                {
-                    uint32_t sample = (((uint32_t) vcReadBuffer[i * stride + ch * bytesPerSample]) 
-                    | ((uint32_t) vcReadBuffer[i * stride + ch * bytesPerSample + 1] << 8)
-                    | ((uint32_t) vcReadBuffer[i * stride + ch * bytesPerSample + 2] << 16));
-                    sample &= 0x00ffffff;
-                    sample |= 0xff000000 * ((sample & 0x00800000) != 0);  // checks if 24th bit is 1 and ors highest byte with 0xff if true
-                    channels[ch][i] = ((int32_t) sample) / 8388608.0f;
-                    break;
-                }
-
-                case 4:
-                {
-                    uint32_t sample = (((uint32_t) vcReadBuffer[i * stride + ch * bytesPerSample]) 
-                    | ((uint32_t) vcReadBuffer[i * stride + ch * bytesPerSample + 1] << 8)
-                    | ((uint32_t) vcReadBuffer[i * stride + ch * bytesPerSample + 2] << 16)
-                    | ((uint32_t) vcReadBuffer[i * stride + ch * bytesPerSample + 3] << 24));
-                    channels[ch][i] = ((int32_t) sample) / 2147483648.0;
-                    break;
-                }
-
-                default: break;
-            }
-            
+            chunk[ch] = pcm[ch] + offset;
+        }
+
+        if (VcEncodeSinkSubmit(sink, chunk, MIN(VC_WAVE_BLOCK_FRAMES, frames - offset)) < 0)
+        {
+            return -1;
         }
-        
     }
-    vorbis_analysis_wrote(&vcCtx.dsp, n_bytes / stride);
+
+    return 0;
 }
 
-void VcWriteBufferFloat(size_t n_bytes)
+// The general path when blocks can't go straight into the analysis buffer: silence 
+// trimming and resampling both sit between the reader and the encoder
+static int VcEncodePipeline(VcWaveReader *reader, VcSilenceTrimmer *trimmer, VcEncodeSink *sink, GError **error)
 {
-    float **channels = vorbis_analysis_buffer(&vcCtx.dsp, VC_BUFFER_SIZE);
-    uint16_t bytesPerSample = vcCtx.common.wBitsPerSample / 8;
-    uint16_t stride = bytesPerSample * vcCtx.common.nChannels;
+    int status = 0;
+    float **block = g_new(float *, reader->nChannels);
+    for (int ch = 0; ch < reader->nChannels; ch++)
+    {
+        block[ch] = g_new(float, VC_WAVE_BLOCK_FRAMES);
+    }
 
-    for(size_t i = 0; i < n_bytes / stride; i++)
+    while (status == 0)
     {
-        for (size_t ch = 0; ch < vcCtx.common.nChannels; ch++)
+        long frames = VcWaveReaderRead(reader, block, VC_WAVE_BLOCK_FRAMES, error);
+        if (frames < 0 || VcEncodeAborted(sink, error))
         {
-            if (bytesPerSample == 4)
-            {
-                float sample = ((float) vcReadBuffer[i * stride + ch * bytesPerSample]);
-                channels[ch][i] = sample;
-            }
-
-            else if (bytesPerSample == 8)
-            {
-                double sample = ((double) vcReadBuffer[i * stride + ch * bytesPerSample]);
-                channels[ch][i] = sample;
-            }
-            
-            
-             
+            status = -1;
+            break;
         }
+
+        if (frames == 0)
+        {
+            break;
+        }
+
+        status = trimmer != NULL 
+            ? VcSilenceTrimmerProcess(trimmer, block, frames, VcEncodeSinkWrite, sink)
+            : VcEncodeSinkWrite(sink, block, frames);
     }
 
-}
+    if (status == 0 && trimmer != NULL)
+    {
+        status = VcSilenceTrimmerFinish(trimmer, VcEncodeSinkWrite, sink);
+    }
 
-void VcWriteBufferALaw(size_t n_bytes)
-{
+    if (status == 0)
+    {
+        status = VcEncodeSinkSubmit(sink, NULL, 0);
+    }
+
+    if (status == 0)
+    {
+        status = VcVorbisEncoderFinish(sink->encoder, error);
+    }
 
+    for (int ch = 0; ch < reader->nChannels; ch++)
+    {
+        g_free(block[ch]);
+    }
+    g_free(block);
+
+    return status;
 }
 
-void VcWriteBufferMuLaw(size_t n_bytes)
+static void VcLogSilence(VcEncodeOptions *options, VcSilenceTrimmer *trimmer, long rate)
 {
-    
+    double offset = (double)options->nStartFrame / rate;
+    for (guint i = 0; i < trimmer->spans->len; i++)
+    {
+        VcSilentSpan *span = &g_array_index(trimmer->spans, VcSilentSpan, i);
+        VcLogViewWriteLine(options->pLogView, "Silence from %.2fs to %.2fs%s", 
+            offset + (double)span->nStart / rate, offset + (double)span->nEnd / rate, span->bTrimmed ? " (trimmed)" : "");
+    }
+
+    uint64_t trimmed = VcSilenceTrimmedFrames(trimmer);
+    if (trimmed > 0)
+    {
+        VcLogViewWriteLine(options->pLogView, "Trimmed %.2fs of silence", (double)trimmed / rate);
+    }
 }
 
-void VcWriteBuffer(size_t n_bytes)
+static void VcLogIntegrity(VcEncodeOptions *options, VcIntegrityChecker *checker)
 {
-    switch (((VcWaveFormat) vcCtx.common.wFormatTag))
+    g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Integrity check failed");
+    VcLogViewWriteLine(options->pLogView, "Integrity check failed, the output is corrupt:");
+
+    if (checker->nHeaders < 3)
     {
-        case VC_WAVE_FORMAT_PCM:
-        {
-            VcWriteBufferPCM(n_bytes);
-            break;
-        }
+        VcLogViewWriteLine(options->pLogView, "  headers incomplete or unreadable");
+    }
 
-        case VC_WAVE_FORMAT_IEEE_FLOAT:
-        {
-            VcWriteBufferFloat(n_bytes);
-            break;
-        }
+    if (!checker->bEos)
+    {
+        VcLogViewWriteLine(options->pLogView, "  no end of stream page");
+    }
 
-        case VC_WAVE_FORMAT_ALAW:
-        {
-            VcWriteBufferALaw(n_bytes);
-            break;
-        }
+    if (checker->nBytesSkipped > 0)
+    {
+        VcLogViewWriteLine(options->pLogView, "  %" G_GUINT64_FORMAT " bytes outside valid pages (bad CRC or truncated)", checker->nBytesSkipped);
+    }
 
-        case VC_WAVE_FORMAT_MULAW:
-        {
-            VcWriteBufferMuLaw(n_bytes);
-            break;
-        }
+    if (checker->nSequenceErrors > 0 || checker->nGranuleErrors > 0)
+    {
+        VcLogViewWriteLine(options->pLogView, "  %" G_GUINT64_FORMAT " page sequence and %" G_GUINT64_FORMAT " granule position errors", 
+            checker->nSequenceErrors, checker->nGranuleErrors);
+    }
 
-        default: break;
+    if (checker->nBadPackets > 0)
+    {
+        VcLogViewWriteLine(options->pLogView, "  %" G_GUINT64_FORMAT " of %" G_GUINT64_FORMAT " packets didn't decode", checker->nBadPackets, checker->nPackets);
+    }
+
+    if (checker->nDecodedFrames != checker->nExpectedFrames || checker->nLastGranule != checker->nExpectedFrames)
+    {
+        VcLogViewWriteLine(options->pLogView, "  %" G_GINT64_FORMAT " frames encoded, %" G_GINT64_FORMAT " decoded, last granule %" G_GINT64_FORMAT, 
+            checker->nExpectedFrames, checker->nDecodedFrames, checker->nLastGranule);
     }
 }
 
-void VcEncoderFinalize(VcEncodeOptions *options)
+static void VcLogVerification(VcEncodeOptions *options, VcVerifier *verifier)
 {
-    ogg_stream_clear(&vcCtx.stream);
-    vorbis_block_clear(&vcCtx.block);
-    vorbis_dsp_clear(&vcCtx.dsp);
-    vorbis_comment_clear(&vcCtx.comment);
-    vorbis_info_clear(&vcCtx.vi);
-
-    g_input_stream_close(options->pInFileStream, NULL, NULL);
+    double offset = (double)options->nStartFrame / verifier->nRate;
+    for (guint i = 0; i < verifier->windows->len; i++)
+    {
+        VcVerifyWindow *window = &g_array_index(verifier->windows, VcVerifyWindow, i);
+        if (!isnan(window->dSegmentalSnr))
+        {
+            VcLogViewWriteLine(options->pLogView, "%.0fs: SNR %.1f dB, segmental SNR %.1f dB, spectral distance %.2f dB", 
+                offset + window->dStart, window->dSnr, window->dSegmentalSnr, window->dSpectralDistance);
+        }
+    }
 
-    g_main_context_invoke(NULL, options->cbOnFinished, options);
-}
+    VcVerifyWindow result;
+    VcVerifierGetResult(verifier, &result);
+    VcLogViewWriteLine(options->pLogView, "Verified %.2fs: SNR %.1f dB, segmental SNR %.1f dB, spectral distance %.2f dB", 
+        (double)verifier->nFrames / verifier->nRate, result.dSnr, result.dSegmentalSnr, result.dSpectralDistance);
 
-GThread *VcGetEncoderThread() 
-{ 
-    return encoderThread; 
+    if (verifier->nMissing > 0 || verifier->nExtra > 0)
+    {
+        VcLogViewWriteLine(options->pLogView, "Decoded length differs from the source: %" G_GUINT64_FORMAT " frames missing, %" G_GUINT64_FORMAT " extra", 
+            verifier->nMissing, verifier->nExtra);
+    }
 }
 
 int VcEncodeCallback(VcEncodeOptions *options)
 {
-    vcCtx.pInfile = options->pInFileStream;
-    vcCtx.pOutfile = options->pOutFileStream;
-
+    VcWaveReader reader;
+    VcVorbisEncoder encoder = { 0 };
     GError *error = NULL;
 
-    int status;
-
-    status = VcReadHeader(options->pLogView);
-
+    VcWaveFollow follow = { options->pFollowSentinel, options->dFollowIdle, &options->nFollowCancel };
+    int status = options->bFollow
+        ? VcWaveReaderOpenFollow(&reader, G_INPUT_STREAM(options->pInFileStream), options->nStartFrame, options->nEndFrame, &follow, options->pLogView)
+        : VcWaveReaderOpen(&reader, G_INPUT_STREAM(options->pInFileStream), options->nStartFrame, options->nEndFrame, options->pLogView);
     if (status < 0)
     {
         g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Failed to parse header");
+        VcWaveReaderClose(&reader);
         VcEncoderFinalize(options);
         return -1;
     }
 
-    srand(time(NULL));
-    status = ogg_stream_init(&vcCtx.stream, rand());
-    if (status < 0)
+    if (options->mixLayout != VC_MIX_KEEP && VcWaveReaderSetLayout(&reader, options->mixLayout) == 0 && reader.nChannels != reader.info.common.nChannels)
     {
-        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't initialize vorbis stream");
-        VcEncoderFinalize(options);
-        return -1;
+        VcLogViewWriteLine(options->pLogView, "Mixing %d channels down to %d", reader.info.common.nChannels, reader.nChannels);
     }
 
-    vorbis_info_init(&vcCtx.vi);
-    status = vorbis_encode_init_vbr(&vcCtx.vi, vcCtx.common.nChannels, vcCtx.common.nSamplesPerSec, options->fDesiredQuality);
-    if (status < 0)
+    // Silence is found on the mixed blocks, before they cost any resampling or analysis
+    VcSilenceTrimmer trimmer = { 0 };
+    long inputRate = reader.info.common.nSamplesPerSec;
+    bool trim = options->bTrimLeading || options->bTrimTrailing;
+    if (trim)
     {
-        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't initialize vorbis encoding engine");
-        VcEncoderFinalize(options);
-        return -1;
+        trim = VcSilenceTrimmerInit(&trimmer, reader.nChannels, options->dSilenceThreshold, options->dMinSilence, inputRate, options->bTrimLeading, options->bTrimTrailing) == 0;
     }
 
-    status = vorbis_analysis_init(&vcCtx.dsp, &vcCtx.vi);
-    if (status < 0)
+    // Hi-res input is brought down to the output rate before analysis
+    VcResampler resampler = { 0 };
+    long rate = inputRate;
+    bool resample = options->nOutputRate > 0 && options->nOutputRate != rate;
+    if (resample)
     {
-        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't initialize vorbis analysis engine");
-        VcEncoderFinalize(options);
-        return -1;
+        status = VcResamplerInit(&resampler, reader.nChannels, rate, options->nOutputRate, options->resampleQuality, VC_WAVE_BLOCK_FRAMES);
+        if (status == 0)
+        {
+            VcLogViewWriteLine(options->pLogView, "Resampling from %ld to %ld Hz", rate, options->nOutputRate);
+            rate = options->nOutputRate;
+        }
     }
-    
-    vorbis_comment_init(&vcCtx.comment);
-    ogg_packet header_packet, comment_packet, code_packet;
-    status = vorbis_analysis_headerout(&vcCtx.dsp, &vcCtx.comment, &header_packet, &comment_packet, &code_packet);
-    if (status < 0)
+
+    if (status == 0)
     {
-        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Failed to write header");
-        VcEncoderFinalize(options);
-        return -1;
+        status = VcVorbisEncoderInitTuned(&encoder, reader.nChannels, rate, &options->tuning);
     }
 
-    status = vorbis_block_init(&vcCtx.dsp, &vcCtx.block);
-    if (status < 0)
+    // Every segment is a link of its own in a chained stream, the single stream checks and the header rewrite don't apply
+    VcSegmentWriter segments = { 0 };
+    bool segment = options->dSegmentSeconds > 0.0 && options->pOutPath != NULL && status == 0;
+    if (segment)
     {
-        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't initialize vorbis block structure");
-        VcEncoderFinalize(options);
-        return -1;
+        segment = VcSegmentWriterInit(&segments, options->pOutPath, rate, options->bSegmentFiles) == 0;
     }
 
-    ogg_stream_packetin(&vcCtx.stream, &header_packet);
-    ogg_stream_packetin(&vcCtx.stream, &comment_packet);
-    ogg_stream_packetin(&vcCtx.stream, &code_packet);
+    if (segment && (options->bLoudnessTags || options->bVerify || options->bCheckIntegrity))
+    {
+        VcLogViewWriteLine(options->pLogView, "Segmented output, skipping loudness tags, verification and the integrity check");
+    }
 
-    while (true)
+    // Loudness is measured on the way in, placeholder tags of the final size are patched at the end
+    VcLoudnessMeter meter = { 0 };
+    VcLoudnessResult loudness = { 0 };
+    bool measure = options->bLoudnessTags && !segment && status == 0;
+    if (measure && !g_seekable_can_seek(G_SEEKABLE(options->pOutFileStream)))
+    {
+        VcLogViewWriteLine(options->pLogView, "Output can't be rewritten, skipping loudness tags");
+        measure = false;
+    }
+
+    if (measure && VcLoudnessInit(&meter, reader.nChannels, rate) == 0)
+    {
+        VcLoudnessTag(&loudness, &encoder.comment);
+    }
+
+    else
+    {
+        measure = false;
+    }
+
+    // The verifier follows the written pages in memory, the preview buffer if there is one
+    VcVerifier verifier = { 0 };
+    VcOggBuffer *pagesCopy = options->pOggBuffer != NULL ? VcOggBufferRef(options->pOggBuffer) : NULL;
+    bool verify = options->bVerify && !segment && status == 0;
+    if (verify && pagesCopy == NULL)
+    {
+        pagesCopy = VcOggBufferNew();
+    }
+
+    if (verify)
+    {
+        verify = VcVerifierStart(&verifier, pagesCopy, reader.nChannels, rate) == 0;
+    }
+
+    // The integrity checker reads the output file back, a write that went wrong on disk shows up there
+    VcIntegrityChecker checker = { 0 };
+    bool check = options->bCheckIntegrity && !segment && status == 0;
+    if (check && options->pOutFile == NULL)
+    {
+        VcLogViewWriteLine(options->pLogView, "Output file unknown, skipping the integrity check");
+        check = false;
+    }
+
+    if (check)
     {
-        int result = ogg_stream_flush(&vcCtx.stream, &vcCtx.page);
-        if(result == 0) 
+        GError *checkError = NULL;
+        check = VcIntegrityStart(&checker, options->pOutFile, reader.nChannels, &checkError) == 0;
+        if (!check)
         {
-            break;
+            VcLogViewWriteLine(options->pLogView, "Couldn't read the output back, skipping the integrity check: %s", checkError->message);
+            g_error_free(checkError);
+        }
+    }
+
+    // Losing the live sink is logged but the file is still written
+    VcLiveSink live = { 0 };
+    if (status == 0 && options->pLiveTarget != NULL && options->pLiveTarget[0] != '\0')
+    {
+        GError *liveError = NULL;
+        if (VcLiveSinkOpen(&live, options->pLiveTarget, &liveError) == 0)
+        {
+            encoder.pLive               = &live;
+            encoder.nPageFill           = options->nLivePageBytes;
+            encoder.nMaxLatencyFrames   = (int64_t)options->nLiveLatencyMs * rate / 1000;
+            VcLogViewWriteLine(options->pLogView, "Streaming to %s, pages held at most %d ms", options->pLiveTarget, options->nLiveLatencyMs);
         }
-        g_output_stream_write(G_OUTPUT_STREAM(vcCtx.pOutfile), vcCtx.page.header, vcCtx.page.header_len, NULL, &error);
-        g_output_stream_write(G_OUTPUT_STREAM(vcCtx.pOutfile), vcCtx.page.body, vcCtx.page.body_len, NULL, &error);
-        if (error != NULL)
+
+        else
         {
-            g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
-            VcEncoderFinalize(options);
-            return -1;
+            VcLogViewWriteLine(options->pLogView, "Couldn't open %s: %s", options->pLiveTarget, liveError->message);
+            g_error_free(liveError);
         }
     }
-    
-    bool eos = false;
 
-    while (!eos)
+    if (status == 0)
     {
-        size_t n_bytes =  g_input_stream_read(G_INPUT_STREAM(vcCtx.pInfile), vcReadBuffer, VC_BUFFER_SIZE, NULL, &error);
-        if (error != NULL)
+        encoder.pOut        = G_OUTPUT_STREAM(options->pOutFileStream);
+        encoder.pOggBuffer  = pagesCopy;
+        encoder.pSeekIndex  = options->pSeekIndex;
+
+        if (segment)
         {
-            g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
-            VcEncoderFinalize(options);
-            return -1;
+            encoder.pSegments       = &segments;
+            encoder.nSegmentFrames  = MAX((int64_t)(options->dSegmentSeconds * rate), 1);
         }
 
-        if (n_bytes == 0)
+        status = VcVorbisEncoderWriteHeaders(&encoder, &error);
+        if (status == 0 && options->pOggBuffer != NULL)
         {
-            vorbis_analysis_wrote(&vcCtx.dsp, 0);
+            VcOggBufferMarkHeaders(options->pOggBuffer);
         }
-        else
+    }
+
+    if (status == 0)
+    {
+        VcEncodeSink sink = { &encoder, resample ? &resampler : NULL, measure ? &meter : NULL, verify ? &verifier : NULL, &error, options->pAbort };
+        status = resample || trim
+            ? VcEncodePipeline(&reader, trim ? &trimmer : NULL, &sink, &error)
+            : VcEncodeStream(&reader, &sink, &error);
+    }
+
+    // Both are joined before the loudness rewrite touches the header pages they are reading
+    if (check && status == 0 && !g_output_stream_flush(G_OUTPUT_STREAM(options->pOutFileStream), NULL, &error))
+    {
+        status = -1;
+    }
+
+    if (check && VcIntegrityFinish(&checker, encoder.nFramesWritten) < 0 && status == 0)
+    {
+        VcLogIntegrity(options, &checker);
+        status = -1;
+    }
+
+    else if (check && status == 0)
+    {
+        VcLogViewWriteLine(options->pLogView, "Integrity check passed: %" G_GUINT64_FORMAT " pages, %" G_GINT64_FORMAT " frames", 
+            checker.nPages, checker.nDecodedFrames);
+    }
+
+    if (verify && VcVerifierFinish(&verifier) < 0 && status == 0)
+    {
+        VcLogViewWriteLine(options->pLogView, "Verification failed, the encoded stream didn't decode");
+    }
+
+    else if (verify && status == 0)
+    {
+        VcLogVerification(options, &verifier);
+    }
+
+    if (live.queue != NULL && VcLiveSinkFinish(&live) < 0)
+    {
+        VcLogViewWriteLine(options->pLogView, "Live output to %s was lost while encoding", options->pLiveTarget);
+    }
+
+    if (live.nDropped > 0)
+    {
+        VcLogViewWriteLine(options->pLogView, "Live output fell behind, %d pages were skipped", live.nDropped);
+    }
+
+    if (status == 0 && segment)
+    {
+        gchar *manifest = VcSegmentWriterWriteManifest(&segments, options->pOutPath, &error);
+        status = manifest != NULL ? 0 : -1;
+        if (manifest != NULL)
         {
-            VcWriteBuffer(n_bytes);
+            VcLogViewWriteLine(options->pLogView, "Wrote %u segments of %.2fs, manifest: %s", segments.segments->len, options->dSegmentSeconds, manifest);
+            g_free(manifest);
         }
+    }
 
-        while ((status = vorbis_analysis_blockout(&vcCtx.dsp, &vcCtx.block)) > 0)
-        {
-            status = vorbis_analysis(&vcCtx.block, NULL);
-            if (status < 0)
-            {
-                g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Analysis error: %d", status);
-                VcEncoderFinalize(options);
-                return -1;
-            }
-            status = vorbis_bitrate_addblock(&vcCtx.block);
-            if (status < 0)
-            {
-                g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't add block: %d", status);
-                VcEncoderFinalize(options);
-                return -1;
-            }
-
-            while ((status = vorbis_bitrate_flushpacket(&vcCtx.dsp, &vcCtx.packet)) > 0)
-            {
-                status = ogg_stream_packetin(&vcCtx.stream, &vcCtx.packet);
-                if (status < 0)
-                {
-                    g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Failed to read packet from stream: %d", status);
-                    VcEncoderFinalize(options);
-                    return -1;
-                }
-                while (!eos)
-                {
-                    int result = ogg_stream_pageout(&vcCtx.stream, &vcCtx.page);
-                    if (result == 0)
-                    {
-                        break;
-                    }
-                    
-                    g_output_stream_write(G_OUTPUT_STREAM(vcCtx.pOutfile), vcCtx.page.header, vcCtx.page.header_len, NULL, &error);
-                    g_output_stream_write(G_OUTPUT_STREAM(vcCtx.pOutfile), vcCtx.page.body, vcCtx.page.body_len, NULL, &error);
-                    if (error != NULL)
-                    {
-                        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
-                        VcEncoderFinalize(options);
-                        return -1;
-                    }
-
-                    if(ogg_page_eos(&vcCtx.page))
-                    {
-                        eos = true;
-                    }
-                }
-            }
-            if (status < 0)
-            {
-                g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Failed to flush packet: %d", status);
-                VcEncoderFinalize(options);
-                return -1;
-            }
+    if (status == 0 && options->bFollow)
+    {
+        VcLogViewWriteLine(options->pLogView, "Recording ended, encoded %.2fs", (double)encoder.nFramesWritten / rate);
+    }
+
+    if (status == 0 && trim)
+    {
+        VcLogSilence(options, &trimmer, inputRate);
+    }
+
+    if (status == 0 && measure)
+    {
+        VcLoudnessGetResult(&meter, &loudness);
+        VcLogViewWriteLine(options->pLogView, "Integrated loudness: %.1f LUFS, true peak: %.1f dBTP, sample peak: %.1f dBFS",
+            loudness.dIntegrated, 20.0 * log10(MAX(loudness.dTruePeak, 1e-9)), 20.0 * log10(MAX(loudness.dSamplePeak, 1e-9)));
+
+        vorbis_comment_clear(&encoder.comment);
+        vorbis_comment_init(&encoder.comment);
+        VcLoudnessTag(&loudness, &encoder.comment);
+        status = VcVorbisEncoderRewriteHeaders(&encoder, &error);
 
+        if (status == 0 && check)
+        {
+            status = g_output_stream_flush(G_OUTPUT_STREAM(options->pOutFileStream), NULL, &error) ? 0 : -1;
         }
-        if (status < 0)
+
+        if (status == 0 && check && VcIntegrityCheckHeaders(&checker, encoder.nHeaderBytes) < 0)
         {
-            g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't write block: %d", status);
-            VcEncoderFinalize(options);
-            return -1;
+            g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Integrity check failed");
+            VcLogViewWriteLine(options->pLogView, "Integrity check failed, the rewritten header pages don't read back");
+            status = -1;
         }
-        
     }
 
+    if (error != NULL)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+    }
+
+    VcVorbisEncoderClear(&encoder);
+    VcResamplerClear(&resampler);
+    VcLoudnessClear(&meter);
+    VcSilenceTrimmerClear(&trimmer);
+    VcVerifierClear(&verifier);
+    VcIntegrityClear(&checker);
+    VcSegmentWriterClear(&segments);
+    VcLiveSinkClose(&live);
+    VcOggBufferUnref(pagesCopy);
+    VcWaveReaderClose(&reader);
     VcEncoderFinalize(options);
     
-    return 0;
+    return status;
 }
 
 GThread *VcEncode(VcEncodeOptions *options)
 {
     return encoderThread = g_thread_new("encoder", VcEncodeCallback, options);
-}
\ No newline at end of file
+}
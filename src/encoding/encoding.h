@@ -5,9 +5,8 @@
 #include <stdbool.h>
 #include "options.h"
 
-#define VC_BUFFER_SIZE 3072
-
 GThread *VcEncode(VcEncodeOptions *options);
+int     VcEncodeCallback(VcEncodeOptions *options);
 GThread *VcGetEncoderThread();
 
 #endif //VC_ENCODING_H
\ No newline at end of file
@@ -0,0 +1,276 @@
+#include "integrity.h"
+#include <vorbis/codec.h>
+#include <string.h>
+
+#define VC_INTEGRITY_READ_SIZE  4096
+#define VC_INTEGRITY_WAIT       20000   // microseconds between reads while the file isn't growing
+
+static void VcIntegrityCheckPackets(VcIntegrityChecker *checker, ogg_stream_state *stream, vorbis_info *info, vorbis_comment *comment, vorbis_dsp_state *dsp, vorbis_block *block)
+{
+    ogg_packet packet;
+    int result;
+    while ((result = ogg_stream_packetout(stream, &packet)) != 0)
+    {
+        // A hole in the packet data, already counted by the page sequence check
+        if (result < 0)
+        {
+            continue;
+        }
+
+        checker->nPackets++;
+        if (checker->nHeaders < 3)
+        {
+            if (vorbis_synthesis_headerin(info, comment, &packet) < 0 || info->channels != checker->nChannels)
+            {
+                checker->nBadPackets++;
+            }
+
+            else if (++checker->nHeaders == 3)
+            {
+                vorbis_synthesis_init(dsp, info);
+                vorbis_block_init(dsp, block);
+            }
+            continue;
+        }
+
+        if (vorbis_synthesis(block, &packet) != 0 || vorbis_synthesis_blockin(dsp, block) != 0)
+        {
+            checker->nBadPackets++;
+            continue;
+        }
+
+        // Only the count matters, pcmout without a buffer just reports it
+        int frames;
+        while ((frames = vorbis_synthesis_pcmout(dsp, NULL)) > 0)
+        {
+            checker->nDecodedFrames += frames;
+            vorbis_synthesis_read(dsp, frames);
+        }
+    }
+}
+
+static gpointer VcIntegrityThread(gpointer data)
+{
+    VcIntegrityChecker *checker = (VcIntegrityChecker *)data;
+    ogg_sync_state sync;
+    ogg_stream_state stream;
+    vorbis_info info;
+    vorbis_comment comment;
+    vorbis_dsp_state dsp;
+    vorbis_block block;
+    ogg_page page;
+
+    ogg_sync_init(&sync);
+    vorbis_info_init(&info);
+    vorbis_comment_init(&comment);
+
+    bool streamReady = false;
+    long expectedPage = 0;
+
+    while (!checker->bEos)
+    {
+        long result;
+        while (!checker->bEos && (result = ogg_sync_pageseek(&sync, &page)) != 0)
+        {
+            // pageseek skips anything that isn't a page with a valid checksum
+            if (result < 0)
+            {
+                checker->nBytesSkipped += -result;
+                continue;
+            }
+
+            if (!streamReady)
+            {
+                ogg_stream_init(&stream, ogg_page_serialno(&page));
+                streamReady = true;
+            }
+
+            checker->nPages++;
+            if (ogg_page_serialno(&page) != stream.serialno || ogg_page_pageno(&page) != expectedPage)
+            {
+                checker->nSequenceErrors++;
+            }
+            expectedPage = ogg_page_pageno(&page) + 1;
+
+            // Pages where no packet ends carry -1
+            ogg_int64_t granule = ogg_page_granulepos(&page);
+            if (granule >= 0)
+            {
+                if (granule < checker->nLastGranule)
+                {
+                    checker->nGranuleErrors++;
+                }
+                checker->nLastGranule = granule;
+            }
+
+            if (ogg_stream_pagein(&stream, &page) == 0)
+            {
+                VcIntegrityCheckPackets(checker, &stream, &info, &comment, &dsp, &block);
+            }
+
+            checker->bEos = ogg_page_eos(&page) != 0;
+        }
+
+        if (checker->bEos)
+        {
+            break;
+        }
+
+        // Finished is read first, an empty read after it means the whole file has been seen
+        bool finished = g_atomic_int_get(&checker->nFinished);
+        char *dst = ogg_sync_buffer(&sync, VC_INTEGRITY_READ_SIZE);
+        gssize read = g_input_stream_read(G_INPUT_STREAM(checker->pIn), dst, VC_INTEGRITY_READ_SIZE, NULL, NULL);
+        if (read < 0)
+        {
+            break;
+        }
+
+        ogg_sync_wrote(&sync, (long)read);
+        if (read == 0 && finished)
+        {
+            break;
+        }
+
+        if (read == 0)
+        {
+            g_usleep(VC_INTEGRITY_WAIT);
+        }
+    }
+
+    // Whatever is left after the last page is a truncated one
+    checker->nBytesSkipped += sync.fill - sync.returned;
+
+    if (checker->nHeaders == 3)
+    {
+        vorbis_block_clear(&block);
+        vorbis_dsp_clear(&dsp);
+    }
+
+    if (streamReady)
+    {
+        ogg_stream_clear(&stream);
+    }
+
+    vorbis_comment_clear(&comment);
+    vorbis_info_clear(&info);
+    ogg_sync_clear(&sync);
+
+    return NULL;
+}
+
+int VcIntegrityStart(VcIntegrityChecker *checker, GFile *file, int channels, GError **error)
+{
+    memset(checker, 0, sizeof(VcIntegrityChecker));
+    checker->pIn = g_file_read(file, NULL, error);
+    if (checker->pIn == NULL)
+    {
+        return -1;
+    }
+
+    checker->nChannels = channels;
+    checker->thread = g_thread_new("integrity", VcIntegrityThread, checker);
+    return 0;
+}
+
+// Waits for the checker to reach the end of the file, so it goes after the last page has been
+// written. Returns -1 if anything was wrong with the stream or it doesn't hold expectedFrames.
+int VcIntegrityFinish(VcIntegrityChecker *checker, int64_t expectedFrames)
+{
+    if (checker->thread == NULL)
+    {
+        return -1;
+    }
+
+    g_atomic_int_set(&checker->nFinished, 1);
+    g_thread_join(checker->thread);
+    checker->thread = NULL;
+    checker->nExpectedFrames = expectedFrames;
+
+    bool sound = checker->nHeaders == 3 && checker->bEos
+        && checker->nBytesSkipped == 0 && checker->nSequenceErrors == 0
+        && checker->nGranuleErrors == 0 && checker->nBadPackets == 0
+        && checker->nDecodedFrames == expectedFrames && checker->nLastGranule == expectedFrames;
+
+    return sound ? 0 : -1;
+}
+
+// The header pages are rewritten in place once the loudness tags are known, after the checker read
+// them. Reads them from the file again and checks they are still whole pages holding the three headers.
+int VcIntegrityCheckHeaders(VcIntegrityChecker *checker, int64_t headerBytes)
+{
+    if (checker->pIn == NULL || headerBytes <= 0
+        || !g_seekable_seek(G_SEEKABLE(checker->pIn), 0, G_SEEK_SET, NULL, NULL))
+    {
+        return -1;
+    }
+
+    ogg_sync_state sync;
+    ogg_sync_init(&sync);
+    char *dst = ogg_sync_buffer(&sync, (long)headerBytes);
+    gsize read = 0;
+    bool whole = g_input_stream_read_all(G_INPUT_STREAM(checker->pIn), dst, (gsize)headerBytes, &read, NULL, NULL)
+        && read == (gsize)headerBytes;
+    ogg_sync_wrote(&sync, (long)read);
+
+    ogg_stream_state stream;
+    vorbis_info info;
+    vorbis_comment comment;
+    ogg_page page;
+    ogg_packet packet;
+    vorbis_info_init(&info);
+    vorbis_comment_init(&comment);
+
+    bool streamReady = false;
+    int headers = 0;
+    long result;
+    while (whole && (result = ogg_sync_pageseek(&sync, &page)) != 0)
+    {
+        if (result < 0)
+        {
+            whole = false;
+            break;
+        }
+
+        if (!streamReady)
+        {
+            ogg_stream_init(&stream, ogg_page_serialno(&page));
+            streamReady = true;
+        }
+
+        ogg_stream_pagein(&stream, &page);
+        while (ogg_stream_packetout(&stream, &packet) > 0)
+        {
+            if (headers == 3 || vorbis_synthesis_headerin(&info, &comment, &packet) < 0)
+            {
+                whole = false;
+                break;
+            }
+            headers++;
+        }
+    }
+
+    // Anything left over is a page cut short
+    whole = whole && headers == 3 && sync.fill == sync.returned;
+
+    if (streamReady)
+    {
+        ogg_stream_clear(&stream);
+    }
+
+    vorbis_comment_clear(&comment);
+    vorbis_info_clear(&info);
+    ogg_sync_clear(&sync);
+
+    return whole ? 0 : -1;
+}
+
+void VcIntegrityClear(VcIntegrityChecker *checker)
+{
+    if (checker->thread != NULL)
+    {
+        VcIntegrityFinish(checker, 0);
+    }
+
+    g_clear_object(&checker->pIn);
+    memset(checker, 0, sizeof(VcIntegrityChecker));
+}
@@ -0,0 +1,39 @@
+#ifndef VC_INTEGRITY_H
+#define VC_INTEGRITY_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Reads the output file back as it grows and checks the stream that reached the disk is sound: page
+// CRCs and sequence numbers, granule positions that never go back, every audio packet through
+// vorbis_synthesis, and a decoded length matching what the encoder was given. Runs on its own thread
+// next to the encoder.
+typedef struct
+{
+    GFileInputStream    *pIn;
+    GThread             *thread;
+    int                 nChannels;
+    gint                nFinished;          // set once the last page was written, the next empty read ends the check
+
+    // results, valid after VcIntegrityFinish
+    uint64_t            nPages;
+    uint64_t            nBytesSkipped;      // bytes ogg_sync had to skip, bad CRCs or garbage between pages
+    uint64_t            nSequenceErrors;    // missing pages or a foreign serial number
+    uint64_t            nGranuleErrors;     // granule positions going backwards
+    uint64_t            nPackets;
+    uint64_t            nBadPackets;        // audio packets vorbis_synthesis refused
+    int64_t             nLastGranule;
+    int64_t             nDecodedFrames;
+    int64_t             nExpectedFrames;
+    int                 nHeaders;           // header packets parsed, audio follows the third
+    bool                bEos;
+
+} VcIntegrityChecker;
+
+int     VcIntegrityStart(VcIntegrityChecker *checker, GFile *file, int channels, GError **error);
+int     VcIntegrityFinish(VcIntegrityChecker *checker, int64_t expectedFrames);
+int     VcIntegrityCheckHeaders(VcIntegrityChecker *checker, int64_t headerBytes);
+void    VcIntegrityClear(VcIntegrityChecker *checker);
+
+#endif // VC_INTEGRITY_H
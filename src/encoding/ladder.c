@@ -0,0 +1,199 @@
+#include "ladder.h"
+#include "wave.h"
+#include "pcm-block.h"
+#include "vorbis-encoder.h"
+#include "../gui/log-view.h"
+#include <string.h>
+
+typedef struct
+{
+    VcLadderRendition   *rendition;
+    GAsyncQueue         *queue;
+    int                 nChannels;
+    long                nRate;
+
+} VcLadderJob;
+
+// "song.ogg" at quality 0.4 becomes "song-q4.0.ogg"
+gchar *VcLadderRenditionPath(const char *basePath, float quality)
+{
+    gchar suffix[G_ASCII_DTOSTR_BUF_SIZE];
+    g_ascii_formatd(suffix, sizeof(suffix), "%.1f", quality * 10.0f);
+
+    const char *dot = strrchr(basePath, '.');
+    const char *slash = strrchr(basePath, G_DIR_SEPARATOR);
+    if (dot == NULL || (slash != NULL && dot < slash))
+    {
+        return g_strdup_printf("%s-q%s.ogg", basePath, suffix);
+    }
+
+    return g_strdup_printf("%.*s-q%s%s", (int)(dot - basePath), basePath, suffix, dot);
+}
+
+static int VcLadderOpenEncoder(VcLadderJob *job, VcVorbisEncoder *encoder, GError **error)
+{
+    GFile *file = g_file_new_for_path(job->rendition->pPath);
+    GFileOutputStream *stream = g_file_replace(file, NULL, false, G_FILE_CREATE_REPLACE_DESTINATION, NULL, error);
+    g_object_unref(file);
+    if (stream == NULL)
+    {
+        return -1;
+    }
+
+    encoder->pOut = G_OUTPUT_STREAM(stream);
+    return VcVorbisEncoderWriteHeaders(encoder, error);
+}
+
+// Drains its queue until the empty end-of-stream block, even after a failure, so the reader never stalls
+gpointer VcLadderEncodeCallback(gpointer data)
+{
+    VcLadderJob *job = (VcLadderJob *)data;
+    VcLadderRendition *rendition = job->rendition;
+    VcVorbisEncoder encoder;
+    GError *error = NULL;
+
+    rendition->status = VcVorbisEncoderInit(&encoder, job->nChannels, job->nRate, rendition->fQuality);
+    if (rendition->status == 0)
+    {
+        rendition->status = VcLadderOpenEncoder(job, &encoder, &error);
+    }
+
+    while (true)
+    {
+        VcPcmBlock *block = g_async_queue_pop(job->queue);
+        int frames = block->nFrames;
+
+        if (rendition->status == 0 && frames > 0)
+        {
+            rendition->status = VcVorbisEncoderWrite(&encoder, block->channels, frames, &error);
+        }
+
+        VcPcmBlockUnref(block);
+        if (frames == 0)
+        {
+            break;
+        }
+    }
+
+    if (rendition->status == 0)
+    {
+        rendition->status = VcVorbisEncoderFinish(&encoder, &error);
+    }
+
+    if (encoder.pOut != NULL)
+    {
+        g_output_stream_close(encoder.pOut, NULL, rendition->status == 0 ? &error : NULL);
+        g_object_unref(encoder.pOut);
+    }
+
+    if (error != NULL)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "%s: %s", rendition->pPath, error->message);
+        g_error_free(error);
+        rendition->status = -1;
+    }
+
+    rendition->nBytes = encoder.nBytesWritten;
+    VcVorbisEncoderClear(&encoder);
+
+    return NULL;
+}
+
+// Reads and converts the input once, every rendition encodes from the same shared blocks
+int VcLadderCallback(VcLadderOptions *options)
+{
+    VcWaveReader reader;
+    VcLadderJob jobs[VC_LADDER_MAX_RENDITIONS];
+    GThread *workers[VC_LADDER_MAX_RENDITIONS];
+    GError *error = NULL;
+
+    if (VcWaveReaderOpen(&reader, G_INPUT_STREAM(options->pInFileStream), options->nStartFrame, options->nEndFrame, options->pLogView) < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Failed to parse header");
+        VcWaveReaderClose(&reader);
+        for (int i = 0; i < options->nRenditions; i++)
+        {
+            options->renditions[i].status = -1;
+        }
+        g_main_context_invoke(NULL, options->cbOnFinished, options);
+        return -1;
+    }
+
+    int channels = reader.nChannels;
+    long rate = reader.info.common.nSamplesPerSec;
+    VcPcmBlockPool *pool = VcPcmBlockPoolNew(channels, VC_WAVE_BLOCK_FRAMES, VC_LADDER_MAX_BLOCKS);
+
+    for (int i = 0; i < options->nRenditions; i++)
+    {
+        jobs[i].rendition = &options->renditions[i];
+        jobs[i].queue = g_async_queue_new();
+        jobs[i].nChannels = channels;
+        jobs[i].nRate = rate;
+        workers[i] = g_thread_new("ladder-encoder", VcLadderEncodeCallback, &jobs[i]);
+    }
+
+    uint64_t framesRead = 0;
+    while (true)
+    {
+        VcPcmBlock *block = VcPcmBlockAcquire(pool);
+        long frames = VcWaveReaderRead(&reader, block->channels, VC_WAVE_BLOCK_FRAMES, &error);
+        block->nFrames = MAX(frames, 0);
+        framesRead += block->nFrames;
+
+        // The empty block at the end tells every encoder to finish its stream
+        for (int i = 0; i < options->nRenditions; i++)
+        {
+            g_async_queue_push(jobs[i].queue, VcPcmBlockRef(block));
+        }
+        VcPcmBlockUnref(block);
+
+        if (frames <= 0)
+        {
+            break;
+        }
+    }
+
+    for (int i = 0; i < options->nRenditions; i++)
+    {
+        g_thread_join(workers[i]);
+        g_async_queue_unref(jobs[i].queue);
+    }
+
+    VcPcmBlockPoolFree(pool);
+    VcWaveReaderClose(&reader);
+
+    if (error != NULL)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+        for (int i = 0; i < options->nRenditions; i++)
+        {
+            options->renditions[i].status = -1;
+        }
+    }
+
+    options->dDuration = (double)framesRead / rate;
+    for (int i = 0; i < options->nRenditions; i++)
+    {
+        VcLadderRendition *rendition = &options->renditions[i];
+        rendition->dBitrate = options->dDuration > 0.0 ? rendition->nBytes * 8.0 / options->dDuration / 1000.0 : 0.0;
+    }
+
+    g_main_context_invoke(NULL, options->cbOnFinished, options);
+
+    return 0;
+}
+
+GThread *VcEncodeLadder(VcLadderOptions *options)
+{
+    return g_thread_new("ladder", VcLadderCallback, options);
+}
+
+void VcLadderRenditionsClear(VcLadderOptions *options)
+{
+    for (int i = 0; i < VC_LADDER_MAX_RENDITIONS; i++)
+    {
+        g_free(options->renditions[i].pPath);
+        memset(&options->renditions[i], 0, sizeof(VcLadderRendition));
+    }
+}
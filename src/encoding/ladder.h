@@ -0,0 +1,37 @@
+#ifndef VC_LADDER_H
+#define VC_LADDER_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <stdint.h>
+
+#define VC_LADDER_MAX_RENDITIONS    8
+#define VC_LADDER_MAX_BLOCKS        64      // converted blocks in flight, bounds how far the reader runs ahead
+
+typedef struct
+{
+    float               fQuality;
+    gchar               *pPath;
+    int                 status;
+    int64_t             nBytes;
+    double              dBitrate;           // kbit/s
+
+} VcLadderRendition;
+
+typedef struct 
+{
+    GFileInputStream    *pInFileStream;
+    GtkTextView         *pLogView;
+    GSourceFunc         cbOnFinished;
+    uint64_t            nStartFrame;
+    uint64_t            nEndFrame;          // 0 encodes up to the end of the file
+    int                 nRenditions;
+    VcLadderRendition   renditions[VC_LADDER_MAX_RENDITIONS];
+    double              dDuration;
+
+} VcLadderOptions;
+
+gchar       *VcLadderRenditionPath(const char *basePath, float quality);
+GThread     *VcEncodeLadder(VcLadderOptions *options);
+void        VcLadderRenditionsClear(VcLadderOptions *options);
+
+#endif // VC_LADDER_H
@@ -0,0 +1,167 @@
+#include "live.h"
+#include <gio/gunixoutputstream.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+
+typedef struct
+{
+    gsize               nSize;
+    unsigned char       data[];
+
+} VcLivePage;
+
+// Queued after the last page, tells the writer to stop
+static VcLivePage stopPage = { 0 };
+
+// A pipe without a reader refuses a non-blocking open, it is retried until one connects or the encode
+// ends. Pages queue up meanwhile, audio is dropped once the queue is full but the headers wait.
+static int VcLiveSinkOpenPath(VcLiveSink *sink)
+{
+    int fd;
+    while ((fd = open(sink->pPath, O_WRONLY | O_APPEND | O_CREAT | O_NONBLOCK, 0644)) < 0)
+    {
+        if (errno != ENXIO || g_atomic_int_get(&sink->nStopping))
+        {
+            g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't open %s for live output: %s", sink->pPath, g_strerror(errno));
+            return -1;
+        }
+
+        g_usleep(VC_LIVE_OPEN_WAIT);
+    }
+
+    // Writes block again once it is open, the writer thread is there to wait on them
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    sink->pOut = g_unix_output_stream_new(fd, true);
+    return 0;
+}
+
+static gpointer VcLiveSinkWriterThread(gpointer data)
+{
+    VcLiveSink *sink = (VcLiveSink *)data;
+
+    if (sink->pOut == NULL && VcLiveSinkOpenPath(sink) < 0)
+    {
+        g_atomic_int_set(&sink->nFailed, 1);
+    }
+
+    for (;;)
+    {
+        VcLivePage *page = g_async_queue_pop(sink->queue);
+        if (page == &stopPage)
+        {
+            break;
+        }
+
+        // After a failure the rest of the queue is only drained. A pipe whose reader went away
+        // fails with EPIPE here, the SIGPIPE that comes with it is ignored from main.
+        GError *error = NULL;
+        if (!g_atomic_int_get(&sink->nFailed)
+            && (!g_output_stream_write_all(sink->pOut, page->data, page->nSize, NULL, NULL, &error)
+            || !g_output_stream_flush(sink->pOut, NULL, &error)))
+        {
+            g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Live output failed, continuing without it: %s", error->message);
+            g_error_free(error);
+            g_atomic_int_set(&sink->nFailed, 1);
+        }
+
+        g_free(page);
+    }
+
+    return NULL;
+}
+
+static int VcLiveSinkStart(VcLiveSink *sink)
+{
+    sink->queue = g_async_queue_new();
+    sink->writer = g_thread_new("live-writer", VcLiveSinkWriterThread, sink);
+    return 0;
+}
+
+int VcLiveSinkOpen(VcLiveSink *sink, const char *target, GError **error)
+{
+    memset(sink, 0, sizeof(VcLiveSink));
+
+    if (g_str_has_prefix(target, VC_LIVE_TCP_PREFIX))
+    {
+        // A listener that stops reading fails the writer instead of holding it until the encode ends
+        GSocketClient *client = g_socket_client_new();
+        g_socket_client_set_timeout(client, VC_LIVE_TIMEOUT);
+        sink->connection = g_socket_client_connect_to_host(client, target + strlen(VC_LIVE_TCP_PREFIX), VC_LIVE_PORT, NULL, error);
+        g_object_unref(client);
+        if (sink->connection == NULL)
+        {
+            return -1;
+        }
+
+        sink->pOut = g_object_ref(g_io_stream_get_output_stream(G_IO_STREAM(sink->connection)));
+        return VcLiveSinkStart(sink);
+    }
+
+    sink->pPath = g_strdup(target);
+    return VcLiveSinkStart(sink);
+}
+
+// Called from the encoder thread, never waits on the listener. When the writer falls behind,
+// audio pages are skipped whole and the listener resyncs on the next one; essential pages
+// (the stream headers) are always queued. Returns -1 once the writer has failed.
+int VcLiveSinkPush(VcLiveSink *sink, const unsigned char *header, long headerLen, const unsigned char *body, long bodyLen, bool essential)
+{
+    if (sink->writer == NULL || g_atomic_int_get(&sink->nFailed))
+    {
+        return -1;
+    }
+
+    if (!essential && g_async_queue_length(sink->queue) >= VC_LIVE_QUEUE_PAGES)
+    {
+        sink->nDropped++;
+        return 0;
+    }
+
+    VcLivePage *page = g_malloc(sizeof(VcLivePage) + headerLen + bodyLen);
+    page->nSize = headerLen + bodyLen;
+    memcpy(page->data, header, headerLen);
+    memcpy(page->data + headerLen, body, bodyLen);
+    g_async_queue_push(sink->queue, page);
+    return 0;
+}
+
+// Writes out what is still queued and stops the writer, -1 if the output was lost
+int VcLiveSinkFinish(VcLiveSink *sink)
+{
+    if (sink->writer != NULL)
+    {
+        g_atomic_int_set(&sink->nStopping, 1);
+        g_async_queue_push(sink->queue, &stopPage);
+        g_thread_join(sink->writer);
+        sink->writer = NULL;
+    }
+
+    return g_atomic_int_get(&sink->nFailed) ? -1 : 0;
+}
+
+void VcLiveSinkClose(VcLiveSink *sink)
+{
+    VcLiveSinkFinish(sink);
+
+    if (sink->queue != NULL)
+    {
+        g_async_queue_unref(sink->queue);
+    }
+
+    if (sink->pOut != NULL)
+    {
+        g_output_stream_close(sink->pOut, NULL, NULL);
+        g_object_unref(sink->pOut);
+    }
+
+    if (sink->connection != NULL)
+    {
+        g_io_stream_close(G_IO_STREAM(sink->connection), NULL, NULL);
+        g_object_unref(sink->connection);
+    }
+
+    g_free(sink->pPath);
+
+    memset(sink, 0, sizeof(VcLiveSink));
+}
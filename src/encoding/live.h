@@ -0,0 +1,35 @@
+#ifndef VC_LIVE_H
+#define VC_LIVE_H
+
+#include <gio/gio.h>
+#include <stdbool.h>
+
+#define VC_LIVE_TCP_PREFIX  "tcp://"
+#define VC_LIVE_PORT        8000    // used when a tcp target doesn't name one
+#define VC_LIVE_QUEUE_PAGES 64      // pages waiting for the writer before audio pages are dropped
+#define VC_LIVE_TIMEOUT     5       // seconds a stalled tcp listener gets before it is dropped
+#define VC_LIVE_OPEN_WAIT   50000   // microseconds between attempts to open a pipe nothing reads yet
+
+// Where a live encode sends its pages: a TCP connection for "tcp://host:port",
+// anything else is taken as the path of a pipe or file to append to. Pages are
+// written on their own thread so a slow listener never holds up the encoder.
+typedef struct
+{
+    GSocketConnection   *connection;
+    GOutputStream       *pOut;
+    gchar               *pPath;             // pipe or file, opened by the writer once the pipe has a reader
+
+    GAsyncQueue         *queue;             // pages for the writer thread
+    GThread             *writer;
+    gint                nFailed;            // set by the writer, no more pages are taken
+    gint                nStopping;          // the encode is done, a pipe still without a reader is given up
+    int                 nDropped;           // audio pages skipped while the queue was full
+
+} VcLiveSink;
+
+int     VcLiveSinkOpen(VcLiveSink *sink, const char *target, GError **error);
+int     VcLiveSinkPush(VcLiveSink *sink, const unsigned char *header, long headerLen, const unsigned char *body, long bodyLen, bool essential);
+int     VcLiveSinkFinish(VcLiveSink *sink);
+void    VcLiveSinkClose(VcLiveSink *sink);
+
+#endif // VC_LIVE_H
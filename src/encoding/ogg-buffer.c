@@ -0,0 +1,159 @@
+#include "ogg-buffer.h"
+#include <string.h>
+
+VcOggBuffer *VcOggBufferNew()
+{
+    VcOggBuffer *buffer = g_new0(VcOggBuffer, 1);
+    buffer->data = g_byte_array_new();
+    buffer->refCount = 1;
+    g_mutex_init(&buffer->lock);
+    g_cond_init(&buffer->grown);
+    return buffer;
+}
+
+VcOggBuffer *VcOggBufferRef(VcOggBuffer *buffer)
+{
+    g_atomic_int_inc(&buffer->refCount);
+    return buffer;
+}
+
+void VcOggBufferUnref(VcOggBuffer *buffer)
+{
+    if (buffer == NULL || !g_atomic_int_dec_and_test(&buffer->refCount))
+    {
+        return;
+    }
+
+    g_byte_array_unref(buffer->data);
+    g_mutex_clear(&buffer->lock);
+    g_cond_clear(&buffer->grown);
+    g_free(buffer);
+}
+
+void VcOggBufferAppend(VcOggBuffer *buffer, const void *data, size_t size)
+{
+    g_mutex_lock(&buffer->lock);
+    g_byte_array_append(buffer->data, data, size);
+    g_cond_broadcast(&buffer->grown);
+    g_mutex_unlock(&buffer->lock);
+}
+
+// Replaces bytes that were already appended, used to patch the header pages once an encode is done
+void VcOggBufferOverwrite(VcOggBuffer *buffer, size_t offset, const void *data, size_t size)
+{
+    g_mutex_lock(&buffer->lock);
+    if (offset + size <= buffer->data->len)
+    {
+        memcpy(buffer->data->data + offset, data, size);
+    }
+    g_mutex_unlock(&buffer->lock);
+}
+
+void VcOggBufferFinish(VcOggBuffer *buffer)
+{
+    g_mutex_lock(&buffer->lock);
+    buffer->finished = true;
+    g_cond_broadcast(&buffer->grown);
+    g_mutex_unlock(&buffer->lock);
+}
+
+// Lets a reader open the stream only once it can be opened without waiting, the callback
+// runs right away (on the main context) if the headers are already there
+void VcOggBufferOnHeaders(VcOggBuffer *buffer, GSourceFunc callback)
+{
+    g_mutex_lock(&buffer->lock);
+    buffer->cbOnHeaders = callback;
+    bool ready = buffer->headersReady;
+    g_mutex_unlock(&buffer->lock);
+
+    if (ready && callback != NULL)
+    {
+        g_main_context_invoke(NULL, callback, VcOggBufferRef(buffer));
+    }
+}
+
+// Called by the encoder once the header pages have been appended
+void VcOggBufferMarkHeaders(VcOggBuffer *buffer)
+{
+    g_mutex_lock(&buffer->lock);
+    GSourceFunc callback = buffer->headersReady ? NULL : buffer->cbOnHeaders;
+    buffer->headersReady = true;
+    g_mutex_unlock(&buffer->lock);
+
+    if (callback != NULL)
+    {
+        g_main_context_invoke(NULL, callback, VcOggBufferRef(buffer));
+    }
+}
+
+size_t VcOggBufferRead(VcOggBuffer *buffer, size_t offset, void *dst, size_t size)
+{
+    g_mutex_lock(&buffer->lock);
+    size_t available = offset < buffer->data->len ? buffer->data->len - offset : 0;
+    size_t nBytes = size < available ? size : available;
+    memcpy(dst, buffer->data->data + offset, nBytes);
+    g_mutex_unlock(&buffer->lock);
+
+    return nBytes;
+}
+
+// Like VcOggBufferRead, but if the reader caught up with the encoder waits up to
+// timeout microseconds for more pages. Returns 0 on timeout or at the end of a finished buffer.
+size_t VcOggBufferReadWait(VcOggBuffer *buffer, size_t offset, void *dst, size_t size, gint64 timeout)
+{
+    gint64 deadline = g_get_monotonic_time() + timeout;
+
+    g_mutex_lock(&buffer->lock);
+    while (offset >= buffer->data->len && !buffer->finished)
+    {
+        if (!g_cond_wait_until(&buffer->grown, &buffer->lock, deadline))
+        {
+            break;
+        }
+    }
+
+    size_t available = offset < buffer->data->len ? buffer->data->len - offset : 0;
+    size_t nBytes = size < available ? size : available;
+    memcpy(dst, buffer->data->data + offset, nBytes);
+    g_mutex_unlock(&buffer->lock);
+
+    return nBytes;
+}
+
+// Waits up to timeout for data past offset without reading it, false if none came
+bool VcOggBufferWait(VcOggBuffer *buffer, size_t offset, gint64 timeout)
+{
+    gint64 deadline = g_get_monotonic_time() + timeout;
+
+    g_mutex_lock(&buffer->lock);
+    while (offset >= buffer->data->len && !buffer->finished)
+    {
+        if (!g_cond_wait_until(&buffer->grown, &buffer->lock, deadline))
+        {
+            break;
+        }
+    }
+
+    bool available = offset < buffer->data->len;
+    g_mutex_unlock(&buffer->lock);
+
+    return available;
+}
+
+size_t VcOggBufferGetSize(VcOggBuffer *buffer)
+{
+    g_mutex_lock(&buffer->lock);
+    size_t size = buffer->data->len;
+    g_mutex_unlock(&buffer->lock);
+
+    return size;
+}
+
+bool VcOggBufferIsFinished(VcOggBuffer *buffer)
+{
+    g_mutex_lock(&buffer->lock);
+    bool finished = buffer->finished;
+    g_mutex_unlock(&buffer->lock);
+
+    return finished;
+}
@@ -0,0 +1,36 @@
+#ifndef VC_OGG_BUFFER_H
+#define VC_OGG_BUFFER_H
+
+#include <glib.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Reference counted in-memory copy of an encoded Ogg stream, shared between 
+// the encoder that appends pages and the player that reads them back.
+typedef struct
+{
+    GByteArray  *data;
+    GMutex      lock;
+    GCond       grown;
+    gboolean    finished;
+    gint        refCount;
+    gboolean    headersReady;
+    GSourceFunc cbOnHeaders;    // invoked on the main context once the header pages are in, with a reference it must drop
+
+} VcOggBuffer;
+
+VcOggBuffer *VcOggBufferNew();
+VcOggBuffer *VcOggBufferRef(VcOggBuffer *buffer);
+void        VcOggBufferUnref(VcOggBuffer *buffer);
+void        VcOggBufferAppend(VcOggBuffer *buffer, const void *data, size_t size);
+void        VcOggBufferOverwrite(VcOggBuffer *buffer, size_t offset, const void *data, size_t size);
+void        VcOggBufferFinish(VcOggBuffer *buffer);
+void        VcOggBufferOnHeaders(VcOggBuffer *buffer, GSourceFunc callback);
+void        VcOggBufferMarkHeaders(VcOggBuffer *buffer);
+size_t      VcOggBufferRead(VcOggBuffer *buffer, size_t offset, void *dst, size_t size);
+size_t      VcOggBufferReadWait(VcOggBuffer *buffer, size_t offset, void *dst, size_t size, gint64 timeout);
+bool        VcOggBufferWait(VcOggBuffer *buffer, size_t offset, gint64 timeout);
+size_t      VcOggBufferGetSize(VcOggBuffer *buffer);
+bool        VcOggBufferIsFinished(VcOggBuffer *buffer);
+
+#endif // VC_OGG_BUFFER_H
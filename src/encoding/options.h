@@ -2,6 +2,11 @@
 #define VC_OPTIONS_H
 
 #include <gtk-4.0/gtk/gtk.h>
+#include "seek-index.h"
+#include "ogg-buffer.h"
+#include "vorbis-encoder.h"
+#include "../dsp/resampler.h"
+#include "../dsp/channel-mix.h"
 
 #define VC_PATH_LEN 260
 
@@ -9,9 +14,35 @@ typedef struct
 {
     GFileInputStream    *pInFileStream;
     GFileOutputStream   *pOutFileStream;
+    GFile               *pOutFile;          // the file pOutFileStream writes, read back by the integrity check
     GtkTextView         *pLogView;
     GSourceFunc         cbOnFinished;
-    float               fDesiredQuality;
+    VcEncoderTuning     tuning;             // rate mode, quality and encoder knobs
+    VcSeekIndex         *pSeekIndex;        // optional, filled with page offsets as they are written
+    VcOggBuffer         *pOggBuffer;        // optional, receives a copy of every page for in-memory playback
+    uint64_t            nStartFrame;        // first frame to encode
+    uint64_t            nEndFrame;          // frame to stop at, 0 encodes up to the end of the file
+    long                nOutputRate;        // sample rate to encode at, 0 keeps the input rate
+    VcResampleQuality   resampleQuality;
+    VcMixLayout         mixLayout;          // channels to encode, multichannel input can be folded down
+    bool                bLoudnessTags;      // measure loudness while encoding and tag the output with it
+    bool                bTrimLeading;       // drop silence at the start
+    bool                bTrimTrailing;      // drop silence at the end
+    double              dSilenceThreshold;  // dBFS, samples at or under it count as silent
+    double              dMinSilence;        // seconds, shorter runs are left alone
+    bool                bCheckIntegrity;    // check every written page decodes and the stream adds up
+    bool                bVerify;            // decode the output in memory as it is written and compare it with the source
+    double              dSegmentSeconds;    // split the output into independently decodable links this long, 0 writes one stream
+    bool                bSegmentFiles;      // also write every segment to a file of its own
+    gchar               *pOutPath;          // where pOutFileStream points, segment files and the manifest are named after it
+    gchar               *pLiveTarget;       // also stream pages to "tcp://host:port" or a pipe, NULL or empty for none
+    int                 nLiveLatencyMs;     // longest a page may hold audio back from the live sink
+    int                 nLivePageBytes;     // target page size for the live sink, 0 keeps libogg's
+    bool                bFollow;            // the input is still being recorded, keep encoding it as it grows
+    gchar               *pFollowSentinel;   // file whose appearance marks the end of the recording
+    double              dFollowIdle;        // seconds without growth that also end it, 0 waits for the sentinel or the header
+    gint                nFollowCancel;      // set from the UI to stop following, what was read so far is still encoded
+    gint                *pAbort;            // optional, set from another thread to give up, the encode fails unfinished
 
 } VcEncodeOptions;
 
@@ -0,0 +1,88 @@
+#include "pcm-block.h"
+
+VcPcmBlockPool *VcPcmBlockPoolNew(int channels, int capacity, int maxBlocks)
+{
+    VcPcmBlockPool *pool = g_new0(VcPcmBlockPool, 1);
+    pool->nChannels = channels;
+    pool->nCapacity = capacity;
+    pool->nMaxBlocks = maxBlocks;
+    g_mutex_init(&pool->lock);
+    g_cond_init(&pool->released);
+    return pool;
+}
+
+static void VcPcmBlockFree(VcPcmBlock *block)
+{
+    for (int ch = 0; ch < block->nChannels; ch++)
+    {
+        g_free(block->channels[ch]);
+    }
+
+    g_free(block->channels);
+    g_free(block);
+}
+
+// Every acquired block has to be released before the pool is freed
+void VcPcmBlockPoolFree(VcPcmBlockPool *pool)
+{
+    g_slist_free_full(pool->free, (GDestroyNotify)VcPcmBlockFree);
+    g_mutex_clear(&pool->lock);
+    g_cond_clear(&pool->released);
+    g_free(pool);
+}
+
+VcPcmBlock *VcPcmBlockAcquire(VcPcmBlockPool *pool)
+{
+    VcPcmBlock *block = NULL;
+
+    g_mutex_lock(&pool->lock);
+    while (pool->nInFlight >= pool->nMaxBlocks)
+    {
+        g_cond_wait(&pool->released, &pool->lock);
+    }
+
+    pool->nInFlight++;
+    if (pool->free != NULL)
+    {
+        block = pool->free->data;
+        pool->free = g_slist_delete_link(pool->free, pool->free);
+    }
+    g_mutex_unlock(&pool->lock);
+
+    if (block == NULL)
+    {
+        block = g_new0(VcPcmBlock, 1);
+        block->nChannels = pool->nChannels;
+        block->channels = g_new(float *, pool->nChannels);
+        for (int ch = 0; ch < pool->nChannels; ch++)
+        {
+            block->channels[ch] = g_new(float, pool->nCapacity);
+        }
+        block->pool = pool;
+    }
+
+    block->refCount = 1;
+    block->nFrames = 0;
+    return block;
+}
+
+VcPcmBlock *VcPcmBlockRef(VcPcmBlock *block)
+{
+    g_atomic_int_inc(&block->refCount);
+    return block;
+}
+
+void VcPcmBlockUnref(VcPcmBlock *block)
+{
+    if (!g_atomic_int_dec_and_test(&block->refCount))
+    {
+        return;
+    }
+
+    VcPcmBlockPool *pool = block->pool;
+    g_mutex_lock(&pool->lock);
+    pool->free = g_slist_prepend(pool->free, block);
+    pool->nInFlight--;
+    g_cond_signal(&pool->released);
+    g_mutex_unlock(&pool->lock);
+}
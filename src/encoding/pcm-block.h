@@ -0,0 +1,38 @@
+#ifndef VC_PCM_BLOCK_H
+#define VC_PCM_BLOCK_H
+
+#include <glib.h>
+
+typedef struct VcPcmBlockPool VcPcmBlockPool;
+
+// Reference counted block of planar float frames, fanned out read-only to several consumers
+typedef struct
+{
+    gint            refCount;
+    int             nFrames;
+    int             nChannels;
+    float           **channels;
+    VcPcmBlockPool  *pool;
+
+} VcPcmBlock;
+
+// Recycles blocks and bounds how many are in flight, so a fast reader 
+// can't run arbitrarily far ahead of its slowest consumer.
+struct VcPcmBlockPool
+{
+    GMutex          lock;
+    GCond           released;
+    GSList          *free;
+    int             nInFlight;
+    int             nMaxBlocks;
+    int             nChannels;
+    int             nCapacity;
+};
+
+VcPcmBlockPool  *VcPcmBlockPoolNew(int channels, int capacity, int maxBlocks);
+void            VcPcmBlockPoolFree(VcPcmBlockPool *pool);
+VcPcmBlock      *VcPcmBlockAcquire(VcPcmBlockPool *pool);
+VcPcmBlock      *VcPcmBlockRef(VcPcmBlock *block);
+void            VcPcmBlockUnref(VcPcmBlock *block);
+
+#endif // VC_PCM_BLOCK_H
@@ -0,0 +1,106 @@
+#include "pcm-ring.h"
+#include <string.h>
+
+#define VC_PCM_RING_NAP 50  // microseconds
+
+int VcPcmRingInit(VcPcmRing *ring, int channels, int capacity, int slots)
+{
+    memset(ring, 0, sizeof(VcPcmRing));
+    if (channels <= 0 || capacity <= 0 || slots < 2 || (slots & (slots - 1)) != 0)
+    {
+        return -1;
+    }
+
+    ring->nSlots = slots;
+    ring->nChannels = channels;
+    ring->nCapacity = capacity;
+    ring->slots = g_new0(VcPcmSlot, slots);
+    for (int i = 0; i < slots; i++)
+    {
+        ring->slots[i].channels = g_new(float *, channels);
+        for (int ch = 0; ch < channels; ch++)
+        {
+            ring->slots[i].channels[ch] = g_new(float, capacity);
+        }
+    }
+
+    return 0;
+}
+
+static void VcPcmRingWait(int *spins)
+{
+    if (++*spins < VC_PCM_RING_SPINS)
+    {
+        g_thread_yield();
+    }
+
+    else
+    {
+        g_usleep(VC_PCM_RING_NAP);
+    }
+}
+
+// NULL once the ring has been aborted
+VcPcmSlot *VcPcmRingAcquireWrite(VcPcmRing *ring)
+{
+    int spins = 0;
+    int head = ring->head;
+    while (head - g_atomic_int_get(&ring->tail) >= ring->nSlots)
+    {
+        if (g_atomic_int_get(&ring->aborted))
+        {
+            return NULL;
+        }
+        VcPcmRingWait(&spins);
+    }
+
+    return g_atomic_int_get(&ring->aborted) ? NULL : &ring->slots[head & (ring->nSlots - 1)];
+}
+
+// Publishes the acquired slot, its frames have to be written before this
+void VcPcmRingCommit(VcPcmRing *ring)
+{
+    g_atomic_int_set(&ring->head, ring->head + 1);
+}
+
+VcPcmSlot *VcPcmRingAcquireRead(VcPcmRing *ring)
+{
+    int spins = 0;
+    int tail = ring->tail;
+    while (g_atomic_int_get(&ring->head) == tail)
+    {
+        if (g_atomic_int_get(&ring->aborted))
+        {
+            return NULL;
+        }
+        VcPcmRingWait(&spins);
+    }
+
+    return &ring->slots[tail & (ring->nSlots - 1)];
+}
+
+void VcPcmRingRelease(VcPcmRing *ring)
+{
+    g_atomic_int_set(&ring->tail, ring->tail + 1);
+}
+
+// Either side gives up, the other one gets NULL instead of waiting forever
+void VcPcmRingAbort(VcPcmRing *ring)
+{
+    g_atomic_int_set(&ring->aborted, 1);
+}
+
+void VcPcmRingClear(VcPcmRing *ring)
+{
+    for (int i = 0; i < ring->nSlots; i++)
+    {
+        for (int ch = 0; ch < ring->nChannels; ch++)
+        {
+            g_free(ring->slots[i].channels[ch]);
+        }
+        g_free(ring->slots[i].channels);
+    }
+
+    g_free(ring->slots);
+    memset(ring, 0, sizeof(VcPcmRing));
+}
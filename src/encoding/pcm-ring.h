@@ -0,0 +1,39 @@
+#ifndef VC_PCM_RING_H
+#define VC_PCM_RING_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <stdbool.h>
+
+#define VC_PCM_RING_SPINS 64    // yields before a waiting side starts sleeping
+
+typedef struct
+{
+    int                 nFrames;            // 0 marks the end of the stream
+    float               **channels;
+
+} VcPcmSlot;
+
+// Single producer, single consumer ring of planar float slots. The two indices are only ever
+// advanced by their own side, so handing a slot over is one atomic store and no lock is taken.
+// A side that finds the ring full or empty yields for a while and then naps.
+typedef struct
+{
+    VcPcmSlot           *slots;
+    int                 nSlots;             // power of two
+    int                 nChannels;
+    int                 nCapacity;          // frames per slot
+    gint                head;               // next slot to write, producer only
+    gint                tail;               // next slot to read, consumer only
+    gint                aborted;
+
+} VcPcmRing;
+
+int         VcPcmRingInit(VcPcmRing *ring, int channels, int capacity, int slots);
+VcPcmSlot   *VcPcmRingAcquireWrite(VcPcmRing *ring);
+void        VcPcmRingCommit(VcPcmRing *ring);
+VcPcmSlot   *VcPcmRingAcquireRead(VcPcmRing *ring);
+void        VcPcmRingRelease(VcPcmRing *ring);
+void        VcPcmRingAbort(VcPcmRing *ring);
+void        VcPcmRingClear(VcPcmRing *ring);
+
+#endif // VC_PCM_RING_H
@@ -0,0 +1,231 @@
+#include "preview.h"
+#include "wave.h"
+#include "vorbis-encoder.h"
+#include "../gui/log-view.h"
+#include <string.h>
+
+typedef struct
+{
+    VcPcmClip           *clip;
+    VcPreviewResult     *result;
+
+} VcPreviewJob;
+
+int VcPcmClipRead(VcPcmClip *clip, GInputStream *stream, uint64_t startFrame, uint64_t endFrame, VcMixLayout layout, GtkTextView *logView)
+{
+    VcWaveReader reader;
+    GError *error = NULL;
+    memset(clip, 0, sizeof(VcPcmClip));
+
+    if (VcWaveReaderOpen(&reader, stream, startFrame, endFrame, logView) < 0)
+    {
+        VcWaveReaderClose(&reader);
+        return -1;
+    }
+
+    if (layout != VC_MIX_KEEP)
+    {
+        VcWaveReaderSetLayout(&reader, layout);
+    }
+
+    clip->nChannels = reader.nChannels;
+    clip->nRate = reader.info.common.nSamplesPerSec;
+    clip->nFrames = reader.nFramesLeft;
+    clip->channels = g_new0(float *, clip->nChannels);
+    for (int ch = 0; ch < clip->nChannels; ch++)
+    {
+        clip->channels[ch] = g_new(float, clip->nFrames);
+    }
+
+    // The whole excerpt is converted exactly once, straight into the shared buffers
+    float **block = g_new(float *, clip->nChannels);
+    uint64_t offset = 0;
+    while (offset < clip->nFrames)
+    {
+        for (int ch = 0; ch < clip->nChannels; ch++)
+        {
+            block[ch] = clip->channels[ch] + offset;
+        }
+
+        long frames = VcWaveReaderRead(&reader, block, VC_WAVE_BLOCK_FRAMES, &error);
+        if (frames <= 0)
+        {
+            break;
+        }
+
+        offset += frames;
+    }
+
+    g_free(block);
+    VcWaveReaderClose(&reader);
+    clip->nFrames = offset;
+
+    if (error != NULL)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+        VcPcmClipClear(clip);
+        return -1;
+    }
+
+    return 0;
+}
+
+// Adds frames to the end of the clip, nChannels and nRate have to be set before the first call
+void VcPcmClipAppend(VcPcmClip *clip, float **pcm, uint64_t frames)
+{
+    if (clip->channels == NULL)
+    {
+        clip->channels = g_new0(float *, clip->nChannels);
+    }
+
+    for (int ch = 0; ch < clip->nChannels; ch++)
+    {
+        clip->channels[ch] = g_renew(float, clip->channels[ch], clip->nFrames + frames);
+        memcpy(clip->channels[ch] + clip->nFrames, pcm[ch], frames * sizeof(float));
+    }
+
+    clip->nFrames += frames;
+}
+
+void VcPcmClipClear(VcPcmClip *clip)
+{
+    for (int ch = 0; ch < clip->nChannels && clip->channels != NULL; ch++)
+    {
+        g_free(clip->channels[ch]);
+    }
+
+    g_free(clip->channels);
+    memset(clip, 0, sizeof(VcPcmClip));
+}
+
+int VcPcmClipEncode(VcPcmClip *clip, const VcEncoderTuning *tuning, VcOggBuffer *buffer, size_t *nBytes, size_t *nHeaderBytes)
+{
+    VcVorbisEncoder encoder;
+    GError *error = NULL;
+
+    int status = VcVorbisEncoderInitTuned(&encoder, clip->nChannels, clip->nRate, tuning);
+    encoder.pOggBuffer = buffer;
+    if (status == 0)
+    {
+        status = VcVorbisEncoderWriteHeaders(&encoder, &error);
+    }
+
+    if (nHeaderBytes != NULL)
+    {
+        *nHeaderBytes = encoder.nBytesWritten;
+    }
+
+    float **block = g_new(float *, clip->nChannels);
+    for (uint64_t offset = 0; status == 0 && offset < clip->nFrames; offset += VC_WAVE_BLOCK_FRAMES)
+    {
+        for (int ch = 0; ch < clip->nChannels; ch++)
+        {
+            block[ch] = clip->channels[ch] + offset;
+        }
+
+        status = VcVorbisEncoderWrite(&encoder, block, (int)MIN(VC_WAVE_BLOCK_FRAMES, clip->nFrames - offset), &error);
+    }
+    g_free(block);
+
+    if (status == 0)
+    {
+        status = VcVorbisEncoderFinish(&encoder, &error);
+    }
+
+    if (error != NULL)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+    }
+
+    if (nBytes != NULL)
+    {
+        *nBytes = encoder.nBytesWritten;
+    }
+
+    VcVorbisEncoderClear(&encoder);
+    if (buffer != NULL)
+    {
+        VcOggBufferFinish(buffer);
+    }
+
+    return status;
+}
+
+gpointer VcPreviewEncodeCallback(gpointer data)
+{
+    VcPreviewJob *job = (VcPreviewJob *)data;
+    VcPreviewResult *result = job->result;
+    GTimer *timer = g_timer_new();
+
+    VcEncoderTuning tuning = { .mode = VC_RATE_VBR, .fQuality = result->fQuality };
+    result->pOggBuffer = VcOggBufferNew();
+    result->status = VcPcmClipEncode(job->clip, &tuning, result->pOggBuffer, &result->nBytes, NULL);
+    result->dEncodeSeconds = g_timer_elapsed(timer, NULL);
+
+    double duration = (double)job->clip->nFrames / job->clip->nRate;
+    result->dBitrate = duration > 0.0 ? result->nBytes * 8.0 / duration / 1000.0 : 0.0;
+
+    g_timer_destroy(timer);
+    return NULL;
+}
+
+int VcPreviewCallback(VcPreviewOptions *options)
+{
+    VcPcmClip clip;
+    GThread *workers[VC_PREVIEW_MAX_QUALITIES];
+    VcPreviewJob jobs[VC_PREVIEW_MAX_QUALITIES];
+
+    // Previews are meant for excerpts, an unbounded range only takes the start of the file
+    uint64_t endFrame = options->nEndFrame;
+    VcWaveInfo info;
+    if (VcReadWaveInfo(G_INPUT_STREAM(options->pInFileStream), &info, NULL) == 0)
+    {
+        uint64_t maxFrames = (uint64_t)info.common.nSamplesPerSec * VC_PREVIEW_MAX_SECONDS;
+        if (endFrame == 0 || endFrame - MIN(endFrame, options->nStartFrame) > maxFrames)
+        {
+            endFrame = options->nStartFrame + maxFrames;
+        }
+    }
+
+    if (VcPcmClipRead(&clip, G_INPUT_STREAM(options->pInFileStream), options->nStartFrame, endFrame, VC_MIX_KEEP, NULL) < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Failed to read the preview excerpt");
+        g_main_context_invoke(NULL, options->cbOnFinished, options);
+        return -1;
+    }
+
+    options->dDuration = (double)clip.nFrames / clip.nRate;
+
+    for (int i = 0; i < options->nQualities; i++)
+    {
+        jobs[i].clip = &clip;
+        jobs[i].result = &options->results[i];
+        workers[i] = g_thread_new("preview-encoder", VcPreviewEncodeCallback, &jobs[i]);
+    }
+
+    for (int i = 0; i < options->nQualities; i++)
+    {
+        g_thread_join(workers[i]);
+    }
+
+    VcPcmClipClear(&clip);
+    g_main_context_invoke(NULL, options->cbOnFinished, options);
+
+    return 0;
+}
+
+GThread *VcEncodePreviews(VcPreviewOptions *options)
+{
+    return g_thread_new("preview", VcPreviewCallback, options);
+}
+
+void VcPreviewResultsClear(VcPreviewOptions *options)
+{
+    for (int i = 0; i < VC_PREVIEW_MAX_QUALITIES; i++)
+    {
+        VcOggBufferUnref(options->results[i].pOggBuffer);
+        memset(&options->results[i], 0, sizeof(VcPreviewResult));
+    }
+}
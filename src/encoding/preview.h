@@ -0,0 +1,55 @@
+#ifndef VC_PREVIEW_H
+#define VC_PREVIEW_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <stdint.h>
+#include "ogg-buffer.h"
+#include "vorbis-encoder.h"
+#include "../dsp/channel-mix.h"
+
+#define VC_PREVIEW_MAX_QUALITIES    8
+#define VC_PREVIEW_MAX_SECONDS      60
+
+typedef struct
+{
+    float               fQuality;
+    int                 status;
+    size_t              nBytes;
+    double              dBitrate;           // kbit/s
+    double              dEncodeSeconds;
+    VcOggBuffer         *pOggBuffer;
+
+} VcPreviewResult;
+
+typedef struct 
+{
+    GFileInputStream    *pInFileStream;
+    GtkTextView         *pLogView;
+    GSourceFunc         cbOnFinished;
+    uint64_t            nStartFrame;
+    uint64_t            nEndFrame;          // 0 previews up to VC_PREVIEW_MAX_SECONDS from the start
+    int                 nQualities;
+    VcPreviewResult     results[VC_PREVIEW_MAX_QUALITIES];
+    double              dDuration;
+
+} VcPreviewOptions;
+
+// Planar float copy of an input excerpt, shared read-only by every encoder working on it
+typedef struct
+{
+    float               **channels;
+    int                 nChannels;
+    long                nRate;
+    uint64_t            nFrames;
+
+} VcPcmClip;
+
+int         VcPcmClipRead(VcPcmClip *clip, GInputStream *stream, uint64_t startFrame, uint64_t endFrame, VcMixLayout layout, GtkTextView *logView);
+void        VcPcmClipAppend(VcPcmClip *clip, float **pcm, uint64_t frames);
+void        VcPcmClipClear(VcPcmClip *clip);
+int         VcPcmClipEncode(VcPcmClip *clip, const VcEncoderTuning *tuning, VcOggBuffer *buffer, size_t *nBytes, size_t *nHeaderBytes);
+
+GThread     *VcEncodePreviews(VcPreviewOptions *options);
+void        VcPreviewResultsClear(VcPreviewOptions *options);
+
+#endif // VC_PREVIEW_H
@@ -0,0 +1,161 @@
+#include "seek-index.h"
+#include <gio/gio.h>
+
+#define VC_SEEK_INDEX_READ_SIZE 65536
+
+VcSeekIndex *VcSeekIndexNew()
+{
+    VcSeekIndex *index = g_new0(VcSeekIndex, 1);
+    index->points = g_array_new(false, false, sizeof(VcSeekPoint));
+    return index;
+}
+
+void VcSeekIndexFree(VcSeekIndex *index)
+{
+    if (index == NULL)
+    {
+        return;
+    }
+
+    g_array_free(index->points, true);
+    g_free(index);
+}
+
+void VcSeekIndexAddPage(VcSeekIndex *index, ogg_page *page, int64_t offset)
+{
+    // Header pages have a granule of 0 and pages without a finished packet -1, 
+    // neither can be used as a seek target.
+    int64_t granule = ogg_page_granulepos(page);
+    if (granule > 0)
+    {
+        VcSeekIndexAddPoint(index, granule, offset);
+    }
+}
+
+// Granules of later links in a chained stream are passed on top of the samples before them
+void VcSeekIndexAddPoint(VcSeekIndex *index, int64_t granule, int64_t offset)
+{
+    if (index->points->len > 0 && g_array_index(index->points, VcSeekPoint, index->points->len - 1).granule > granule)
+    {
+        return;
+    }
+
+    VcSeekPoint point = { .granule = granule, .offset = offset };
+    g_array_append_val(index->points, point);
+}
+
+int VcSeekIndexBuild(VcSeekIndex *index, const char *path)
+{
+    GError *error = NULL;
+    GFile *file = g_file_new_for_path(path);
+    GFileInputStream *stream = g_file_read(file, NULL, &error);
+    g_object_unref(file);
+    if (error != NULL)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+        return -1;
+    }
+
+    ogg_sync_state sync;
+    ogg_page page;
+    ogg_sync_init(&sync);
+
+    g_array_set_size(index->points, 0);
+
+    // Every link of a chained stream is indexed, its granules restart at 0 and are counted on top of
+    // the links before it, the same way the encoder indexes the links it writes
+    int serial = -1;
+    int64_t offset = 0;
+    int64_t linkStart = 0;
+    int64_t linkEnd = 0;
+    while (true)
+    {
+        long result = ogg_sync_pageseek(&sync, &page);
+        if (result > 0)
+        {
+            if (ogg_page_bos(&page) && ogg_page_serialno(&page) != serial)
+            {
+                // Streams multiplexed into the same link begin before any audio page
+                if (serial == -1 || linkEnd > 0)
+                {
+                    serial = ogg_page_serialno(&page);
+                    linkStart += linkEnd;
+                    linkEnd = 0;
+                }
+            }
+
+            int64_t granule = ogg_page_granulepos(&page);
+            if (ogg_page_serialno(&page) == serial && granule > 0)
+            {
+                VcSeekIndexAddPoint(index, linkStart + granule, offset);
+                linkEnd = MAX(linkEnd, granule);
+            }
+
+            offset += result;
+        }
+
+        else if (result < 0)
+        {
+            offset -= result;
+        }
+
+        else
+        {
+            char *buffer = ogg_sync_buffer(&sync, VC_SEEK_INDEX_READ_SIZE);
+            gssize nBytes = g_input_stream_read(G_INPUT_STREAM(stream), buffer, VC_SEEK_INDEX_READ_SIZE, NULL, &error);
+            if (error != NULL)
+            {
+                g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+                g_error_free(error);
+                break;
+            }
+
+            if (nBytes == 0)
+            {
+                break;
+            }
+
+            ogg_sync_wrote(&sync, nBytes);
+        }
+    }
+
+    ogg_sync_clear(&sync);
+    g_input_stream_close(G_INPUT_STREAM(stream), NULL, NULL);
+    g_object_unref(stream);
+
+    return index->points->len > 0 ? 0 : -1;
+}
+
+int64_t VcSeekIndexFind(VcSeekIndex *index, int64_t sample)
+{
+    // Past the last indexed page there is nothing to go on, vorbisfile bisects instead
+    if (index->points->len == 0 || sample > g_array_index(index->points, VcSeekPoint, index->points->len - 1).granule)
+    {
+        return -1;
+    }
+
+    // Find the last page that ends at or before the target. Decoding from its start 
+    // lands one page early, which leaves room for the lapping of the first packet.
+    guint low = 0, high = index->points->len;
+    while (low < high)
+    {
+        guint mid = (low + high) / 2;
+        if (g_array_index(index->points, VcSeekPoint, mid).granule <= sample)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    guint point = low > 0 ? low - 1 : 0;
+    return g_array_index(index->points, VcSeekPoint, point).offset;
+}
+
+bool VcSeekIndexIsEmpty(VcSeekIndex *index)
+{
+    return index->points->len == 0;
+}
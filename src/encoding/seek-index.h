@@ -0,0 +1,32 @@
+#ifndef VC_SEEK_INDEX_H
+#define VC_SEEK_INDEX_H
+
+#include <glib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ogg/ogg.h>
+
+typedef struct
+{
+    int64_t     granule;    // last sample completed on the page
+    int64_t     offset;     // byte offset of the page in the file
+
+} VcSeekPoint;
+
+// Granule to page offset table, sorted by granule. The links of a chained stream follow each
+// other, their granules counted on top of the samples before them.
+typedef struct
+{
+    GArray      *points;
+
+} VcSeekIndex;
+
+VcSeekIndex *VcSeekIndexNew();
+void        VcSeekIndexFree(VcSeekIndex *index);
+void        VcSeekIndexAddPage(VcSeekIndex *index, ogg_page *page, int64_t offset);
+void        VcSeekIndexAddPoint(VcSeekIndex *index, int64_t granule, int64_t offset);
+int         VcSeekIndexBuild(VcSeekIndex *index, const char *path);
+int64_t     VcSeekIndexFind(VcSeekIndex *index, int64_t sample);
+bool        VcSeekIndexIsEmpty(VcSeekIndex *index);
+
+#endif // VC_SEEK_INDEX_H
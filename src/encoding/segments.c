@@ -0,0 +1,126 @@
+#include "segments.h"
+#include <string.h>
+
+int VcSegmentWriterInit(VcSegmentWriter *writer, const char *outPath, long rate, bool files)
+{
+    memset(writer, 0, sizeof(VcSegmentWriter));
+    if (rate <= 0)
+    {
+        return -1;
+    }
+
+    const char *dot = strrchr(outPath, '.');
+    const char *slash = strrchr(outPath, G_DIR_SEPARATOR);
+    writer->pStem = dot != NULL && (slash == NULL || dot > slash) ? g_strndup(outPath, dot - outPath) : g_strdup(outPath);
+    writer->bFiles = files;
+    writer->nRate = rate;
+    writer->segments = g_array_new(false, true, sizeof(VcSegment));
+    return 0;
+}
+
+// Called before the headers of a new link are written
+int VcSegmentWriterBegin(VcSegmentWriter *writer, int64_t offset, int64_t startFrame, GError **error)
+{
+    VcSegment segment = { .nOffset = offset, .nStartFrame = startFrame };
+    if (writer->bFiles)
+    {
+        segment.pPath = g_strdup_printf("%s-%05u.ogg", writer->pStem, writer->segments->len);
+
+        GFile *file = g_file_new_for_path(segment.pPath);
+        GFileOutputStream *stream = g_file_replace(file, NULL, false, G_FILE_CREATE_REPLACE_DESTINATION, NULL, error);
+        g_object_unref(file);
+        if (stream == NULL)
+        {
+            g_free(segment.pPath);
+            return -1;
+        }
+
+        writer->pOut = G_OUTPUT_STREAM(stream);
+    }
+
+    g_array_append_val(writer->segments, segment);
+    return 0;
+}
+
+int VcSegmentWriterWrite(VcSegmentWriter *writer, const void *data, size_t size, GError **error)
+{
+    if (writer->pOut != NULL && !g_output_stream_write_all(writer->pOut, data, size, NULL, NULL, error))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+// Called once the end of stream page of the current link is out
+int VcSegmentWriterEnd(VcSegmentWriter *writer, int64_t offset, int64_t frames, GError **error)
+{
+    if (writer->segments->len == 0)
+    {
+        return 0;
+    }
+
+    VcSegment *segment = &g_array_index(writer->segments, VcSegment, writer->segments->len - 1);
+    segment->nBytes = offset - segment->nOffset;
+    segment->nFrames = frames;
+
+    if (writer->pOut == NULL)
+    {
+        return 0;
+    }
+
+    bool closed = g_output_stream_close(writer->pOut, NULL, error);
+    g_object_unref(writer->pOut);
+    writer->pOut = NULL;
+    return closed ? 0 : -1;
+}
+
+// Lists every segment with where it sits in the chained output and how long it plays,
+// returns the path of the manifest
+gchar *VcSegmentWriterWriteManifest(VcSegmentWriter *writer, const char *outPath, GError **error)
+{
+    gchar *chained = g_path_get_basename(outPath);
+    GString *csv = g_string_new("segment,file,offset,bytes,start,duration\n");
+    for (guint i = 0; i < writer->segments->len; i++)
+    {
+        VcSegment *segment = &g_array_index(writer->segments, VcSegment, i);
+        gchar *file = segment->pPath != NULL ? g_path_get_basename(segment->pPath) : g_strdup(chained);
+        g_string_append_printf(csv, "%u,%s,%" G_GINT64_FORMAT ",%" G_GINT64_FORMAT ",%.6f,%.6f\n", i, file, 
+            segment->nOffset, segment->nBytes, (double)segment->nStartFrame / writer->nRate, (double)segment->nFrames / writer->nRate);
+        g_free(file);
+    }
+    g_free(chained);
+
+    gchar *path = g_strdup_printf("%s-segments.csv", writer->pStem);
+    gchar *text = g_string_free(csv, false);
+    if (!g_file_set_contents(path, text, -1, error))
+    {
+        g_free(path);
+        path = NULL;
+    }
+
+    g_free(text);
+    return path;
+}
+
+void VcSegmentWriterClear(VcSegmentWriter *writer)
+{
+    if (writer->pOut != NULL)
+    {
+        g_output_stream_close(writer->pOut, NULL, NULL);
+        g_object_unref(writer->pOut);
+    }
+
+    for (guint i = 0; writer->segments != NULL && i < writer->segments->len; i++)
+    {
+        g_free(g_array_index(writer->segments, VcSegment, i).pPath);
+    }
+
+    if (writer->segments != NULL)
+    {
+        g_array_free(writer->segments, true);
+    }
+
+    g_free(writer->pStem);
+    memset(writer, 0, sizeof(VcSegmentWriter));
+}
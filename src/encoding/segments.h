@@ -0,0 +1,38 @@
+#ifndef VC_SEGMENTS_H
+#define VC_SEGMENTS_H
+
+#include <gio/gio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// One link of a segmented stream, its bytes are the same in the chained output and in its own file
+typedef struct
+{
+    int64_t     nOffset;        // byte offset of the link in the chained output
+    int64_t     nBytes;
+    int64_t     nStartFrame;
+    int64_t     nFrames;
+    gchar       *pPath;         // own file, NULL when only the chained output is written
+
+} VcSegment;
+
+// Keeps track of the links the encoder starts at every segment boundary and, if asked to,
+// copies each one into a file of its own next to the chained output.
+typedef struct
+{
+    gchar           *pStem;     // output path without its extension
+    bool            bFiles;
+    long            nRate;
+    GOutputStream   *pOut;      // file of the current segment
+    GArray          *segments;
+
+} VcSegmentWriter;
+
+int     VcSegmentWriterInit(VcSegmentWriter *writer, const char *outPath, long rate, bool files);
+int     VcSegmentWriterBegin(VcSegmentWriter *writer, int64_t offset, int64_t startFrame, GError **error);
+int     VcSegmentWriterWrite(VcSegmentWriter *writer, const void *data, size_t size, GError **error);
+int     VcSegmentWriterEnd(VcSegmentWriter *writer, int64_t offset, int64_t frames, GError **error);
+gchar   *VcSegmentWriterWriteManifest(VcSegmentWriter *writer, const char *outPath, GError **error);
+void    VcSegmentWriterClear(VcSegmentWriter *writer);
+
+#endif // VC_SEGMENTS_H
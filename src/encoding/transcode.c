@@ -0,0 +1,206 @@
+#include "transcode.h"
+#include "pcm-ring.h"
+#include "../gui/log-view.h"
+#include <vorbis/vorbisfile.h>
+#include <string.h>
+
+typedef struct
+{
+    OggVorbis_File      *vf;
+    VcPcmRing           *ring;
+    int                 nChannels;
+    long                nRate;
+    int                 status;
+
+} VcTranscodeDecoder;
+
+// Fills slot after slot with ov_read_float output and ends the stream with an empty one
+static gpointer VcTranscodeDecodeCallback(gpointer data)
+{
+    VcTranscodeDecoder *decoder = (VcTranscodeDecoder *)data;
+    VcPcmRing *ring = decoder->ring;
+    int bitstream = 0;
+    bool ended = false;
+
+    while (!ended)
+    {
+        VcPcmSlot *slot = VcPcmRingAcquireWrite(ring);
+        if (slot == NULL)
+        {
+            // The encoder gave up
+            return NULL;
+        }
+
+        slot->nFrames = 0;
+        while (slot->nFrames < ring->nCapacity)
+        {
+            float **pcm;
+            long frames = ov_read_float(decoder->vf, &pcm, ring->nCapacity - slot->nFrames, &bitstream);
+            if (frames == OV_HOLE)
+            {
+                continue;
+            }
+
+            if (frames <= 0)
+            {
+                decoder->status = frames < 0 ? -1 : 0;
+                ended = true;
+                break;
+            }
+
+            vorbis_info *info = ov_info(decoder->vf, bitstream);
+            if (info->channels != decoder->nChannels || info->rate != decoder->nRate)
+            {
+                decoder->status = -1;
+                ended = true;
+                break;
+            }
+
+            for (int ch = 0; ch < decoder->nChannels; ch++)
+            {
+                memcpy(slot->channels[ch] + slot->nFrames, pcm[ch], frames * sizeof(float));
+            }
+            slot->nFrames += (int)frames;
+        }
+
+        bool last = slot->nFrames == 0;
+        VcPcmRingCommit(ring);
+
+        if (ended && !last && (slot = VcPcmRingAcquireWrite(ring)) != NULL)
+        {
+            slot->nFrames = 0;
+            VcPcmRingCommit(ring);
+        }
+    }
+
+    return NULL;
+}
+
+static int VcTranscodeOpenOutput(VcTranscodeOptions *options, VcVorbisEncoder *encoder, GError **error)
+{
+    GFile *file = g_file_new_for_path(options->pOutPath);
+    GFileOutputStream *stream = g_file_replace(file, NULL, false, G_FILE_CREATE_REPLACE_DESTINATION, NULL, error);
+    g_object_unref(file);
+    if (stream == NULL)
+    {
+        return -1;
+    }
+
+    encoder->pOut = G_OUTPUT_STREAM(stream);
+    return VcVorbisEncoderWriteHeaders(encoder, error);
+}
+
+// Encoder side, consumes the ring on this thread while the decoder fills it on another
+static int VcTranscodeRun(VcTranscodeOptions *options, OggVorbis_File *vf, VcVorbisEncoder *encoder, GError **error)
+{
+    VcPcmRing ring;
+    if (VcPcmRingInit(&ring, options->nChannels, VC_TRANSCODE_SLOT_FRAMES, VC_TRANSCODE_SLOTS) < 0)
+    {
+        return -1;
+    }
+
+    VcTranscodeDecoder decoder = { vf, &ring, options->nChannels, options->nRate, 0 };
+    GThread *decoderThread = g_thread_new("transcode-decoder", VcTranscodeDecodeCallback, &decoder);
+
+    int status = 0;
+    while (status == 0)
+    {
+        VcPcmSlot *slot = VcPcmRingAcquireRead(&ring);
+        int frames = slot->nFrames;
+        if (frames > 0)
+        {
+            status = VcVorbisEncoderWrite(encoder, slot->channels, frames, error);
+        }
+
+        VcPcmRingRelease(&ring);
+        if (frames == 0)
+        {
+            break;
+        }
+    }
+
+    // Only the consumer aborts, the decoder always ends its stream with an empty slot
+    if (status < 0)
+    {
+        VcPcmRingAbort(&ring);
+    }
+
+    g_thread_join(decoderThread);
+    VcPcmRingClear(&ring);
+
+    if (status == 0 && decoder.status < 0)
+    {
+        VcLogViewPostLine(options->pLogView, "Decoding %s failed, corrupt data or a chained stream changing format", options->pInPath);
+        status = -1;
+    }
+
+    return status == 0 ? VcVorbisEncoderFinish(encoder, error) : -1;
+}
+
+gpointer VcTranscodeCallback(gpointer data)
+{
+    VcTranscodeOptions *options = (VcTranscodeOptions *)data;
+    VcVorbisEncoder encoder = { 0 };
+    OggVorbis_File vf;
+    GError *error = NULL;
+
+    options->status = -1;
+    if (ov_fopen(options->pInPath, &vf) < 0)
+    {
+        VcLogViewPostLine(options->pLogView, "%s is not an Ogg Vorbis file", options->pInPath);
+        g_main_context_invoke(NULL, options->cbOnFinished, options);
+        return NULL;
+    }
+
+    vorbis_info *info = ov_info(&vf, -1);
+    options->nChannels = info->channels;
+    options->nRate = info->rate;
+    options->nInBytes = ov_raw_total(&vf, -1);
+
+    options->status = VcVorbisEncoderInitTuned(&encoder, options->nChannels, options->nRate, &options->tuning);
+    if (options->status == 0)
+    {
+        // Tags carry over, the encoder writes its own vendor string
+        vorbis_comment *comment = ov_comment(&vf, -1);
+        for (int i = 0; comment != NULL && i < comment->comments; i++)
+        {
+            vorbis_comment_add(&encoder.comment, comment->user_comments[i]);
+        }
+
+        options->status = VcTranscodeOpenOutput(options, &encoder, &error);
+    }
+
+    if (options->status == 0)
+    {
+        options->status = VcTranscodeRun(options, &vf, &encoder, &error);
+    }
+
+    if (encoder.pOut != NULL && !g_output_stream_close(encoder.pOut, NULL, error == NULL ? &error : NULL))
+    {
+        options->status = -1;
+    }
+
+    if (error != NULL)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+    }
+
+    options->nFrames = encoder.nFramesWritten;
+    options->nOutBytes = encoder.nBytesWritten;
+
+    if (encoder.pOut != NULL)
+    {
+        g_object_unref(encoder.pOut);
+    }
+    VcVorbisEncoderClear(&encoder);
+    ov_clear(&vf);
+
+    g_main_context_invoke(NULL, options->cbOnFinished, options);
+    return NULL;
+}
+
+GThread *VcTranscode(VcTranscodeOptions *options)
+{
+    return g_thread_new("transcoder", VcTranscodeCallback, options);
+}
@@ -0,0 +1,33 @@
+#ifndef VC_TRANSCODE_H
+#define VC_TRANSCODE_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <stdint.h>
+#include "vorbis-encoder.h"
+
+#define VC_TRANSCODE_SLOT_FRAMES    4096
+#define VC_TRANSCODE_SLOTS          16      // decoded audio the decoder may run ahead by
+
+// Re-encodes an Ogg Vorbis file, the decoder runs on its own thread and hands float blocks
+// straight to the encoder through a VcPcmRing, so nothing goes through an intermediate file.
+typedef struct
+{
+    gchar               *pInPath;
+    gchar               *pOutPath;
+    GtkTextView         *pLogView;
+    GSourceFunc         cbOnFinished;
+    VcEncoderTuning     tuning;
+
+    // results
+    int                 status;
+    int64_t             nFrames;
+    long                nRate;
+    int                 nChannels;
+    int64_t             nInBytes;
+    int64_t             nOutBytes;
+
+} VcTranscodeOptions;
+
+GThread     *VcTranscode(VcTranscodeOptions *options);
+
+#endif // VC_TRANSCODE_H
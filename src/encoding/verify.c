@@ -0,0 +1,426 @@
+#include "verify.h"
+#include <vorbis/codec.h>
+#include <string.h>
+#include <math.h>
+
+#define VC_VERIFY_READ_SIZE 4096
+#define VC_VERIFY_WAIT      100000  // microseconds between checks for new pages
+
+// Copies frames the encoder is about to analyse, called on the encoder thread
+void VcVerifierPush(VcVerifier *verifier, float **pcm, long frames)
+{
+    for (long offset = 0; offset < frames; offset += VC_VERIFY_BLOCK_FRAMES)
+    {
+        VcPcmBlock *block = VcPcmBlockAcquire(verifier->pool);
+        block->nFrames = (int)MIN(VC_VERIFY_BLOCK_FRAMES, frames - offset);
+        for (int ch = 0; ch < verifier->nChannels; ch++)
+        {
+            memcpy(block->channels[ch], pcm[ch] + offset, block->nFrames * sizeof(float));
+        }
+
+        g_async_queue_push(verifier->queue, block);
+    }
+}
+
+// Log spectral distance of one full frame. Source and decoded frame go through a single complex
+// FFT as its real and imaginary parts and are separated again by conjugate symmetry.
+static double VcVerifierSpectralDistance(VcVerifier *verifier, int ch)
+{
+    int n = VC_VERIFY_FRAME;
+    for (int i = 0; i < n; i++)
+    {
+        verifier->pRe[i] = verifier->source[ch][i] * verifier->pWindow[i];
+        verifier->pIm[i] = verifier->decoded[ch][i] * verifier->pWindow[i];
+    }
+
+    VcFftForward(&verifier->fft, verifier->pRe, verifier->pIm);
+
+    const float *re = verifier->pRe;
+    const float *im = verifier->pIm;
+    double sum = 0.0;
+    for (int k = 1; k < n / 2; k++)
+    {
+        double sr = 0.5 * (re[k] + re[n - k]);
+        double si = 0.5 * (im[k] - im[n - k]);
+        double dr = 0.5 * (im[k] + im[n - k]);
+        double di = 0.5 * (re[n - k] - re[k]);
+        double ratio = 10.0 * log10((sr * sr + si * si + verifier->dSpectralFloor) / (dr * dr + di * di + verifier->dSpectralFloor));
+        sum += ratio * ratio;
+    }
+
+    return sqrt(sum / (n / 2 - 1));
+}
+
+static void VcVerifierMetrics(const VcVerifyTotals *totals, double start, VcVerifyWindow *result)
+{
+    result->dStart = start;
+    result->dSnr = 10.0 * log10(MAX(totals->signal, 1e-20) / MAX(totals->noise, 1e-20));
+    result->dSegmentalSnr = totals->nFrames > 0 ? totals->segmentSum / totals->nFrames : NAN;
+    result->dSpectralDistance = totals->nSpectral > 0 ? totals->distanceSum / totals->nSpectral : NAN;
+}
+
+static void VcVerifierCloseWindow(VcVerifier *verifier)
+{
+    VcVerifyWindow window;
+    VcVerifierMetrics(&verifier->window, (double)verifier->nWindowStart / verifier->nRate, &window);
+    g_array_append_val(verifier->windows, window);
+
+    memset(&verifier->window, 0, sizeof(VcVerifyTotals));
+    verifier->nWindowStart = verifier->nFrames;
+}
+
+static void VcVerifierAnalyse(VcVerifier *verifier)
+{
+    int frames = verifier->nFill;
+    if (frames == 0)
+    {
+        return;
+    }
+
+    double signal = 0.0;
+    double noise = 0.0;
+    for (int ch = 0; ch < verifier->nChannels; ch++)
+    {
+        const float *s = verifier->source[ch];
+        const float *d = verifier->decoded[ch];
+        float channelSignal = 0.0f;
+        float channelNoise = 0.0f;
+        for (int i = 0; i < frames; i++)
+        {
+            float e = s[i] - d[i];
+            channelSignal += s[i] * s[i];
+            channelNoise += e * e;
+        }
+
+        signal += channelSignal;
+        noise += channelNoise;
+    }
+
+    VcVerifyTotals *sets[] = { &verifier->total, &verifier->window };
+    for (int i = 0; i < 2; i++)
+    {
+        sets[i]->signal += signal;
+        sets[i]->noise += noise;
+    }
+
+    // Silent frames would only drag the per frame figures towards the clamps
+    if (signal / ((double)frames * verifier->nChannels) > VC_VERIFY_SILENCE)
+    {
+        double segment = 10.0 * log10(signal / MAX(noise, 1e-20));
+        segment = CLAMP(segment, VC_VERIFY_SEGMENT_MIN, VC_VERIFY_SEGMENT_MAX);
+
+        double distance = 0.0;
+        bool full = frames == VC_VERIFY_FRAME;
+        for (int ch = 0; full && ch < verifier->nChannels; ch++)
+        {
+            distance += VcVerifierSpectralDistance(verifier, ch) / verifier->nChannels;
+        }
+
+        for (int i = 0; i < 2; i++)
+        {
+            sets[i]->segmentSum += segment;
+            sets[i]->nFrames++;
+            if (full)
+            {
+                sets[i]->distanceSum += distance;
+                sets[i]->nSpectral++;
+            }
+        }
+    }
+
+    verifier->nFill = 0;
+    if (verifier->nFrames - verifier->nWindowStart >= (uint64_t)verifier->nRate * VC_VERIFY_WINDOW_SECONDS)
+    {
+        VcVerifierCloseWindow(verifier);
+    }
+}
+
+static bool VcVerifierNextBlock(VcVerifier *verifier)
+{
+    if (verifier->bSourceEnded)
+    {
+        return false;
+    }
+
+    VcPcmBlock *block = g_async_queue_pop(verifier->queue);
+    if (block->nFrames == 0)
+    {
+        VcPcmBlockUnref(block);
+        verifier->bSourceEnded = true;
+        return false;
+    }
+
+    verifier->pCurrent = block;
+    verifier->nOffset = 0;
+    return true;
+}
+
+// The encoder queues every block before analysing it, so the source for decoded frames is always there to pop
+static void VcVerifierCompare(VcVerifier *verifier, float **pcm, long frames)
+{
+    long done = 0;
+    while (done < frames)
+    {
+        if (verifier->pCurrent == NULL && !VcVerifierNextBlock(verifier))
+        {
+            verifier->nExtra += frames - done;
+            return;
+        }
+
+        VcPcmBlock *block = verifier->pCurrent;
+        long n = MIN(frames - done, MIN(block->nFrames - verifier->nOffset, VC_VERIFY_FRAME - verifier->nFill));
+        for (int ch = 0; ch < verifier->nChannels; ch++)
+        {
+            memcpy(verifier->source[ch] + verifier->nFill, block->channels[ch] + verifier->nOffset, n * sizeof(float));
+            memcpy(verifier->decoded[ch] + verifier->nFill, pcm[ch] + done, n * sizeof(float));
+        }
+
+        done += n;
+        verifier->nOffset += n;
+        verifier->nFill += n;
+        verifier->nFrames += n;
+
+        if (verifier->nOffset == block->nFrames)
+        {
+            VcPcmBlockUnref(block);
+            verifier->pCurrent = NULL;
+        }
+
+        if (verifier->nFill == VC_VERIFY_FRAME)
+        {
+            VcVerifierAnalyse(verifier);
+        }
+    }
+}
+
+// Plain libvorbis decode of the pages as they land in the buffer, no seeking so nothing waits for the end
+static int VcVerifierDecode(VcVerifier *verifier)
+{
+    ogg_sync_state sync;
+    ogg_stream_state stream;
+    vorbis_info info;
+    vorbis_comment comment;
+    vorbis_dsp_state dsp;
+    vorbis_block block;
+    ogg_page page;
+    ogg_packet packet;
+
+    ogg_sync_init(&sync);
+    vorbis_info_init(&info);
+    vorbis_comment_init(&comment);
+
+    bool streamReady = false;
+    bool ended = false;
+    int headers = 0;
+    int status = 0;
+    size_t offset = 0;
+
+    while (status == 0 && !ended)
+    {
+        while (status == 0 && !ended && ogg_sync_pageout(&sync, &page) == 1)
+        {
+            if (!streamReady)
+            {
+                ogg_stream_init(&stream, ogg_page_serialno(&page));
+                streamReady = true;
+            }
+
+            if (ogg_stream_pagein(&stream, &page) < 0)
+            {
+                status = -1;
+                break;
+            }
+
+            while (status == 0 && ogg_stream_packetout(&stream, &packet) == 1)
+            {
+                if (headers < 3)
+                {
+                    if (vorbis_synthesis_headerin(&info, &comment, &packet) < 0 || (headers == 0 && info.channels != verifier->nChannels))
+                    {
+                        status = -1;
+                    }
+
+                    else if (++headers == 3)
+                    {
+                        vorbis_synthesis_init(&dsp, &info);
+                        vorbis_block_init(&dsp, &block);
+                    }
+                    continue;
+                }
+
+                if (vorbis_synthesis(&block, &packet) == 0)
+                {
+                    vorbis_synthesis_blockin(&dsp, &block);
+                }
+
+                float **pcm;
+                int frames;
+                while ((frames = vorbis_synthesis_pcmout(&dsp, &pcm)) > 0)
+                {
+                    VcVerifierCompare(verifier, pcm, frames);
+                    vorbis_synthesis_read(&dsp, frames);
+                }
+            }
+
+            ended = ogg_page_eos(&page) != 0;
+        }
+
+        if (status != 0 || ended)
+        {
+            break;
+        }
+
+        char *dst = ogg_sync_buffer(&sync, VC_VERIFY_READ_SIZE);
+        size_t read = VcOggBufferReadWait(verifier->pOggBuffer, offset, dst, VC_VERIFY_READ_SIZE, VC_VERIFY_WAIT);
+        ogg_sync_wrote(&sync, (long)read);
+        offset += read;
+
+        if (read == 0 && VcOggBufferIsFinished(verifier->pOggBuffer) && offset >= VcOggBufferGetSize(verifier->pOggBuffer))
+        {
+            break;
+        }
+    }
+
+    if (headers == 3)
+    {
+        vorbis_block_clear(&block);
+        vorbis_dsp_clear(&dsp);
+    }
+
+    else
+    {
+        status = -1;
+    }
+
+    if (streamReady)
+    {
+        ogg_stream_clear(&stream);
+    }
+
+    vorbis_comment_clear(&comment);
+    vorbis_info_clear(&info);
+    ogg_sync_clear(&sync);
+
+    return status;
+}
+
+static gpointer VcVerifierThread(gpointer data)
+{
+    VcVerifier *verifier = (VcVerifier *)data;
+    verifier->status = VcVerifierDecode(verifier);
+    VcVerifierAnalyse(verifier);
+
+    // Whatever source the decoder didn't cover still has to be taken off the queue
+    if (verifier->pCurrent != NULL)
+    {
+        verifier->nMissing += verifier->pCurrent->nFrames - verifier->nOffset;
+        VcPcmBlockUnref(verifier->pCurrent);
+        verifier->pCurrent = NULL;
+    }
+
+    while (VcVerifierNextBlock(verifier))
+    {
+        verifier->nMissing += verifier->pCurrent->nFrames;
+        VcPcmBlockUnref(verifier->pCurrent);
+        verifier->pCurrent = NULL;
+    }
+
+    if (verifier->nFrames > verifier->nWindowStart)
+    {
+        VcVerifierCloseWindow(verifier);
+    }
+
+    return NULL;
+}
+
+int VcVerifierStart(VcVerifier *verifier, VcOggBuffer *buffer, int channels, long rate)
+{
+    memset(verifier, 0, sizeof(VcVerifier));
+    if (channels <= 0 || channels > VC_MIX_MAX_CHANNELS || rate <= 0 || VcFftInit(&verifier->fft, VC_VERIFY_FRAME) < 0)
+    {
+        return -1;
+    }
+
+    verifier->nChannels = channels;
+    verifier->nRate = rate;
+    verifier->pOggBuffer = VcOggBufferRef(buffer);
+
+    // Bounded only by how far the decoder lags the encoder, which is a few pages
+    verifier->pool = VcPcmBlockPoolNew(channels, VC_VERIFY_BLOCK_FRAMES, G_MAXINT);
+    verifier->queue = g_async_queue_new();
+
+    double energy = 0.0;
+    verifier->pWindow = g_new(float, VC_VERIFY_FRAME);
+    for (int i = 0; i < VC_VERIFY_FRAME; i++)
+    {
+        verifier->pWindow[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / VC_VERIFY_FRAME));
+        energy += verifier->pWindow[i] * verifier->pWindow[i];
+    }
+    verifier->dSpectralFloor = 1e-10 * energy;
+
+    for (int ch = 0; ch < channels; ch++)
+    {
+        verifier->source[ch] = g_new(float, VC_VERIFY_FRAME);
+        verifier->decoded[ch] = g_new(float, VC_VERIFY_FRAME);
+    }
+    verifier->pRe = g_new(float, VC_VERIFY_FRAME);
+    verifier->pIm = g_new(float, VC_VERIFY_FRAME);
+    verifier->windows = g_array_new(false, false, sizeof(VcVerifyWindow));
+
+    verifier->thread = g_thread_new("verifier", VcVerifierThread, verifier);
+    return 0;
+}
+
+// Ends the source stream and waits for the decoder to catch up. The Ogg buffer is marked
+// finished, so this goes after the last page has been written.
+int VcVerifierFinish(VcVerifier *verifier)
+{
+    if (verifier->thread == NULL)
+    {
+        return -1;
+    }
+
+    g_async_queue_push(verifier->queue, VcPcmBlockAcquire(verifier->pool));
+    VcOggBufferFinish(verifier->pOggBuffer);
+    g_thread_join(verifier->thread);
+    verifier->thread = NULL;
+
+    return verifier->status;
+}
+
+void VcVerifierGetResult(const VcVerifier *verifier, VcVerifyWindow *result)
+{
+    VcVerifierMetrics(&verifier->total, 0.0, result);
+}
+
+void VcVerifierClear(VcVerifier *verifier)
+{
+    if (verifier->thread != NULL)
+    {
+        VcVerifierFinish(verifier);
+    }
+
+    if (verifier->pool != NULL)
+    {
+        g_async_queue_unref(verifier->queue);
+        VcPcmBlockPoolFree(verifier->pool);
+        VcOggBufferUnref(verifier->pOggBuffer);
+    }
+
+    for (int ch = 0; ch < verifier->nChannels; ch++)
+    {
+        g_free(verifier->source[ch]);
+        g_free(verifier->decoded[ch]);
+    }
+
+    if (verifier->windows != NULL)
+    {
+        g_array_free(verifier->windows, true);
+    }
+
+    g_free(verifier->pWindow);
+    g_free(verifier->pRe);
+    g_free(verifier->pIm);
+    VcFftClear(&verifier->fft);
+    memset(verifier, 0, sizeof(VcVerifier));
+}
@@ -0,0 +1,81 @@
+#ifndef VC_VERIFY_H
+#define VC_VERIFY_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <stdint.h>
+#include "ogg-buffer.h"
+#include "pcm-block.h"
+#include "../dsp/fft.h"
+#include "../dsp/channel-mix.h"
+
+#define VC_VERIFY_BLOCK_FRAMES      1024
+#define VC_VERIFY_FRAME             1024    // frames per segmental SNR / spectrum frame
+#define VC_VERIFY_WINDOW_SECONDS    5       // reporting window
+#define VC_VERIFY_SILENCE           1e-8    // mean square under which a frame is left out of the per frame metrics
+#define VC_VERIFY_SEGMENT_MIN       -10.0   // dB, segmental SNR clamps
+#define VC_VERIFY_SEGMENT_MAX       35.0
+
+typedef struct
+{
+    double              dStart;             // seconds
+    double              dSnr;               // dB
+    double              dSegmentalSnr;      // dB
+    double              dSpectralDistance;  // dB, mean log spectral distance
+
+} VcVerifyWindow;
+
+// Running sums behind one set of metrics
+typedef struct
+{
+    double              signal;
+    double              noise;
+    double              segmentSum;
+    double              distanceSum;
+    long                nFrames;            // loud analysis frames
+    long                nSpectral;          // loud analysis frames that were full length
+
+} VcVerifyTotals;
+
+// Decodes the pages of an encode from memory while it is still running and compares them
+// against the float blocks the encoder was fed. Decoded sample n lines up with source frame n,
+// so the only state shared with the encoder is the queue of source blocks.
+typedef struct
+{
+    int                 nChannels;
+    long                nRate;
+    VcOggBuffer         *pOggBuffer;
+    VcPcmBlockPool      *pool;
+    GAsyncQueue         *queue;             // source blocks, an empty one ends the stream
+    GThread             *thread;
+
+    VcPcmBlock          *pCurrent;          // source block being compared
+    int                 nOffset;
+    bool                bSourceEnded;
+    VcFft               fft;
+    float               *pWindow;           // Hann
+    double              dSpectralFloor;     // power of -100 dBFS noise through the window
+    float               *source[VC_MIX_MAX_CHANNELS];
+    float               *decoded[VC_MIX_MAX_CHANNELS];
+    float               *pRe;
+    float               *pIm;
+    int                 nFill;
+
+    // results, valid after VcVerifierFinish
+    int                 status;
+    uint64_t            nFrames;            // frames compared
+    uint64_t            nMissing;           // source frames the decoder never produced
+    uint64_t            nExtra;             // decoded frames past the end of the source
+    uint64_t            nWindowStart;
+    VcVerifyTotals      total;
+    VcVerifyTotals      window;
+    GArray              *windows;           // VcVerifyWindow
+
+} VcVerifier;
+
+int     VcVerifierStart(VcVerifier *verifier, VcOggBuffer *buffer, int channels, long rate);
+void    VcVerifierPush(VcVerifier *verifier, float **pcm, long frames);
+int     VcVerifierFinish(VcVerifier *verifier);
+void    VcVerifierGetResult(const VcVerifier *verifier, VcVerifyWindow *result);
+void    VcVerifierClear(VcVerifier *verifier);
+
+#endif // VC_VERIFY_H
@@ -0,0 +1,455 @@
+#include "vorbis-encoder.h"
+#include <vorbis/vorbisenc.h>
+#include <string.h>
+
+static int VcVorbisEncoderCtl(vorbis_info *vi, int request, void *arg, const char *name)
+{
+    int status = vorbis_encode_ctl(vi, request, arg);
+    if (status < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't set %s: %d", name, status);
+    }
+
+    return status;
+}
+
+static int VcVorbisEncoderSetup(vorbis_info *vi, int channels, long rate, const VcEncoderTuning *tuning)
+{
+    int status;
+    switch (tuning->mode)
+    {
+        case VC_RATE_ABR:
+            status = vorbis_encode_setup_managed(vi, channels, rate, tuning->nMaxBitrate > 0 ? tuning->nMaxBitrate * 1000 : -1, tuning->nBitrate * 1000, -1);
+            break;
+
+        case VC_RATE_CBR:
+            status = vorbis_encode_setup_managed(vi, channels, rate, tuning->nBitrate * 1000, tuning->nBitrate * 1000, tuning->nBitrate * 1000);
+            break;
+
+        default:
+            status = vorbis_encode_setup_vbr(vi, channels, rate, tuning->fQuality);
+            break;
+    }
+
+    if (status < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Unsupported rate settings: %d", status);
+        return -1;
+    }
+
+    // A smaller reservoir keeps the bitrate closer to its limits over shorter spans
+    if (tuning->mode != VC_RATE_VBR && tuning->dReservoirSeconds > 0.0)
+    {
+        struct ovectl_ratemanage2_arg manage;
+        long peak = tuning->mode == VC_RATE_CBR ? tuning->nBitrate : MAX(tuning->nMaxBitrate, tuning->nBitrate);
+        if (VcVorbisEncoderCtl(vi, OV_ECTL_RATEMANAGE2_GET, &manage, "rate management") < 0)
+        {
+            return -1;
+        }
+
+        manage.bitrate_limit_reservoir_bits = (long)(peak * 1000 * tuning->dReservoirSeconds);
+        if (VcVorbisEncoderCtl(vi, OV_ECTL_RATEMANAGE2_SET, &manage, "rate management") < 0)
+        {
+            return -1;
+        }
+    }
+
+    if (tuning->dLowpass > 0.0)
+    {
+        double lowpass = tuning->dLowpass;
+        if (VcVorbisEncoderCtl(vi, OV_ECTL_LOWPASS_SET, &lowpass, "lowpass") < 0)
+        {
+            return -1;
+        }
+    }
+
+    if (tuning->dImpulseBlock < 0.0)
+    {
+        double impulseBlock = tuning->dImpulseBlock;
+        if (VcVorbisEncoderCtl(vi, OV_ECTL_IBLOCK_SET, &impulseBlock, "impulse block bias") < 0)
+        {
+            return -1;
+        }
+    }
+
+    if (tuning->bNoCoupling)
+    {
+        int coupling = 0;
+        if (VcVorbisEncoderCtl(vi, OV_ECTL_COUPLING_SET, &coupling, "channel coupling") < 0)
+        {
+            return -1;
+        }
+    }
+
+    return vorbis_encode_setup_init(vi);
+}
+
+int VcVorbisEncoderInit(VcVorbisEncoder *encoder, int channels, long rate, float quality)
+{
+    VcEncoderTuning tuning = { .mode = VC_RATE_VBR, .fQuality = quality };
+    return VcVorbisEncoderInitTuned(encoder, channels, rate, &tuning);
+}
+
+int VcVorbisEncoderInitTuned(VcVorbisEncoder *encoder, int channels, long rate, const VcEncoderTuning *tuning)
+{
+    int status;
+    memset(encoder, 0, sizeof(VcVorbisEncoder));
+
+    status = ogg_stream_init(&encoder->stream, g_random_int());
+    if (status < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't initialize vorbis stream");
+        return -1;
+    }
+
+    vorbis_info_init(&encoder->vi);
+    vorbis_comment_init(&encoder->comment);
+    status = VcVorbisEncoderSetup(&encoder->vi, channels, rate, tuning);
+    if (status < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't initialize vorbis encoding engine");
+        return -1;
+    }
+
+    status = vorbis_analysis_init(&encoder->dsp, &encoder->vi);
+    if (status < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't initialize vorbis analysis engine");
+        return -1;
+    }
+
+    status = vorbis_block_init(&encoder->dsp, &encoder->block);
+    if (status < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't initialize vorbis block structure");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int VcVorbisEncoderWritePage(VcVorbisEncoder *encoder, GError **error)
+{
+    // Links after the first restart their granules at 0, the index keeps counting
+    int64_t granule = ogg_page_granulepos(&encoder->page);
+    if (encoder->pSeekIndex != NULL && granule > 0)
+    {
+        VcSeekIndexAddPoint(encoder->pSeekIndex, encoder->nLinkStart + granule, encoder->nBytesWritten);
+    }
+
+    // A short or failed write stops the encode, the in-memory copy only ever holds what reached the output
+    if (encoder->pOut != NULL
+        && (!g_output_stream_write_all(encoder->pOut, encoder->page.header, encoder->page.header_len, NULL, NULL, error)
+        || !g_output_stream_write_all(encoder->pOut, encoder->page.body, encoder->page.body_len, NULL, NULL, error)))
+    {
+        return -1;
+    }
+
+    if (encoder->pOggBuffer != NULL)
+    {
+        VcOggBufferAppend(encoder->pOggBuffer, encoder->page.header, encoder->page.header_len);
+        VcOggBufferAppend(encoder->pOggBuffer, encoder->page.body, encoder->page.body_len);
+    }
+
+    if (encoder->pSegments != NULL
+        && (VcSegmentWriterWrite(encoder->pSegments, encoder->page.header, encoder->page.header_len, error) < 0
+        || VcSegmentWriterWrite(encoder->pSegments, encoder->page.body, encoder->page.body_len, error) < 0))
+    {
+        return -1;
+    }
+
+    // Listeners come and go, losing one doesn't stop the encode. Header pages have granule 0 and are never dropped.
+    if (encoder->pLive != NULL
+        && VcLiveSinkPush(encoder->pLive, encoder->page.header, encoder->page.header_len, encoder->page.body, encoder->page.body_len, granule == 0) < 0)
+    {
+        encoder->pLive = NULL;
+    }
+
+    if (granule >= 0)
+    {
+        encoder->nPageGranule = granule;
+    }
+
+    encoder->nBytesWritten += encoder->page.header_len + encoder->page.body_len;
+
+    return 0;
+}
+
+// Comments have to be added before this is called
+int VcVorbisEncoderWriteHeaders(VcVorbisEncoder *encoder, GError **error)
+{
+    ogg_packet headerPacket, commentPacket, codePacket;
+    int status = vorbis_analysis_headerout(&encoder->dsp, &encoder->comment, &headerPacket, &commentPacket, &codePacket);
+    if (status < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Failed to write header");
+        return -1;
+    }
+
+    if (encoder->pSegments != NULL && VcSegmentWriterBegin(encoder->pSegments, encoder->nBytesWritten, encoder->nLinkStart, error) < 0)
+    {
+        return -1;
+    }
+
+    int64_t start = encoder->nBytesWritten;
+    ogg_stream_packetin(&encoder->stream, &headerPacket);
+    ogg_stream_packetin(&encoder->stream, &commentPacket);
+    ogg_stream_packetin(&encoder->stream, &codePacket);
+
+    // Audio data has to start on a fresh page
+    while (ogg_stream_flush(&encoder->stream, &encoder->page) != 0)
+    {
+        if (VcVorbisEncoderWritePage(encoder, error) < 0)
+        {
+            return -1;
+        }
+    }
+
+    encoder->nHeaderBytes = encoder->nBytesWritten - start;
+    return 0;
+}
+
+// Writes the header pages again over the ones at the start of every sink, for comments that are only 
+// known once the audio is through. The comment header must keep its size so no audio page moves.
+int VcVorbisEncoderRewriteHeaders(VcVorbisEncoder *encoder, GError **error)
+{
+    ogg_packet headerPacket, commentPacket, codePacket;
+    ogg_stream_state stream;
+    ogg_page page;
+
+    int status = vorbis_analysis_headerout(&encoder->dsp, &encoder->comment, &headerPacket, &commentPacket, &codePacket);
+    if (status < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Failed to write header");
+        return -1;
+    }
+
+    // Same serial and packets give the same pages with a fresh checksum
+    GByteArray *pages = g_byte_array_new();
+    ogg_stream_init(&stream, encoder->stream.serialno);
+    ogg_stream_packetin(&stream, &headerPacket);
+    ogg_stream_packetin(&stream, &commentPacket);
+    ogg_stream_packetin(&stream, &codePacket);
+    while (ogg_stream_flush(&stream, &page) != 0)
+    {
+        g_byte_array_append(pages, page.header, page.header_len);
+        g_byte_array_append(pages, page.body, page.body_len);
+    }
+    ogg_stream_clear(&stream);
+
+    if ((int64_t)pages->len != encoder->nHeaderBytes)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Header size changed from %lld to %u bytes, not rewriting it", (long long)encoder->nHeaderBytes, pages->len);
+        g_byte_array_free(pages, true);
+        return -1;
+    }
+
+    if (encoder->pOut != NULL)
+    {
+        GSeekable *seekable = G_SEEKABLE(encoder->pOut);
+        goffset end = g_seekable_tell(seekable);
+        status = g_seekable_seek(seekable, 0, G_SEEK_SET, NULL, error)
+            && g_output_stream_write_all(encoder->pOut, pages->data, pages->len, NULL, NULL, error)
+            && g_seekable_seek(seekable, end, G_SEEK_SET, NULL, error) ? 0 : -1;
+    }
+
+    if (status == 0 && encoder->pOggBuffer != NULL)
+    {
+        VcOggBufferOverwrite(encoder->pOggBuffer, 0, pages->data, pages->len);
+    }
+
+    g_byte_array_free(pages, true);
+    return status;
+}
+
+// Full pages first, then a forced flush once the audio waiting in the stream reaches the latency bound
+static int VcVorbisEncoderPageOut(VcVorbisEncoder *encoder)
+{
+    int result = encoder->nPageFill > 0 
+        ? ogg_stream_pageout_fill(&encoder->stream, &encoder->page, encoder->nPageFill) 
+        : ogg_stream_pageout(&encoder->stream, &encoder->page);
+
+    if (result == 0 && encoder->nMaxLatencyFrames > 0 && encoder->packet.granulepos - encoder->nPageGranule >= encoder->nMaxLatencyFrames)
+    {
+        result = ogg_stream_flush(&encoder->stream, &encoder->page);
+    }
+
+    return result;
+}
+
+static int VcVorbisEncoderFlushBlocks(VcVorbisEncoder *encoder, GError **error)
+{
+    int status;
+    while ((status = vorbis_analysis_blockout(&encoder->dsp, &encoder->block)) > 0)
+    {
+        status = vorbis_analysis(&encoder->block, NULL);
+        if (status < 0)
+        {
+            g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Analysis error: %d", status);
+            return -1;
+        }
+
+        status = vorbis_bitrate_addblock(&encoder->block);
+        if (status < 0)
+        {
+            g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't add block: %d", status);
+            return -1;
+        }
+
+        while ((status = vorbis_bitrate_flushpacket(&encoder->dsp, &encoder->packet)) > 0)
+        {
+            status = ogg_stream_packetin(&encoder->stream, &encoder->packet);
+            if (status < 0)
+            {
+                g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Failed to read packet from stream: %d", status);
+                return -1;
+            }
+
+            while (!encoder->bEos && VcVorbisEncoderPageOut(encoder) != 0)
+            {
+                if (VcVorbisEncoderWritePage(encoder, error) < 0)
+                {
+                    return -1;
+                }
+
+                if (ogg_page_eos(&encoder->page))
+                {
+                    encoder->bEos = true;
+                }
+            }
+        }
+
+        if (status < 0)
+        {
+            g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Failed to flush packet: %d", status);
+            return -1;
+        }
+    }
+
+    if (status < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't write block: %d", status);
+        return -1;
+    }
+
+    return 0;
+}
+
+float **VcVorbisEncoderBuffer(VcVorbisEncoder *encoder, int frames)
+{
+    return encoder->ppBuffer = vorbis_analysis_buffer(&encoder->dsp, frames);
+}
+
+// Same settings and comments, a fresh analysis state and serial so the link decodes on its own
+static int VcVorbisEncoderStartLink(VcVorbisEncoder *encoder, GError **error)
+{
+    int serial = encoder->stream.serialno;
+    int next;
+    while ((next = (int)g_random_int()) == serial);
+
+    vorbis_block_clear(&encoder->block);
+    vorbis_dsp_clear(&encoder->dsp);
+    ogg_stream_clear(&encoder->stream);
+
+    if (ogg_stream_init(&encoder->stream, next) < 0
+        || vorbis_analysis_init(&encoder->dsp, &encoder->vi) < 0
+        || vorbis_block_init(&encoder->dsp, &encoder->block) < 0)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Couldn't start a new link");
+        return -1;
+    }
+
+    encoder->bEos = false;
+    encoder->nLinkStart = encoder->nFramesWritten;
+    return VcVorbisEncoderWriteHeaders(encoder, error);
+}
+
+// The block crosses a segment boundary: the frames up to it end the current link and the rest
+// are copied out before the analysis buffer they sit in goes away with it
+static int VcVorbisEncoderWroteSplit(VcVorbisEncoder *encoder, int frames, GError **error)
+{
+    int channels = encoder->vi.channels;
+    int head = (int)(encoder->nLinkStart + encoder->nSegmentFrames - encoder->nFramesWritten);
+    int tail = frames - head;
+    float **rest = g_new(float *, channels);
+    for (int ch = 0; ch < channels; ch++)
+    {
+        rest[ch] = g_memdup2(encoder->ppBuffer[ch] + head, tail * sizeof(float));
+    }
+
+    int status = 0;
+    if (head > 0)
+    {
+        vorbis_analysis_wrote(&encoder->dsp, head);
+        encoder->nFramesWritten += head;
+        status = VcVorbisEncoderFlushBlocks(encoder, error);
+    }
+
+    if (status == 0)
+    {
+        status = VcVorbisEncoderWrote(encoder, 0, error);
+    }
+
+    if (status == 0)
+    {
+        status = VcVorbisEncoderStartLink(encoder, error);
+    }
+
+    if (status == 0)
+    {
+        status = VcVorbisEncoderWrite(encoder, rest, tail, error);
+    }
+
+    for (int ch = 0; ch < channels; ch++)
+    {
+        g_free(rest[ch]);
+    }
+    g_free(rest);
+
+    return status;
+}
+
+// Submits frames written into the analysis buffer, 0 frames ends the stream
+int VcVorbisEncoderWrote(VcVorbisEncoder *encoder, int frames, GError **error)
+{
+    if (encoder->nSegmentFrames > 0 && frames > 0 && encoder->nFramesWritten + frames > encoder->nLinkStart + encoder->nSegmentFrames)
+    {
+        return VcVorbisEncoderWroteSplit(encoder, frames, error);
+    }
+
+    vorbis_analysis_wrote(&encoder->dsp, frames);
+    encoder->nFramesWritten += frames;
+    int status = VcVorbisEncoderFlushBlocks(encoder, error);
+
+    if (status == 0 && frames == 0 && encoder->pSegments != NULL)
+    {
+        status = VcSegmentWriterEnd(encoder->pSegments, encoder->nBytesWritten, encoder->nFramesWritten - encoder->nLinkStart, error);
+    }
+
+    return status;
+}
+
+int VcVorbisEncoderWrite(VcVorbisEncoder *encoder, float **pcm, int frames, GError **error)
+{
+    float **buffer = VcVorbisEncoderBuffer(encoder, frames);
+    for (int ch = 0; ch < encoder->vi.channels; ch++)
+    {
+        memcpy(buffer[ch], pcm[ch], frames * sizeof(float));
+    }
+
+    return VcVorbisEncoderWrote(encoder, frames, error);
+}
+
+int VcVorbisEncoderFinish(VcVorbisEncoder *encoder, GError **error)
+{
+    return VcVorbisEncoderWrote(encoder, 0, error);
+}
+
+void VcVorbisEncoderClear(VcVorbisEncoder *encoder)
+{
+    ogg_stream_clear(&encoder->stream);
+    vorbis_block_clear(&encoder->block);
+    vorbis_dsp_clear(&encoder->dsp);
+    vorbis_comment_clear(&encoder->comment);
+    vorbis_info_clear(&encoder->vi);
+}
@@ -0,0 +1,82 @@
+#ifndef VC_VORBIS_ENCODER_H
+#define VC_VORBIS_ENCODER_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <vorbis/codec.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "seek-index.h"
+#include "ogg-buffer.h"
+#include "segments.h"
+#include "live.h"
+
+typedef enum
+{
+    VC_RATE_VBR = 0,
+    VC_RATE_ABR,
+    VC_RATE_CBR,
+
+} VcRateMode;
+
+// Zeroed fields keep libvorbis' defaults
+typedef struct
+{
+    VcRateMode          mode;
+    float               fQuality;           // VBR only, -0.1 to 1
+    long                nBitrate;           // ABR average or CBR rate, kbit/s
+    long                nMaxBitrate;        // ABR hard upper limit in kbit/s, 0 leaves it open
+    double              dReservoirSeconds;  // managed modes, span the limits are enforced over
+    double              dLowpass;           // kHz
+    double              dImpulseBlock;      // -15 to 0, lower spends more bits on transients
+    bool                bNoCoupling;
+
+} VcEncoderTuning;
+
+// One independent vorbis encoder and the ogg stream it writes to. Any number of 
+// them can run on separate threads, pages go to every sink that is set.
+typedef struct
+{
+    // Page sinks, all optional
+    GOutputStream       *pOut;
+    VcOggBuffer         *pOggBuffer;
+    VcSeekIndex         *pSeekIndex;
+    VcSegmentWriter     *pSegments;
+    VcLiveSink          *pLive;             // pages are queued for its writer, dropped once it fails
+
+    // Live pacing, pages go out once they reach nPageFill bytes or hold nMaxLatencyFrames of audio
+    int                 nPageFill;          // 0 keeps libogg's 4 KiB pages
+    int64_t             nMaxLatencyFrames;  // 0 waits for full pages
+    int64_t             nPageGranule;       // granule of the last page written
+
+    // Every nSegmentFrames the stream ends and a new link with its own headers starts
+    int64_t             nSegmentFrames;     // 0 writes a single stream
+    int64_t             nLinkStart;         // first frame of the current link
+    float               **ppBuffer;         // last analysis buffer handed out
+
+    int64_t             nBytesWritten;
+    int64_t             nHeaderBytes;
+    int64_t             nFramesWritten;
+    bool                bEos;
+
+    // Ogg vorbis structures
+    vorbis_info         vi;
+    vorbis_dsp_state    dsp;
+    vorbis_comment      comment;
+    vorbis_block        block;
+    ogg_stream_state    stream;
+    ogg_packet          packet;
+    ogg_page            page;
+
+} VcVorbisEncoder;
+
+int     VcVorbisEncoderInit(VcVorbisEncoder *encoder, int channels, long rate, float quality);
+int     VcVorbisEncoderInitTuned(VcVorbisEncoder *encoder, int channels, long rate, const VcEncoderTuning *tuning);
+int     VcVorbisEncoderWriteHeaders(VcVorbisEncoder *encoder, GError **error);
+int     VcVorbisEncoderRewriteHeaders(VcVorbisEncoder *encoder, GError **error);
+float   **VcVorbisEncoderBuffer(VcVorbisEncoder *encoder, int frames);
+int     VcVorbisEncoderWrote(VcVorbisEncoder *encoder, int frames, GError **error);
+int     VcVorbisEncoderWrite(VcVorbisEncoder *encoder, float **pcm, int frames, GError **error);
+int     VcVorbisEncoderFinish(VcVorbisEncoder *encoder, GError **error);
+void    VcVorbisEncoderClear(VcVorbisEncoder *encoder);
+
+#endif // VC_VORBIS_ENCODER_H
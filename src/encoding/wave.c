@@ -0,0 +1,666 @@
+#include "wave.h"
+#include "../gui/log-view.h"
+#include <string.h>
+
+static void VcWaveWarning(GtkTextView *logView, const char *message)
+{
+    g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, message);
+    if (logView != NULL)
+    {
+        VcLogViewWriteLine(logView, message);
+    }
+}
+
+// Warnings while parsing a header, a quiet probe keeps them to itself
+static void VcWaveParseWarning(GtkTextView *logView, bool quiet, const char *message)
+{
+    if (!quiet)
+    {
+        VcWaveWarning(logView, message);
+    }
+}
+
+// 0 when all of size was read, VC_WAVE_INCOMPLETE when the stream ended first and -1 on error
+static int VcReadExact(GInputStream *stream, void *buffer, gsize size, GtkTextView *logView, bool quiet)
+{
+    GError *error = NULL;
+    gsize nBytes = 0;
+    g_input_stream_read_all(stream, buffer, size, &nBytes, NULL, &error);
+    if (error != NULL)
+    {
+        VcWaveParseWarning(logView, quiet, error->message);
+        g_error_free(error);
+        return -1;
+    }
+
+    if (nBytes < size)
+    {
+        VcWaveParseWarning(logView, quiet, "Failed to read header");
+        return VC_WAVE_INCOMPLETE;
+    }
+
+    return 0;
+}
+
+// Walks the RIFF chunks up to the data chunk and leaves the stream positioned at the first sample
+static int VcParseWaveInfo(GInputStream *stream, VcWaveInfo *info, GtkTextView *logView, bool quiet)
+{
+    if (logView != NULL && !quiet)
+    {
+        VcLogViewWriteLine(logView, "Reading header...");
+    }
+
+    GError *error = NULL;
+    char riff[12];
+    bool hasFormat = false;
+    int status;
+
+    memset(info, 0, sizeof(VcWaveInfo));
+
+    g_seekable_seek(G_SEEKABLE(stream), 0, G_SEEK_SET, NULL, &error);
+    if (error != NULL)
+    {
+        VcWaveParseWarning(logView, quiet, error->message);
+        g_error_free(error);
+        return -1;
+    }
+
+    if ((status = VcReadExact(stream, riff, sizeof(riff), logView, quiet)) != 0)
+    {
+        return status;
+    }
+
+    if (memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0)
+    {
+        VcWaveParseWarning(logView, quiet, "Not a RIFF WAVE file");
+        return -1;
+    }
+
+    while (true)
+    {
+        char chunkId[4];
+        uint32_t chunkSize;
+        if ((status = VcReadExact(stream, chunkId, 4, logView, quiet)) != 0 
+            || (status = VcReadExact(stream, &chunkSize, 4, logView, quiet)) != 0)
+        {
+            return status;
+        }
+
+        if (memcmp(chunkId, "fmt ", 4) == 0)
+        {
+            if (chunkSize < 16)
+            {
+                VcWaveParseWarning(logView, quiet, "Invalid format chunk");
+                return -1;
+            }
+
+            if ((status = VcReadExact(stream, &info->common, 16, logView, quiet)) != 0)
+            {
+                return status;
+            }
+
+            uint32_t consumed = 16;
+            if (info->common.wFormatTag == VC_WAVE_FORMAT_EXTENSIBLE)
+            {
+                uint8_t extension[8];
+                VcWaveSubFormat subFormat;
+                if (chunkSize < 40)
+                {
+                    VcWaveParseWarning(logView, quiet, "Invalid format chunk");
+                    return -1;
+                }
+
+                if ((status = VcReadExact(stream, extension, sizeof(extension), logView, quiet)) != 0 
+                    || (status = VcReadExact(stream, &subFormat, sizeof(subFormat), logView, quiet)) != 0)
+                {
+                    return status;
+                }
+
+                // cbSize and wValidBitsPerSample come first
+                memcpy(&info->dwChannelMask, extension + 4, sizeof(info->dwChannelMask));
+                info->common.wFormatTag = subFormat.wFormatTag;
+                consumed = 40;
+            }
+
+            chunkSize -= consumed;
+            hasFormat = true;
+        }
+
+        else if (memcmp(chunkId, "data", 4) == 0)
+        {
+            if (!hasFormat)
+            {
+                VcWaveParseWarning(logView, quiet, "Data chunk found before the format chunk");
+                return -1;
+            }
+
+            info->nDataSize = chunkSize;
+            info->nDataOffset = g_seekable_tell(G_SEEKABLE(stream));
+            break;
+        }
+
+        // Chunks are padded to an even size
+        g_seekable_seek(G_SEEKABLE(stream), chunkSize + (chunkSize & 1), G_SEEK_CUR, NULL, &error);
+        if (error != NULL)
+        {
+            VcWaveParseWarning(logView, quiet, error->message);
+            g_error_free(error);
+            return -1;
+        }
+    }
+
+    if (info->common.wFormatTag != VC_WAVE_FORMAT_PCM && info->common.wFormatTag != VC_WAVE_FORMAT_IEEE_FLOAT)
+    {
+        VcWaveParseWarning(logView, quiet, "Format not recognized");
+        return -1;
+    }
+
+    if (info->common.nBlockAlign == 0 || info->common.nChannels == 0)
+    {
+        VcWaveParseWarning(logView, quiet, "Invalid format chunk");
+        return -1;
+    }
+
+    if (logView != NULL && !quiet)
+    {
+        VcLogViewWriteLine(logView, "Header processed:");
+        VcLogViewWriteLine(logView, "Number of channels: %d", info->common.nChannels);
+        VcLogViewWriteLine(logView, "Bits per sample: %d", info->common.wBitsPerSample);
+        VcLogViewWriteLine(logView, "Sample rate: %d", info->common.nSamplesPerSec);
+    }
+
+    return 0;
+}
+
+int VcReadWaveInfo(GInputStream *stream, VcWaveInfo *info, GtkTextView *logView)
+{
+    return VcParseWaveInfo(stream, info, logView, false) == 0 ? 0 : -1;
+}
+
+// Like VcReadWaveInfo but silent, VC_WAVE_INCOMPLETE means the header isn't all there yet
+int VcProbeWaveInfo(GInputStream *stream, VcWaveInfo *info)
+{
+    return VcParseWaveInfo(stream, info, NULL, true);
+}
+
+uint64_t VcWaveFrameCount(VcWaveInfo *info)
+{
+    return info->nDataSize / info->common.nBlockAlign;
+}
+
+// Canonical header for frames of the given format. Anything beyond 16 bit stereo PCM is written
+// as WAVE_FORMAT_EXTENSIBLE, which is where the channel mask and the float subformat live.
+int VcWaveWriteHeader(GOutputStream *stream, const VcWaveHeaderCommon *format, uint32_t channelMask, uint64_t frames, GError **error)
+{
+    static const uint8_t subFormatTail[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 };
+
+    uint64_t dataSize = frames * format->nBlockAlign;
+    bool extensible = format->nChannels > 2 || format->wBitsPerSample > 16 || format->wFormatTag != VC_WAVE_FORMAT_PCM;
+    uint32_t formatSize = extensible ? 40 : 16;
+    if (dataSize + formatSize + 20 > G_MAXUINT32)
+    {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Too long for a WAV file");
+        return -1;
+    }
+
+    uint8_t header[68];
+    uint32_t size = 0;
+    uint32_t riffSize = (uint32_t)(4 + 8 + formatSize + 8 + dataSize);
+    uint16_t cbSize = 22;
+    uint16_t validBits = format->wBitsPerSample;
+    VcWaveHeaderCommon common = *format;
+    common.wFormatTag = extensible ? VC_WAVE_FORMAT_EXTENSIBLE : format->wFormatTag;
+
+    memcpy(header + size, "RIFF", 4);                   size += 4;
+    memcpy(header + size, &riffSize, 4);                size += 4;
+    memcpy(header + size, "WAVEfmt ", 8);               size += 8;
+    memcpy(header + size, &formatSize, 4);              size += 4;
+    memcpy(header + size, &common, 16);                 size += 16;
+    if (extensible)
+    {
+        memcpy(header + size, &cbSize, 2);              size += 2;
+        memcpy(header + size, &validBits, 2);           size += 2;
+        memcpy(header + size, &channelMask, 4);         size += 4;
+        memcpy(header + size, &format->wFormatTag, 2);  size += 2;
+        memcpy(header + size, subFormatTail, 14);       size += 14;
+    }
+    uint32_t dataSize32 = (uint32_t)dataSize;
+    memcpy(header + size, "data", 4);                   size += 4;
+    memcpy(header + size, &dataSize32, 4);              size += 4;
+
+    return g_output_stream_write_all(stream, header, size, NULL, NULL, error) ? 0 : -1;
+}
+
+static void VcWaveConvertPCM(VcWaveHeaderCommon *format, const uint8_t *src, size_t frames, float *dst)
+{
+    uint16_t bytesPerSample = format->wBitsPerSample / 8;
+    uint16_t stride = bytesPerSample * format->nChannels;
+    for(size_t i = 0; i < frames; i++)
+    {
+        for (size_t ch = 0; ch < format->nChannels; ch++)
+        {
+            switch (bytesPerSample)
+            {
+                case 1:
+                {
+                    uint8_t sample = (uint8_t) (src[i * stride + ch]);
+                    dst[i * format->nChannels + ch] = (sample - 128) / 128.0f;
+                    break;
+                }
+
+                case 2:
+                {
+                    uint16_t sample = (((uint16_t) src[i * stride + ch * bytesPerSample]) 
+                    | ((uint16_t) src[i * stride + ch * bytesPerSample + 1] << 8));
+                    dst[i * format->nChannels + ch] = ((int16_t) sample) / 32768.0f;
+                    break;
+                }
+
+                case 3:
+                {
+                    uint32_t sample = (((uint32_t) src[i * stride + ch * bytesPerSample]) 
+                    | ((uint32_t) src[i * stride + ch * bytesPerSample + 1] << 8)
+                    | ((uint32_t) src[i * stride + ch * bytesPerSample + 2] << 16));
+                    sample &= 0x00ffffff;
+                    sample |= 0xff000000 * ((sample & 0x00800000) != 0);  // checks if 24th bit is 1 and ors highest byte with 0xff if true
+                    dst[i * format->nChannels + ch] = ((int32_t) sample) / 8388608.0f;
+                    break;
+                }
+
+                case 4:
+                {
+                    uint32_t sample = (((uint32_t) src[i * stride + ch * bytesPerSample]) 
+                    | ((uint32_t) src[i * stride + ch * bytesPerSample + 1] << 8)
+                    | ((uint32_t) src[i * stride + ch * bytesPerSample + 2] << 16)
+                    | ((uint32_t) src[i * stride + ch * bytesPerSample + 3] << 24));
+                    dst[i * format->nChannels + ch] = ((int32_t) sample) / 2147483648.0;
+                    break;
+                }
+
+                default: break;
+            }
+            
+        }
+        
+    }
+}
+
+static void VcWaveConvertFloat(VcWaveHeaderCommon *format, const uint8_t *src, size_t frames, float *dst)
+{
+    uint16_t bytesPerSample = format->wBitsPerSample / 8;
+    uint16_t stride = bytesPerSample * format->nChannels;
+
+    for(size_t i = 0; i < frames; i++)
+    {
+        for (size_t ch = 0; ch < format->nChannels; ch++)
+        {
+            if (bytesPerSample == 4)
+            {
+                float sample;
+                memcpy(&sample, &src[i * stride + ch * bytesPerSample], sizeof(sample));
+                dst[i * format->nChannels + ch] = sample;
+            }
+
+            else if (bytesPerSample == 8)
+            {
+                double sample;
+                memcpy(&sample, &src[i * stride + ch * bytesPerSample], sizeof(sample));
+                dst[i * format->nChannels + ch] = sample;
+            }
+        }
+    }
+}
+
+// Converts to interleaved float, channels keep their order in the file
+void VcWaveConvert(VcWaveHeaderCommon *format, const uint8_t *src, size_t frames, float *dst)
+{
+    switch (((VcWaveFormat) format->wFormatTag))
+    {
+        case VC_WAVE_FORMAT_PCM:
+        {
+            VcWaveConvertPCM(format, src, frames, dst);
+            break;
+        }
+
+        case VC_WAVE_FORMAT_IEEE_FLOAT:
+        {
+            VcWaveConvertFloat(format, src, frames, dst);
+            break;
+        }
+
+        default: break;
+    }
+}
+
+// One sample of the file as float. Every caller passes bytes and isFloat as constants, so once
+// inlined the loop around it carries no format branch.
+static inline __attribute__((always_inline)) float VcWaveLoadSample(const uint8_t *p, int bytes, bool isFloat)
+{
+    if (isFloat)
+    {
+        if (bytes == 4)
+        {
+            float sample;
+            memcpy(&sample, p, sizeof(sample));
+            return sample;
+        }
+
+        double sample;
+        memcpy(&sample, p, sizeof(sample));
+        return (float)sample;
+    }
+
+    switch (bytes)
+    {
+        case 1:     return (p[0] - 128) / 128.0f;
+        case 2:     return (int16_t)(p[0] | (p[1] << 8)) / 32768.0f;
+        case 3:     return ((int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8) / 8388608.0f;
+        default:    return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24)) / 2147483648.0f;
+    }
+}
+
+// Adds gain times one input channel to an output channel, or stores it for the first input
+static inline __attribute__((always_inline)) void VcWaveAccumulate(float *restrict out, const uint8_t *restrict in, size_t frames, 
+    size_t stride, float gain, int bytes, bool isFloat, bool first)
+{
+    for (size_t i = 0; i < frames; i++)
+    {
+        float sample = gain * VcWaveLoadSample(in + i * stride, bytes, isFloat);
+        out[i] = first ? sample : out[i] + sample;
+    }
+}
+
+#define VC_WAVE_ACCUMULATE(bytes, isFloat) \
+    (first ? VcWaveAccumulate(out, in, frames, stride, gain, bytes, isFloat, true) \
+           : VcWaveAccumulate(out, in, frames, stride, gain, bytes, isFloat, false))
+
+static void VcWaveAccumulateFormat(const VcWaveHeaderCommon *format, float *out, const uint8_t *in, size_t frames, float gain, bool first)
+{
+    size_t stride = format->nBlockAlign;
+    if (format->wFormatTag == VC_WAVE_FORMAT_IEEE_FLOAT)
+    {
+        format->wBitsPerSample == 64 ? VC_WAVE_ACCUMULATE(8, true) : VC_WAVE_ACCUMULATE(4, true);
+        return;
+    }
+
+    switch (format->wBitsPerSample / 8)
+    {
+        case 1:     VC_WAVE_ACCUMULATE(1, false); break;
+        case 2:     VC_WAVE_ACCUMULATE(2, false); break;
+        case 3:     VC_WAVE_ACCUMULATE(3, false); break;
+        default:    VC_WAVE_ACCUMULATE(4, false); break;
+    }
+}
+
+#undef VC_WAVE_ACCUMULATE
+
+// Converts, reorders and mixes raw frames in one pass straight into planar output. Each output
+// channel is built with contiguous stores, one run over the block per input channel it takes from.
+static void VcWaveConvertMix(const VcWaveHeaderCommon *format, const VcChannelMix *mix, const uint8_t *src, size_t frames, float **dst)
+{
+    int bytesPerSample = format->wBitsPerSample / 8;
+    for (int out = 0; out < mix->nOutChannels; out++)
+    {
+        if (mix->source[out] >= 0)
+        {
+            VcWaveAccumulateFormat(format, dst[out], src + mix->source[out] * bytesPerSample, frames, 1.0f, true);
+            continue;
+        }
+
+        bool first = true;
+        for (int in = 0; in < mix->nInChannels; in++)
+        {
+            float gain = mix->matrix[out][in];
+            if (gain != 0.0f)
+            {
+                VcWaveAccumulateFormat(format, dst[out], src + in * bytesPerSample, frames, gain, first);
+                first = false;
+            }
+        }
+
+        if (first)
+        {
+            memset(dst[out], 0, frames * sizeof(float));
+        }
+    }
+}
+
+// Positions the stream at the first frame of the range and sets up the conversion
+static int VcWaveReaderSetup(VcWaveReader *reader, uint64_t startFrame, uint64_t frames, GtkTextView *logView)
+{
+    GError *error = NULL;
+    g_seekable_seek(G_SEEKABLE(reader->stream), reader->info.nDataOffset + startFrame * reader->info.common.nBlockAlign, G_SEEK_SET, NULL, &error);
+    if (error != NULL)
+    {
+        VcWaveWarning(logView, error->message);
+        g_error_free(error);
+        return -1;
+    }
+
+    // Channels come out in vorbis order by default
+    if (VcChannelMixInit(&reader->mix, reader->info.common.nChannels, reader->info.dwChannelMask, VC_MIX_KEEP) < 0)
+    {
+        VcWaveWarning(logView, "Unsupported channel layout");
+        return -1;
+    }
+
+    reader->nChannels = reader->mix.nOutChannels;
+    reader->nFramesLeft = frames;
+    reader->pRaw = g_malloc(VC_WAVE_BLOCK_FRAMES * reader->info.common.nBlockAlign);
+
+    return 0;
+}
+
+int VcWaveReaderOpen(VcWaveReader *reader, GInputStream *stream, uint64_t startFrame, uint64_t endFrame, GtkTextView *logView)
+{
+    memset(reader, 0, sizeof(VcWaveReader));
+    reader->stream = stream;
+
+    if (VcReadWaveInfo(stream, &reader->info, logView) < 0)
+    {
+        return -1;
+    }
+
+    // Clamp the requested range to the data chunk and jump straight to its first frame
+    uint64_t totalFrames = VcWaveFrameCount(&reader->info);
+    startFrame = MIN(startFrame, totalFrames);
+    endFrame = endFrame == 0 ? totalFrames : MIN(endFrame, totalFrames);
+    if (endFrame <= startFrame)
+    {
+        VcWaveWarning(logView, "Empty encoding range");
+        return -1;
+    }
+
+    if ((startFrame > 0 || endFrame < totalFrames) && logView != NULL)
+    {
+        VcLogViewWriteLine(logView, "Encoding frames %llu to %llu", (unsigned long long)startFrame, (unsigned long long)endFrame);
+    }
+
+    return VcWaveReaderSetup(reader, startFrame, endFrame - startFrame, logView);
+}
+
+static bool VcWaveFollowIdle(VcWaveReader *reader, double seconds)
+{
+    return seconds > 0.0 && g_get_monotonic_time() - reader->nLastGrowth >= (gint64)(seconds * G_USEC_PER_SEC);
+}
+
+static bool VcWaveFollowCancelled(VcWaveReader *reader)
+{
+    return reader->follow.pCancel != NULL && g_atomic_int_get(reader->follow.pCancel);
+}
+
+static bool VcWaveFollowSentinel(VcWaveReader *reader)
+{
+    return reader->follow.pSentinel != NULL && g_file_test(reader->follow.pSentinel, G_FILE_TEST_EXISTS);
+}
+
+// For a file that is still being recorded: the header may not be there yet and its data size is a
+// placeholder, so the range is open ended and only the start of it is skipped to
+int VcWaveReaderOpenFollow(VcWaveReader *reader, GInputStream *stream, uint64_t startFrame, uint64_t endFrame, const VcWaveFollow *follow, GtkTextView *logView)
+{
+    memset(reader, 0, sizeof(VcWaveReader));
+    reader->stream = stream;
+    reader->bFollow = true;
+    reader->follow = *follow;
+    reader->nLastGrowth = g_get_monotonic_time();
+
+    // The header wait is bounded on its own, an idle setting of 0 must not turn a file that never
+    // gets a header into an encode that can't end
+    gint64 deadline = reader->nLastGrowth + (gint64)(VC_WAVE_FOLLOW_HEADER_TIMEOUT * G_USEC_PER_SEC);
+    int status;
+    while ((status = VcProbeWaveInfo(stream, &reader->info)) == VC_WAVE_INCOMPLETE)
+    {
+        if (VcWaveFollowCancelled(reader))
+        {
+            VcWaveWarning(logView, "Stopped waiting for the recording's header");
+            return -1;
+        }
+
+        if (VcWaveFollowSentinel(reader) || VcWaveFollowIdle(reader, follow->dIdleSeconds) || g_get_monotonic_time() >= deadline)
+        {
+            break;
+        }
+
+        g_usleep(VC_WAVE_FOLLOW_POLL);
+    }
+
+    // Once more to log why
+    if (status != 0 && VcReadWaveInfo(stream, &reader->info, logView) < 0)
+    {
+        return -1;
+    }
+
+    if (logView != NULL)
+    {
+        VcLogViewWriteLine(logView, "Following the recording until %s%s%s", 
+            follow->pSentinel != NULL ? follow->pSentinel : "its header is finalized",
+            follow->pSentinel != NULL ? " appears or its header is finalized" : "", 
+            follow->dIdleSeconds > 0.0 ? ", or it stops growing" : "");
+    }
+
+    return VcWaveReaderSetup(reader, startFrame, endFrame > startFrame ? endFrame - startFrame : G_MAXUINT64, logView);
+}
+
+// The data size the writer has put in the header, -1 while it is still a placeholder
+static int64_t VcWaveFollowHeaderSize(VcWaveReader *reader, GError **error)
+{
+    GSeekable *seekable = G_SEEKABLE(reader->stream);
+    goffset position = g_seekable_tell(seekable);
+    uint32_t size = 0;
+    gsize nBytes = 0;
+
+    if (!g_seekable_seek(seekable, reader->info.nDataOffset - 4, G_SEEK_SET, NULL, error)
+        || !g_input_stream_read_all(reader->stream, &size, sizeof(size), &nBytes, NULL, error)
+        || !g_seekable_seek(seekable, position, G_SEEK_SET, NULL, error))
+    {
+        return -2;
+    }
+
+    return nBytes == sizeof(size) && size != 0 && size != G_MAXUINT32 ? (int64_t)size : -1;
+}
+
+// Called when nothing new could be read: 1 to try again, 0 once the recording is over
+static int VcWaveFollowWait(VcWaveReader *reader, GError **error)
+{
+    if (reader->bEnding)
+    {
+        return 0;
+    }
+
+    int64_t size = VcWaveFollowHeaderSize(reader, error);
+    if (size == -2)
+    {
+        return -1;
+    }
+
+    // A header that claims exactly what has been read could also be a writer updating it as it goes
+    int64_t consumed = g_seekable_tell(G_SEEKABLE(reader->stream)) - reader->info.nDataOffset;
+    bool finalized = size >= 0 && consumed >= size && VcWaveFollowIdle(reader, VC_WAVE_FOLLOW_SETTLE);
+
+    reader->bEnding = finalized || VcWaveFollowCancelled(reader) || VcWaveFollowSentinel(reader) || VcWaveFollowIdle(reader, reader->follow.dIdleSeconds);
+    if (!reader->bEnding)
+    {
+        g_usleep(VC_WAVE_FOLLOW_POLL);
+    }
+
+    return 1;
+}
+
+// Changes the channels read from here on, nChannels is updated to the new count
+int VcWaveReaderSetLayout(VcWaveReader *reader, VcMixLayout layout)
+{
+    if (VcChannelMixInit(&reader->mix, reader->info.common.nChannels, reader->info.dwChannelMask, layout) < 0)
+    {
+        return -1;
+    }
+
+    reader->nChannels = reader->mix.nOutChannels;
+    return 0;
+}
+
+// Returns the number of frames converted into channels, 0 at the end of the range and -1 on error
+long VcWaveReaderRead(VcWaveReader *reader, float **channels, int maxFrames, GError **error)
+{
+    uint16_t blockAlign = reader->info.common.nBlockAlign;
+    size_t frames = MIN((uint64_t)MIN(maxFrames, VC_WAVE_BLOCK_FRAMES), reader->nFramesLeft);
+    if (frames == 0)
+    {
+        return 0;
+    }
+
+    // Only whole frames are ever converted, a truncated last frame is dropped
+    gsize nBytes = 0;
+    g_input_stream_read_all(reader->stream, reader->pRaw, frames * blockAlign, &nBytes, NULL, error);
+    if (*error != NULL)
+    {
+        return -1;
+    }
+
+    // While following, a frame the writer is in the middle of is read again next time and
+    // an empty read waits for more data unless the recording is over
+    while (reader->bFollow && nBytes < frames * blockAlign)
+    {
+        gsize partial = nBytes % blockAlign;
+        if (partial > 0 && !g_seekable_seek(G_SEEKABLE(reader->stream), -(goffset)partial, G_SEEK_CUR, NULL, error))
+        {
+            return -1;
+        }
+
+        nBytes -= partial;
+        if (nBytes > 0)
+        {
+            break;
+        }
+
+        int more = VcWaveFollowWait(reader, error);
+        if (more <= 0)
+        {
+            reader->nFramesLeft = 0;
+            return more;
+        }
+
+        g_input_stream_read_all(reader->stream, reader->pRaw, frames * blockAlign, &nBytes, NULL, error);
+        if (*error != NULL)
+        {
+            return -1;
+        }
+    }
+
+    if (reader->bFollow && nBytes > 0)
+    {
+        reader->nLastGrowth = g_get_monotonic_time();
+        reader->bEnding = false;
+    }
+
+    frames = nBytes / blockAlign;
+    reader->nFramesLeft = frames > 0 ? reader->nFramesLeft - frames : 0;
+    VcWaveConvertMix(&reader->info.common, &reader->mix, reader->pRaw, frames, channels);
+
+    return frames;
+}
+
+void VcWaveReaderClose(VcWaveReader *reader)
+{
+    g_free(reader->pRaw);
+    reader->pRaw = NULL;
+}
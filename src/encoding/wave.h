@@ -0,0 +1,90 @@
+#ifndef VC_WAVE_H
+#define VC_WAVE_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <stdint.h>
+#include "../dsp/channel-mix.h"
+
+#define VC_WAVE_BLOCK_FRAMES 1024
+#define VC_WAVE_FOLLOW_POLL     200000      // microseconds between looks at a file that is still growing
+#define VC_WAVE_FOLLOW_SETTLE   2.0         // seconds a patched header has to stay put before it is believed
+#define VC_WAVE_FOLLOW_HEADER_TIMEOUT 60.0  // seconds to wait for a followed file's header, whatever the idle setting
+#define VC_WAVE_INCOMPLETE      1           // VcProbeWaveInfo: the header is cut short, it may still be written
+
+typedef enum
+{
+    VC_WAVE_FORMAT_PCM          = 1,
+    VC_WAVE_FORMAT_IEEE_FLOAT   = 3,
+    VC_WAVE_FORMAT_ALAW         = 6,
+    VC_WAVE_FORMAT_MULAW        = 7,
+    VC_WAVE_FORMAT_EXTENSIBLE   = 0xfffe
+
+} VcWaveFormat;
+
+typedef struct
+{
+    uint16_t    wFormatTag;
+    uint8_t     padding[14];
+
+} VcWaveSubFormat;
+
+typedef struct
+{
+    uint16_t        wFormatTag;
+	uint16_t        nChannels; 	
+	uint32_t        nSamplesPerSec;
+	uint32_t        nAvgBytesPerSec;
+	uint16_t        nBlockAlign;
+	uint16_t        wBitsPerSample;
+
+} VcWaveHeaderCommon;
+
+typedef struct
+{
+    VcWaveHeaderCommon  common;
+    uint32_t            dwChannelMask;  // speaker positions of WAVE_FORMAT_EXTENSIBLE files, 0 otherwise
+    uint32_t            nDataSize;
+    goffset             nDataOffset;    // position of the first sample in the file
+
+} VcWaveInfo;
+
+// How to tell a recording that is still being written has ended
+typedef struct
+{
+    const char          *pSentinel;     // file whose appearance ends it, NULL for none
+    double              dIdleSeconds;   // no growth for this long ends it too, 0 waits for the sentinel or the header
+    gint                *pCancel;       // optional, set from another thread to stop following
+
+} VcWaveFollow;
+
+// Reads a frame range of the data chunk as planar float blocks, in vorbis channel order
+typedef struct
+{
+    GInputStream        *stream;
+    VcWaveInfo          info;
+    uint64_t            nFramesLeft;
+    uint8_t             *pRaw;
+    VcChannelMix        mix;
+    int                 nChannels;      // channels produced, after any downmix
+
+    // Follow mode, the header's data size is ignored and short reads wait for more
+    bool                bFollow;
+    VcWaveFollow        follow;
+    gint64              nLastGrowth;    // monotonic time of the last read that got data
+    bool                bEnding;        // end seen, one last read picks up what came before it
+
+} VcWaveReader;
+
+int         VcReadWaveInfo(GInputStream *stream, VcWaveInfo *info, GtkTextView *logView);
+int         VcProbeWaveInfo(GInputStream *stream, VcWaveInfo *info);
+uint64_t    VcWaveFrameCount(VcWaveInfo *info);
+void        VcWaveConvert(VcWaveHeaderCommon *format, const uint8_t *src, size_t frames, float *dst);
+int         VcWaveWriteHeader(GOutputStream *stream, const VcWaveHeaderCommon *format, uint32_t channelMask, uint64_t frames, GError **error);
+
+int         VcWaveReaderOpen(VcWaveReader *reader, GInputStream *stream, uint64_t startFrame, uint64_t endFrame, GtkTextView *logView);
+int         VcWaveReaderOpenFollow(VcWaveReader *reader, GInputStream *stream, uint64_t startFrame, uint64_t endFrame, const VcWaveFollow *follow, GtkTextView *logView);
+int         VcWaveReaderSetLayout(VcWaveReader *reader, VcMixLayout layout);
+long        VcWaveReaderRead(VcWaveReader *reader, float **channels, int maxFrames, GError **error);
+void        VcWaveReaderClose(VcWaveReader *reader);
+
+#endif // VC_WAVE_H
@@ -2,7 +2,16 @@
 #include "log-view.h"
 #include "../encoding/options.h"
 #include "../encoding/encoding.h"
+#include "../encoding/wave.h"
+#include "../encoding/preview.h"
+#include "../encoding/ladder.h"
+#include "../encoding/auto-quality.h"
+#include "../encoding/transcode.h"
+#include "../encoding/atomic-output.h"
+#include "../decoding/decoding.h"
+#include "../editing/ogg-edit.h"
 #include "../audio-io/audio-io.h"
+#include "../audio-io/capture.h"
 
 static VcEncodeOptions  encodingOptions      = { 0 };
 static GtkWidget        *inputFileLabel         = NULL;
@@ -12,6 +21,73 @@ static size_t           inputFileSize           = 0;
 static size_t           outputFileSize          = 0;
 static GtkWidget        *playbackButton         = NULL; 
 static GtkWidget        *stopButton             = NULL;
+static GtkWidget        *latencySpinButton      = NULL;
+static GtkWidget        *latencyLabel           = NULL;
+static GtkWidget        *telemetryLabel         = NULL;
+static GtkWidget        *seekScale              = NULL;
+static GtkWidget        *inMemoryCheckButton    = NULL;
+static GtkWidget        *rangeStartSpinButton   = NULL;
+static GtkWidget        *rangeEndSpinButton     = NULL;
+static VcWaveInfo       inputWaveInfo           = { 0 };
+static gchar            *inputFilePath          = NULL;
+static GtkWidget        *qualitySpinButton      = NULL;
+static GtkWidget        *previewButton          = NULL;
+static GtkWidget        *previewQualitiesEntry  = NULL;
+static GtkWidget        *previewResultsDropDown = NULL;
+static VcPreviewOptions previewOptions          = { 0 };
+static GThread          *previewThread          = NULL;
+static GtkWidget        *ladderButton           = NULL;
+static GtkWidget        *decodeButton           = NULL;
+static GtkWidget        *transcodeButton        = NULL;
+static VcTranscodeOptions transcodeOptions      = { 0 };
+static GThread          *transcodeThread        = NULL;
+static GTimer           *transcodeTimer         = NULL;
+static GtkWidget        *cutButton              = NULL;
+static GtkWidget        *cutStartSpinButton     = NULL;
+static GtkWidget        *cutEndSpinButton       = NULL;
+static GtkWidget        *joinButton             = NULL;
+static VcOggEditOptions editOptions             = { 0 };
+static GThread          *editThread             = NULL;
+static GtkWidget        *segmentSpinButton      = NULL;
+static GtkWidget        *segmentFilesCheckButton = NULL;
+static GtkWidget        *liveTargetEntry        = NULL;
+static GtkWidget        *liveLatencySpinButton  = NULL;
+static GtkWidget        *livePageSpinButton     = NULL;
+static GtkWidget        *recordButton           = NULL;
+static GtkWidget        *dummyInputCheckButton  = NULL;
+static VcCaptureOptions captureOptions          = { 0 };
+static GThread          *captureThread          = NULL;
+static GtkWidget        *followCheckButton      = NULL;
+static GtkWidget        *followIdleSpinButton   = NULL;
+static GtkWidget        *decodeFormatDropDown   = NULL;
+static VcDecodeOptions  decodeOptions           = { 0 };
+static GThread          *decodeThread           = NULL;
+static GTimer           *decodeTimer            = NULL;
+static GtkWidget        *ladderQualitiesEntry   = NULL;
+static VcLadderOptions  ladderOptions           = { 0 };
+static GThread          *ladderThread           = NULL;
+static GtkWidget        *targetSizeSpinButton   = NULL;
+static GtkWidget        *targetBitrateSpinButton = NULL;
+static VcAutoQualityOptions autoQualityOptions  = { 0 };
+static GThread          *autoQualityThread      = NULL;
+static GtkWidget        *rateModeDropDown       = NULL;
+static GtkWidget        *bitrateSpinButton      = NULL;
+static GtkWidget        *maxBitrateSpinButton   = NULL;
+static GtkWidget        *reservoirSpinButton    = NULL;
+static GtkWidget        *lowpassSpinButton      = NULL;
+static GtkWidget        *impulseBlockSpinButton = NULL;
+static GtkWidget        *couplingCheckButton    = NULL;
+static GtkWidget        *outputRateDropDown     = NULL;
+static GtkWidget        *resampleQualityDropDown = NULL;
+static const long       outputRates[]           = { 0, 48000, 44100 };
+static GtkWidget        *mixLayoutDropDown      = NULL;
+static GtkWidget        *loudnessCheckButton    = NULL;
+static GtkWidget        *verifyCheckButton      = NULL;
+static GtkWidget        *integrityCheckButton   = NULL;
+static GtkWidget        *trimLeadingCheckButton = NULL;
+static GtkWidget        *trimTrailingCheckButton = NULL;
+static GtkWidget        *silenceThresholdSpinButton = NULL;
+static GtkWidget        *minSilenceSpinButton   = NULL;
 static GtkWidget        *logView                = NULL;
 static GtkWidget        *chooseFileButton       = NULL;
 static GtkWidget        *convertButton          = NULL;
@@ -20,18 +96,40 @@ static GtkWidget        *spinner                = NULL;
 static GTimer           *timer                  = NULL;
 static GThread          *encoderThread          = NULL;
 static GFile            *outFile                = NULL;
+static VcAtomicOutput   atomicOutput            = { 0 };
+static bool             growingPreview          = false;    // playback is following the encode in progress
+
+// Drops the unfinished output and preview and hands the controls back to the user
+static void VcDiscardEncode(VcEncodeOptions *_encodingOptions, bool previewing)
+{
+    VcAtomicOutputAbort(&atomicOutput);
+    if (previewing)
+    {
+        VcAudioIoClose();
+        VcToggleMediaControls(false);
+        gtk_button_set_icon_name(GTK_BUTTON(playbackButton), "media-playback-start");
+    }
+    VcSeekIndexFree(_encodingOptions->pSeekIndex);
+    _encodingOptions->pSeekIndex = NULL;
+    VcOggBufferUnref(_encodingOptions->pOggBuffer);
+    _encodingOptions->pOggBuffer = NULL;
+    gtk_spinner_stop(GTK_SPINNER(spinner));
+    gtk_widget_set_sensitive(convertButton, true);
+    gtk_widget_set_sensitive(chooseFileButton, true);
+}
 
 void VcOnEncodeFinished(gpointer data)
 {
     VcEncodeOptions *_encodingOptions = (VcEncodeOptions *)data;
     int status = (int)g_thread_join(encoderThread);
+    encoderThread = NULL;
+    bool previewing = growingPreview;
+    growingPreview = false;
     g_timer_stop(timer);
     if (status < 0)
     {
         VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Encription failed!");
-        gtk_spinner_stop(GTK_SPINNER(spinner));
-        gtk_widget_set_sensitive(convertButton, true);
-        gtk_widget_set_sensitive(chooseFileButton, true);
+        VcDiscardEncode(_encodingOptions, previewing);
         return;
     }
 
@@ -47,22 +145,56 @@ void VcOnEncodeFinished(gpointer data)
     GFileInfo *outFileInfo = g_file_output_stream_query_info(outFileStream, G_FILE_ATTRIBUTE_STANDARD_SIZE, NULL, &error);
     if (error != NULL)
     {
-        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "%s", error->message);
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Couldn't read the output size: %s", error->message);
         g_error_free(error);
+        VcDiscardEncode(_encodingOptions, previewing);
+        return;
+    }
+
+    // The finished file replaces the destination in one rename, an existing file stays intact until now
+    if (VcAtomicOutputCommit(&atomicOutput, &error) < 0)
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Couldn't move the output into place: %s", error != NULL ? error->message : "not open");
+        g_clear_error(&error);
+        g_object_unref(outFileInfo);
+        VcDiscardEncode(_encodingOptions, previewing);
         return;
     }
 
     const char *outFilePath = g_file_get_path(G_FILE(outFile));
 
-    if (VcAudioIoIsInitialized())
+    // Playback takes ownership of the index built while encoding
+    if (_encodingOptions->pOggBuffer != NULL)
     {
-        VcAudioIoFinalize();
+        // Switch the live preview over to the finished, seekable buffer without interrupting it
+        double position = VcAudioIoGetPosition();
+        bool playing = VcAudioIoIsPlaying();
+        VcToggleMediaControls(VcAudioIoOpenBuffer(_encodingOptions->pOggBuffer, _encodingOptions->pSeekIndex));
+        VcOggBufferUnref(_encodingOptions->pOggBuffer);
+        _encodingOptions->pOggBuffer = NULL;
+
+        if (position > 0.0)
+        {
+            VcAudioIoSeek(position);
+        }
+
+        if (playing)
+        {
+            VcAudioIoTogglePlayback();
+        }
+
+        gtk_button_set_icon_name(playbackButton, playing ? "media-playback-pause" : "media-playback-start");
     }
-    VcAudioIoInit(outFilePath);
 
-    VcToggleMediaControls(true);
-
-    gtk_button_set_icon_name(playbackButton, "media-playback-start");
+    else
+    {
+        VcToggleMediaControls(VcAudioIoOpen(outFilePath, _encodingOptions->pSeekIndex));
+        gtk_button_set_icon_name(playbackButton, "media-playback-start");
+    }
+    _encodingOptions->pSeekIndex = NULL;
+    gtk_range_set_range(GTK_RANGE(seekScale), 0.0, MAX(VcAudioIoGetDuration(), 0.001));
+    gtk_range_set_value(GTK_RANGE(seekScale), VcAudioIoGetPosition());
     
     outputFileSize = g_file_info_get_size(outFileInfo);
     
@@ -73,6 +205,12 @@ void VcOnEncodeFinished(gpointer data)
         VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Output size: %d bytes", outputFileSize);
         VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Compression rate: %3.2f%%", (float)(outputFileSize) / (float)(inputFileSize) * 100);
         VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Saved at %s", outFilePath);
+        if (autoQualityOptions.nPredictedBytes > 0)
+        {
+            double error = ((double)outputFileSize - autoQualityOptions.nPredictedBytes) / autoQualityOptions.nPredictedBytes * 100.0;
+            VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Predicted size: %lld bytes (%+.1f%% off)", (long long)autoQualityOptions.nPredictedBytes, error);
+            autoQualityOptions.nPredictedBytes = 0;
+        }
         gtk_widget_set_visible(GTK_WIDGET(outputFileLabel), true);
     }
 
@@ -83,8 +221,6 @@ void VcOnEncodeFinished(gpointer data)
     gtk_widget_set_sensitive(convertButton, true);
     gtk_widget_set_sensitive(chooseFileButton, true);
 
-    g_output_stream_close(outFileStream, NULL, NULL);
-
     free(outFilePath);
 }
 
@@ -92,6 +228,7 @@ void VcToggleMediaControls(gboolean state)
 {
     gtk_widget_set_sensitive(playbackButton, state);
     gtk_widget_set_sensitive(stopButton, state);
+    gtk_widget_set_sensitive(seekScale, state);
 }
 
 void VcFileReadFinished(GObject *inFile, GAsyncResult *res, gpointer data)
@@ -107,6 +244,8 @@ void VcFileReadFinished(GObject *inFile, GAsyncResult *res, gpointer data)
     
     const char *inFilePath = g_file_get_path(G_FILE(inFile));
     gtk_label_set_label(GTK_LABEL(inputFileLabel), inFilePath);
+    g_free(inputFilePath);
+    inputFilePath = g_strdup(inFilePath);
     GFileInfo *inFileInfo = g_file_input_stream_query_info(inFileStream, G_FILE_ATTRIBUTE_STANDARD_SIZE, NULL, &error);
     if (error != NULL)
     {
@@ -116,8 +255,20 @@ void VcFileReadFinished(GObject *inFile, GAsyncResult *res, gpointer data)
     }
 
     inputFileSize = g_file_info_get_size(inFileInfo);
+
+    // Probe the header so the range controls can be limited to the length of the file
+    if (VcReadWaveInfo(G_INPUT_STREAM(inFileStream), &inputWaveInfo, NULL) == 0)
+    {
+        double duration = (double)VcWaveFrameCount(&inputWaveInfo) / inputWaveInfo.common.nSamplesPerSec;
+        gtk_spin_button_set_range(GTK_SPIN_BUTTON(rangeStartSpinButton), 0.0, duration);
+        gtk_spin_button_set_range(GTK_SPIN_BUTTON(rangeEndSpinButton), 0.0, duration);
+        gtk_spin_button_set_value(GTK_SPIN_BUTTON(rangeStartSpinButton), 0.0);
+        gtk_spin_button_set_value(GTK_SPIN_BUTTON(rangeEndSpinButton), 0.0);
+    }
     
     encodingOptions.pInFileStream = inFileStream;
+    gtk_widget_set_sensitive(previewButton, true);
+    gtk_widget_set_sensitive(ladderButton, true);
 }
 
 void VcOnInputFileDialogFinished(GObject *fileDialog, GAsyncResult *res, gpointer data)
@@ -146,6 +297,78 @@ void VcOnOpenFileClicked(GtkFileDialog *fileDialog)
     gtk_file_dialog_open(fileDialog, NULL, NULL, VcOnInputFileDialogFinished, NULL);
 }
 
+void VcReadEncoderTuning(VcEncoderTuning *tuning)
+{
+    tuning->mode                = (VcRateMode)gtk_drop_down_get_selected(GTK_DROP_DOWN(rateModeDropDown));
+    tuning->fQuality            = gtk_spin_button_get_value(GTK_SPIN_BUTTON(qualitySpinButton)) / 10.0f;
+    tuning->nBitrate            = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(bitrateSpinButton));
+    tuning->nMaxBitrate         = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(maxBitrateSpinButton));
+    tuning->dReservoirSeconds   = gtk_spin_button_get_value(GTK_SPIN_BUTTON(reservoirSpinButton));
+    tuning->dLowpass            = gtk_spin_button_get_value(GTK_SPIN_BUTTON(lowpassSpinButton));
+    tuning->dImpulseBlock       = gtk_spin_button_get_value(GTK_SPIN_BUTTON(impulseBlockSpinButton));
+    tuning->bNoCoupling         = !gtk_check_button_get_active(GTK_CHECK_BUTTON(couplingCheckButton));
+}
+
+void VcOnRateModeChanged(GObject *dropDown, GParamSpec *pspec, gpointer data)
+{
+    VcRateMode mode = (VcRateMode)gtk_drop_down_get_selected(GTK_DROP_DOWN(dropDown));
+    gtk_widget_set_sensitive(qualitySpinButton, mode == VC_RATE_VBR);
+    gtk_widget_set_sensitive(targetSizeSpinButton, mode == VC_RATE_VBR);
+    gtk_widget_set_sensitive(targetBitrateSpinButton, mode == VC_RATE_VBR);
+    gtk_widget_set_sensitive(bitrateSpinButton, mode != VC_RATE_VBR);
+    gtk_widget_set_sensitive(maxBitrateSpinButton, mode == VC_RATE_ABR);
+    gtk_widget_set_sensitive(reservoirSpinButton, mode != VC_RATE_VBR);
+}
+
+// Pages are available as soon as the encoder writes them, so preview starts once the headers are in
+gboolean VcOnPreviewHeadersReady(gpointer data)
+{
+    VcOggBuffer *buffer = (VcOggBuffer *)data;
+
+    // The encode may already be over, or a new one started
+    if (buffer == encodingOptions.pOggBuffer && encoderThread != NULL && VcAudioIoOpenGrowingBuffer(buffer))
+    {
+        growingPreview = true;
+        VcToggleMediaControls(true);
+        gtk_widget_set_sensitive(seekScale, false);
+        gtk_button_set_icon_name(GTK_BUTTON(playbackButton), "media-playback-start");
+    }
+
+    VcOggBufferUnref(buffer);
+    return G_SOURCE_REMOVE;
+}
+
+void VcStartEncode()
+{
+    if (encodingOptions.pOggBuffer != NULL)
+    {
+        VcOggBufferOnHeaders(encodingOptions.pOggBuffer, VcOnPreviewHeadersReady);
+    }
+
+    encoderThread = VcEncode(&encodingOptions);
+}
+
+void VcOnQualitySearchFinished(gpointer data)
+{
+    g_thread_join(autoQualityThread);
+    autoQualityThread = NULL;
+
+    if (autoQualityOptions.status < 0)
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Quality search failed, encoding at q%.1f", encodingOptions.tuning.fQuality * 10.0f);
+    }
+
+    else
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Quality search sampled %.2fs in %.3fs: q%.2f, predicted %lld bytes%s",
+            autoQualityOptions.dSampledSeconds, g_timer_elapsed(timer, NULL), autoQualityOptions.fQuality * 10.0f,
+            (long long)autoQualityOptions.nPredictedBytes, autoQualityOptions.bFits ? "" : " (target can't be met)");
+        encodingOptions.tuning.fQuality = autoQualityOptions.fQuality;
+    }
+
+    VcStartEncode();
+}
+
 void VcOnOutputFileDialogFinished(GObject *fileDialog, GAsyncResult *res, gpointer data)
 {
     GError *error = NULL;
@@ -168,7 +391,8 @@ void VcOnOutputFileDialogFinished(GObject *fileDialog, GAsyncResult *res, gpoint
 
     const char *outFilePath = g_file_get_path(G_FILE(outFile));
 
-    GFileOutputStream *outFileStream = g_file_replace(outFile, NULL, false, G_FILE_CREATE_REPLACE_DESTINATION, NULL, &error);
+    VcAtomicOutputAbort(&atomicOutput);
+    GFileOutputStream *outFileStream = VcAtomicOutputOpen(&atomicOutput, outFile, &error);
     if (error != NULL)
     {
         g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
@@ -177,10 +401,64 @@ void VcOnOutputFileDialogFinished(GObject *fileDialog, GAsyncResult *res, gpoint
     }
 
     encodingOptions.pOutFileStream  = outFileStream;
+    encodingOptions.pOutFile        = atomicOutput.temp;
     encodingOptions.pLogView        = logView;
     encodingOptions.cbOnFinished    = VcOnEncodeFinished;
+    encodingOptions.pSeekIndex      = VcSeekIndexNew();
+    VcReadEncoderTuning(&encodingOptions.tuning);
+    encodingOptions.nOutputRate     = outputRates[gtk_drop_down_get_selected(GTK_DROP_DOWN(outputRateDropDown))];
+    encodingOptions.resampleQuality = (VcResampleQuality)gtk_drop_down_get_selected(GTK_DROP_DOWN(resampleQualityDropDown));
+    encodingOptions.mixLayout       = (VcMixLayout)gtk_drop_down_get_selected(GTK_DROP_DOWN(mixLayoutDropDown));
+    encodingOptions.bLoudnessTags   = gtk_check_button_get_active(GTK_CHECK_BUTTON(loudnessCheckButton));
+    encodingOptions.bVerify         = gtk_check_button_get_active(GTK_CHECK_BUTTON(verifyCheckButton));
+    encodingOptions.bCheckIntegrity = gtk_check_button_get_active(GTK_CHECK_BUTTON(integrityCheckButton));
+    encodingOptions.bTrimLeading    = gtk_check_button_get_active(GTK_CHECK_BUTTON(trimLeadingCheckButton));
+    encodingOptions.bTrimTrailing   = gtk_check_button_get_active(GTK_CHECK_BUTTON(trimTrailingCheckButton));
+    encodingOptions.dSilenceThreshold = gtk_spin_button_get_value(GTK_SPIN_BUTTON(silenceThresholdSpinButton));
+    encodingOptions.dMinSilence     = gtk_spin_button_get_value(GTK_SPIN_BUTTON(minSilenceSpinButton));
+    encodingOptions.nStartFrame     = (uint64_t)(gtk_spin_button_get_value(GTK_SPIN_BUTTON(rangeStartSpinButton)) * inputWaveInfo.common.nSamplesPerSec);
+    encodingOptions.nEndFrame       = (uint64_t)(gtk_spin_button_get_value(GTK_SPIN_BUTTON(rangeEndSpinButton)) * inputWaveInfo.common.nSamplesPerSec);
+    encodingOptions.pOggBuffer      = gtk_check_button_get_active(GTK_CHECK_BUTTON(inMemoryCheckButton)) ? VcOggBufferNew() : NULL;
+    encodingOptions.dSegmentSeconds = gtk_spin_button_get_value(GTK_SPIN_BUTTON(segmentSpinButton));
+    encodingOptions.bSegmentFiles   = gtk_check_button_get_active(GTK_CHECK_BUTTON(segmentFilesCheckButton));
+    g_free(encodingOptions.pOutPath);
+    encodingOptions.pOutPath        = g_strdup(outFilePath);
+    g_free(encodingOptions.pFollowSentinel);
+    encodingOptions.bFollow         = gtk_check_button_get_active(GTK_CHECK_BUTTON(followCheckButton));
+    encodingOptions.pFollowSentinel = inputFilePath != NULL ? g_strdup_printf("%s.done", inputFilePath) : NULL;
+    encodingOptions.dFollowIdle     = gtk_spin_button_get_value(GTK_SPIN_BUTTON(followIdleSpinButton));
+    encodingOptions.nFollowCancel   = 0;
+    g_free(encodingOptions.pLiveTarget);
+    encodingOptions.pLiveTarget     = g_strdup(gtk_editable_get_text(GTK_EDITABLE(liveTargetEntry)));
+    encodingOptions.nLiveLatencyMs  = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(liveLatencySpinButton));
+    encodingOptions.nLivePageBytes  = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(livePageSpinButton));
     g_timer_start(timer);
-    encoderThread                   = VcEncode(&encodingOptions);
+
+    // With a size or bitrate target the quality is searched for first, the encode starts once it's known
+    autoQualityOptions.nTargetBytes     = (int64_t)(gtk_spin_button_get_value(GTK_SPIN_BUTTON(targetSizeSpinButton)) * 1000.0);
+    autoQualityOptions.dTargetBitrate   = gtk_spin_button_get_value(GTK_SPIN_BUTTON(targetBitrateSpinButton));
+    autoQualityOptions.nPredictedBytes  = 0;
+    if (encodingOptions.tuning.mode == VC_RATE_VBR && (autoQualityOptions.nTargetBytes > 0 || autoQualityOptions.dTargetBitrate > 0.0))
+    {
+        autoQualityOptions.pInFileStream    = encodingOptions.pInFileStream;
+        autoQualityOptions.cbOnFinished     = VcOnQualitySearchFinished;
+        autoQualityOptions.nStartFrame      = encodingOptions.nStartFrame;
+        autoQualityOptions.nEndFrame        = encodingOptions.nEndFrame;
+        autoQualityOptions.tuning           = encodingOptions.tuning;
+        autoQualityOptions.nOutputRate      = encodingOptions.nOutputRate;
+        autoQualityOptions.resampleQuality  = encodingOptions.resampleQuality;
+        autoQualityOptions.mixLayout        = encodingOptions.mixLayout;
+        autoQualityOptions.bTrimLeading     = encodingOptions.bTrimLeading;
+        autoQualityOptions.bTrimTrailing    = encodingOptions.bTrimTrailing;
+        autoQualityOptions.dSilenceThreshold = encodingOptions.dSilenceThreshold;
+        autoQualityOptions.dMinSilence      = encodingOptions.dMinSilence;
+        autoQualityThread                   = VcSearchQuality(&autoQualityOptions);
+    }
+
+    else
+    {
+        VcStartEncode();
+    }
     
     free(outFilePath);
 }
@@ -190,9 +468,577 @@ void VcOnConvertClicked(GtkFileDialog *outputFileDialog)
     gtk_spinner_start(GTK_SPINNER(spinner));
     gtk_widget_set_sensitive(convertButton, false);
     gtk_widget_set_sensitive(chooseFileButton, false);
+    gtk_widget_set_sensitive(previewButton, false);
+    gtk_widget_set_sensitive(ladderButton, false);
     gtk_file_dialog_save(outputFileDialog, NULL, NULL, VcOnOutputFileDialogFinished, NULL);
 }
 
+// Comma separated vorbis qualities from -1 to 10, returned in the encoder's -0.1..1 scale
+static int VcParseQualities(GtkWidget *entry, float *qualities, int max)
+{
+    int count = 0;
+    gchar **items = g_strsplit(gtk_editable_get_text(GTK_EDITABLE(entry)), ",", -1);
+    for (int i = 0; items[i] != NULL && count < max; i++)
+    {
+        gchar *end = NULL;
+        double quality = g_ascii_strtod(items[i], &end);
+        if (end != items[i])
+        {
+            qualities[count++] = CLAMP(quality, -1.0, 10.0) / 10.0f;
+        }
+    }
+    g_strfreev(items);
+
+    return count;
+}
+
+void VcOnPreviewFinished(gpointer data)
+{
+    g_thread_join(previewThread);
+    previewThread = NULL;
+    g_timer_stop(timer);
+
+    gtk_spinner_stop(GTK_SPINNER(spinner));
+    gtk_widget_set_sensitive(convertButton, true);
+    gtk_widget_set_sensitive(chooseFileButton, true);
+    gtk_widget_set_sensitive(previewButton, true);
+    gtk_widget_set_sensitive(ladderButton, true);
+
+    VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Previews of %.2fs done in %.3fs:", previewOptions.dDuration, g_timer_elapsed(timer, NULL));
+
+    GtkStringList *items = gtk_string_list_new(NULL);
+    for (int i = 0; i < previewOptions.nQualities; i++)
+    {
+        VcPreviewResult *result = &previewOptions.results[i];
+        gchar *item = result->status < 0 
+            ? g_strdup_printf("q%.1f: failed", result->fQuality * 10.0f)
+            : g_strdup_printf("q%.1f: %zu bytes, %.1f kbit/s", result->fQuality * 10.0f, result->nBytes, result->dBitrate);
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "%s (%.3fs)", item, result->dEncodeSeconds);
+        gtk_string_list_append(items, item);
+        g_free(item);
+    }
+
+    gtk_drop_down_set_model(GTK_DROP_DOWN(previewResultsDropDown), G_LIST_MODEL(items));
+    gtk_drop_down_set_selected(GTK_DROP_DOWN(previewResultsDropDown), GTK_INVALID_LIST_POSITION);
+    gtk_widget_set_sensitive(previewResultsDropDown, true);
+    g_object_unref(items);
+}
+
+void VcOnPreviewClicked(GtkButton *button)
+{
+    if (encodingOptions.pInFileStream == NULL || previewThread != NULL)
+    {
+        return;
+    }
+
+    VcPreviewResultsClear(&previewOptions);
+    float qualities[VC_PREVIEW_MAX_QUALITIES];
+    previewOptions.nQualities = VcParseQualities(previewQualitiesEntry, qualities, VC_PREVIEW_MAX_QUALITIES);
+    for (int i = 0; i < previewOptions.nQualities; i++)
+    {
+        previewOptions.results[i].fQuality = qualities[i];
+    }
+
+    if (previewOptions.nQualities == 0)
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "No preview qualities given");
+        return;
+    }
+
+    previewOptions.pInFileStream    = encodingOptions.pInFileStream;
+    previewOptions.pLogView         = GTK_TEXT_VIEW(logView);
+    previewOptions.cbOnFinished     = VcOnPreviewFinished;
+    previewOptions.nStartFrame      = (uint64_t)(gtk_spin_button_get_value(GTK_SPIN_BUTTON(rangeStartSpinButton)) * inputWaveInfo.common.nSamplesPerSec);
+    previewOptions.nEndFrame        = (uint64_t)(gtk_spin_button_get_value(GTK_SPIN_BUTTON(rangeEndSpinButton)) * inputWaveInfo.common.nSamplesPerSec);
+
+    gtk_spinner_start(GTK_SPINNER(spinner));
+    gtk_widget_set_sensitive(convertButton, false);
+    gtk_widget_set_sensitive(chooseFileButton, false);
+    gtk_widget_set_sensitive(previewButton, false);
+    gtk_widget_set_sensitive(previewResultsDropDown, false);
+    gtk_widget_set_sensitive(ladderButton, false);
+
+    g_timer_start(timer);
+    previewThread = VcEncodePreviews(&previewOptions);
+}
+
+void VcOnPreviewResultSelected(GObject *dropDown, GParamSpec *pspec, gpointer data)
+{
+    guint selected = gtk_drop_down_get_selected(GTK_DROP_DOWN(dropDown));
+    if (selected == GTK_INVALID_LIST_POSITION || selected >= (guint)previewOptions.nQualities)
+    {
+        return;
+    }
+
+    VcPreviewResult *result = &previewOptions.results[selected];
+    if (result->status < 0 || result->pOggBuffer == NULL)
+    {
+        return;
+    }
+
+    // Clips are short and in memory, vorbisfile's own bisection is fast enough to seek them
+    VcToggleMediaControls(VcAudioIoOpenBuffer(result->pOggBuffer, NULL));
+    gtk_button_set_icon_name(GTK_BUTTON(playbackButton), "media-playback-start");
+    gtk_range_set_range(GTK_RANGE(seekScale), 0.0, MAX(VcAudioIoGetDuration(), 0.001));
+    gtk_range_set_value(GTK_RANGE(seekScale), 0.0);
+}
+
+void VcOnLadderFinished(gpointer data)
+{
+    g_thread_join(ladderThread);
+    ladderThread = NULL;
+    g_timer_stop(timer);
+
+    gtk_spinner_stop(GTK_SPINNER(spinner));
+    gtk_widget_set_sensitive(convertButton, true);
+    gtk_widget_set_sensitive(chooseFileButton, true);
+    gtk_widget_set_sensitive(previewButton, true);
+    gtk_widget_set_sensitive(ladderButton, true);
+
+    VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Ladder of %d renditions (%.2fs of audio) done in %.3fs:", ladderOptions.nRenditions, ladderOptions.dDuration, g_timer_elapsed(timer, NULL));
+    for (int i = 0; i < ladderOptions.nRenditions; i++)
+    {
+        VcLadderRendition *rendition = &ladderOptions.renditions[i];
+        if (rendition->status < 0)
+        {
+            VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "q%.1f: failed", rendition->fQuality * 10.0f);
+            continue;
+        }
+
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "q%.1f: %s, %lld bytes, %.1f kbit/s", rendition->fQuality * 10.0f, rendition->pPath, (long long)rendition->nBytes, rendition->dBitrate);
+    }
+}
+
+void VcOnLadderFileDialogFinished(GObject *fileDialog, GAsyncResult *res, gpointer data)
+{
+    GError *error = NULL;
+    GFile *baseFile = gtk_file_dialog_save_finish(GTK_FILE_DIALOG(fileDialog), res, &error);
+    if (error != NULL)
+    {
+        gtk_spinner_stop(GTK_SPINNER(spinner));
+        gtk_widget_set_sensitive(convertButton, true);
+        gtk_widget_set_sensitive(chooseFileButton, true);
+        gtk_widget_set_sensitive(previewButton, true);
+        gtk_widget_set_sensitive(ladderButton, true);
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+        return;
+    }
+
+    // Every rendition is written next to the chosen file, named after its quality
+    char *basePath = g_file_get_path(baseFile);
+    for (int i = 0; i < ladderOptions.nRenditions; i++)
+    {
+        ladderOptions.renditions[i].pPath = VcLadderRenditionPath(basePath, ladderOptions.renditions[i].fQuality);
+    }
+    g_free(basePath);
+    g_object_unref(baseFile);
+
+    ladderOptions.pInFileStream = encodingOptions.pInFileStream;
+    ladderOptions.pLogView      = GTK_TEXT_VIEW(logView);
+    ladderOptions.cbOnFinished  = VcOnLadderFinished;
+    ladderOptions.nStartFrame   = (uint64_t)(gtk_spin_button_get_value(GTK_SPIN_BUTTON(rangeStartSpinButton)) * inputWaveInfo.common.nSamplesPerSec);
+    ladderOptions.nEndFrame     = (uint64_t)(gtk_spin_button_get_value(GTK_SPIN_BUTTON(rangeEndSpinButton)) * inputWaveInfo.common.nSamplesPerSec);
+
+    g_timer_start(timer);
+    ladderThread = VcEncodeLadder(&ladderOptions);
+}
+
+void VcOnLadderClicked(GtkFileDialog *outputFileDialog)
+{
+    if (encodingOptions.pInFileStream == NULL || ladderThread != NULL)
+    {
+        return;
+    }
+
+    VcLadderRenditionsClear(&ladderOptions);
+    float qualities[VC_LADDER_MAX_RENDITIONS];
+    ladderOptions.nRenditions = VcParseQualities(ladderQualitiesEntry, qualities, VC_LADDER_MAX_RENDITIONS);
+    for (int i = 0; i < ladderOptions.nRenditions; i++)
+    {
+        ladderOptions.renditions[i].fQuality = qualities[i];
+    }
+
+    if (ladderOptions.nRenditions == 0)
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "No ladder qualities given");
+        return;
+    }
+
+    gtk_spinner_start(GTK_SPINNER(spinner));
+    gtk_widget_set_sensitive(convertButton, false);
+    gtk_widget_set_sensitive(chooseFileButton, false);
+    gtk_widget_set_sensitive(previewButton, false);
+    gtk_widget_set_sensitive(ladderButton, false);
+    gtk_file_dialog_save(outputFileDialog, NULL, NULL, VcOnLadderFileDialogFinished, NULL);
+}
+
+void VcOnDecodeFinished(gpointer data)
+{
+    g_thread_join(decodeThread);
+    decodeThread = NULL;
+    g_timer_stop(decodeTimer);
+    gtk_widget_set_sensitive(decodeButton, true);
+
+    int failed = 0;
+    for (guint i = 0; i < decodeOptions.jobs->len; i++)
+    {
+        VcDecodeJob *job = g_ptr_array_index(decodeOptions.jobs, i);
+        if (job->status < 0)
+        {
+            VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "%s: %s", job->pInPath, job->pError != NULL ? job->pError : "failed");
+            failed++;
+            continue;
+        }
+
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "%s: %.2fs, %d channels, %ld Hz", job->pOutPath, (double)job->nFrames / job->nRate, job->nChannels, job->nRate);
+    }
+
+    VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Decoded %u files (%d failed) in %.3fs", decodeOptions.jobs->len - failed, failed, g_timer_elapsed(decodeTimer, NULL));
+    VcDecodeJobsClear(&decodeOptions);
+}
+
+void VcOnDecodeFolderDialogFinished(GObject *fileDialog, GAsyncResult *res, gpointer data)
+{
+    GListModel *files = G_LIST_MODEL(data);
+    GError *error = NULL;
+    GFile *outDir = gtk_file_dialog_select_folder_finish(GTK_FILE_DIALOG(fileDialog), res, &error);
+    if (error != NULL)
+    {
+        gtk_widget_set_sensitive(decodeButton, true);
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+        g_object_unref(files);
+        return;
+    }
+
+    char *outPath = g_file_get_path(outDir);
+    for (guint i = 0; i < g_list_model_get_n_items(files); i++)
+    {
+        GFile *file = G_FILE(g_list_model_get_item(files, i));
+        char *inPath = g_file_get_path(file);
+        VcDecodeAddJob(&decodeOptions, inPath, outPath);
+        g_free(inPath);
+        g_object_unref(file);
+    }
+    g_free(outPath);
+    g_object_unref(outDir);
+    g_object_unref(files);
+
+    decodeOptions.pLogView      = GTK_TEXT_VIEW(logView);
+    decodeOptions.cbOnFinished  = VcOnDecodeFinished;
+    decodeOptions.format        = (VcDecodeFormat)gtk_drop_down_get_selected(GTK_DROP_DOWN(decodeFormatDropDown));
+
+    VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Decoding %u files...", decodeOptions.jobs->len);
+    g_timer_start(decodeTimer);
+    decodeThread = VcDecodeBatch(&decodeOptions);
+}
+
+void VcOnDecodeFilesDialogFinished(GObject *fileDialog, GAsyncResult *res, gpointer data)
+{
+    GError *error = NULL;
+    GListModel *files = gtk_file_dialog_open_multiple_finish(GTK_FILE_DIALOG(fileDialog), res, &error);
+    if (error != NULL)
+    {
+        gtk_widget_set_sensitive(decodeButton, true);
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+        return;
+    }
+
+    // The WAV files all go to one folder
+    gtk_file_dialog_select_folder(GTK_FILE_DIALOG(fileDialog), NULL, NULL, VcOnDecodeFolderDialogFinished, files);
+}
+
+void VcOnDecodeClicked(GtkFileDialog *oggFileDialog)
+{
+    if (decodeThread != NULL)
+    {
+        return;
+    }
+
+    gtk_widget_set_sensitive(decodeButton, false);
+    gtk_file_dialog_open_multiple(oggFileDialog, NULL, NULL, VcOnDecodeFilesDialogFinished, NULL);
+}
+
+void VcOnTranscodeFinished(gpointer data)
+{
+    g_thread_join(transcodeThread);
+    transcodeThread = NULL;
+    g_timer_stop(transcodeTimer);
+    gtk_widget_set_sensitive(transcodeButton, true);
+
+    if (transcodeOptions.status < 0)
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Transcoding %s failed", transcodeOptions.pInPath);
+    }
+
+    else
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Transcoded %.2fs in %.3fs: %lld -> %lld bytes, %s", 
+            (double)transcodeOptions.nFrames / transcodeOptions.nRate, g_timer_elapsed(transcodeTimer, NULL),
+            (long long)transcodeOptions.nInBytes, (long long)transcodeOptions.nOutBytes, transcodeOptions.pOutPath);
+    }
+
+    g_free(transcodeOptions.pInPath);
+    g_free(transcodeOptions.pOutPath);
+    transcodeOptions.pInPath = NULL;
+    transcodeOptions.pOutPath = NULL;
+}
+
+void VcOnTranscodeOutputDialogFinished(GObject *fileDialog, GAsyncResult *res, gpointer data)
+{
+    GError *error = NULL;
+    GFile *file = gtk_file_dialog_save_finish(GTK_FILE_DIALOG(fileDialog), res, &error);
+    if (error != NULL)
+    {
+        gtk_widget_set_sensitive(transcodeButton, true);
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+        g_free(transcodeOptions.pInPath);
+        transcodeOptions.pInPath = NULL;
+        return;
+    }
+
+    transcodeOptions.pOutPath       = g_file_get_path(file);
+    transcodeOptions.pLogView       = GTK_TEXT_VIEW(logView);
+    transcodeOptions.cbOnFinished   = VcOnTranscodeFinished;
+    VcReadEncoderTuning(&transcodeOptions.tuning);
+    g_object_unref(file);
+
+    VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Transcoding %s...", transcodeOptions.pInPath);
+    g_timer_start(transcodeTimer);
+    transcodeThread = VcTranscode(&transcodeOptions);
+}
+
+void VcOnTranscodeInputDialogFinished(GObject *fileDialog, GAsyncResult *res, gpointer data)
+{
+    GError *error = NULL;
+    GFile *file = gtk_file_dialog_open_finish(GTK_FILE_DIALOG(fileDialog), res, &error);
+    if (error != NULL)
+    {
+        gtk_widget_set_sensitive(transcodeButton, true);
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+        return;
+    }
+
+    transcodeOptions.pInPath = g_file_get_path(file);
+    g_object_unref(file);
+    gtk_file_dialog_save(GTK_FILE_DIALOG(fileDialog), NULL, NULL, VcOnTranscodeOutputDialogFinished, NULL);
+}
+
+void VcOnTranscodeClicked(GtkFileDialog *oggFileDialog)
+{
+    if (transcodeThread != NULL)
+    {
+        return;
+    }
+
+    gtk_widget_set_sensitive(transcodeButton, false);
+    gtk_file_dialog_open(oggFileDialog, NULL, NULL, VcOnTranscodeInputDialogFinished, NULL);
+}
+
+static void VcSetEditSensitive(bool sensitive)
+{
+    gtk_widget_set_sensitive(cutButton, sensitive);
+    gtk_widget_set_sensitive(joinButton, sensitive);
+}
+
+static void VcAbortEdit(GError *error)
+{
+    VcSetEditSensitive(true);
+    g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+    g_error_free(error);
+    VcOggEditClear(&editOptions);
+}
+
+void VcOnEditFinished(gpointer data)
+{
+    g_thread_join(editThread);
+    editThread = NULL;
+    VcSetEditSensitive(true);
+
+    if (editOptions.status < 0)
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "%s failed", editOptions.mode == VC_OGG_CUT ? "Cutting" : "Joining");
+    }
+
+    else if (editOptions.mode == VC_OGG_CUT)
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Cut %.3fs into %llu pages, %llu bytes: %s",
+            (double)editOptions.nFrames / editOptions.nRate, (unsigned long long)editOptions.nPages,
+            (unsigned long long)editOptions.nBytes, editOptions.pOutPath);
+    }
+
+    else
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Joined %u files into %llu pages, %llu bytes: %s",
+            editOptions.inPaths->len, (unsigned long long)editOptions.nPages,
+            (unsigned long long)editOptions.nBytes, editOptions.pOutPath);
+    }
+
+    VcOggEditClear(&editOptions);
+}
+
+void VcOnEditOutputDialogFinished(GObject *fileDialog, GAsyncResult *res, gpointer data)
+{
+    GError *error = NULL;
+    GFile *file = gtk_file_dialog_save_finish(GTK_FILE_DIALOG(fileDialog), res, &error);
+    if (error != NULL)
+    {
+        VcAbortEdit(error);
+        return;
+    }
+
+    editOptions.pOutPath        = g_file_get_path(file);
+    editOptions.pLogView        = GTK_TEXT_VIEW(logView);
+    editOptions.cbOnFinished    = VcOnEditFinished;
+    editOptions.dStart          = gtk_spin_button_get_value(GTK_SPIN_BUTTON(cutStartSpinButton));
+    editOptions.dEnd            = gtk_spin_button_get_value(GTK_SPIN_BUTTON(cutEndSpinButton));
+    g_object_unref(file);
+
+    if (editOptions.mode == VC_OGG_CUT && editOptions.dEnd > 0.0 && editOptions.dEnd <= editOptions.dStart)
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "The cut has to end after it starts");
+        VcSetEditSensitive(true);
+        VcOggEditClear(&editOptions);
+        return;
+    }
+
+    editThread = VcOggEdit(&editOptions);
+}
+
+void VcOnEditInputDialogFinished(GObject *fileDialog, GAsyncResult *res, gpointer data)
+{
+    GError *error = NULL;
+    editOptions.inPaths = g_ptr_array_new_with_free_func(g_free);
+
+    if (editOptions.mode == VC_OGG_CUT)
+    {
+        GFile *file = gtk_file_dialog_open_finish(GTK_FILE_DIALOG(fileDialog), res, &error);
+        if (file != NULL)
+        {
+            g_ptr_array_add(editOptions.inPaths, g_file_get_path(file));
+            g_object_unref(file);
+        }
+    }
+
+    else
+    {
+        GListModel *files = gtk_file_dialog_open_multiple_finish(GTK_FILE_DIALOG(fileDialog), res, &error);
+        for (guint i = 0; files != NULL && i < g_list_model_get_n_items(files); i++)
+        {
+            GFile *file = G_FILE(g_list_model_get_item(files, i));
+            g_ptr_array_add(editOptions.inPaths, g_file_get_path(file));
+            g_object_unref(file);
+        }
+
+        if (files != NULL)
+        {
+            g_object_unref(files);
+        }
+    }
+
+    if (error != NULL)
+    {
+        VcAbortEdit(error);
+        return;
+    }
+
+    gtk_file_dialog_save(GTK_FILE_DIALOG(fileDialog), NULL, NULL, VcOnEditOutputDialogFinished, NULL);
+}
+
+void VcOnCutClicked(GtkFileDialog *oggFileDialog)
+{
+    if (editThread != NULL)
+    {
+        return;
+    }
+
+    VcSetEditSensitive(false);
+    editOptions.mode = VC_OGG_CUT;
+    gtk_file_dialog_open(oggFileDialog, NULL, NULL, VcOnEditInputDialogFinished, NULL);
+}
+
+void VcOnJoinClicked(GtkFileDialog *oggFileDialog)
+{
+    if (editThread != NULL)
+    {
+        return;
+    }
+
+    VcSetEditSensitive(false);
+    editOptions.mode = VC_OGG_JOIN;
+    gtk_file_dialog_open_multiple(oggFileDialog, NULL, NULL, VcOnEditInputDialogFinished, NULL);
+}
+
+void VcOnCaptureFinished(gpointer data)
+{
+    g_thread_join(captureThread);
+    captureThread = NULL;
+    gtk_button_set_label(GTK_BUTTON(recordButton), "Record");
+    gtk_widget_set_sensitive(recordButton, true);
+
+    if (captureOptions.status < 0)
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Recording failed");
+    }
+
+    else
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Recorded %.2fs, %lld bytes: %s", 
+            (double)captureOptions.nEncodedFrames / captureOptions.nRate, (long long)captureOptions.nBytes, captureOptions.pOutPath);
+    }
+
+    if (captureOptions.nRate > 0)
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Capture: %lld frames dropped, %d device overruns, encoding lagged at most %.3fs",
+            (long long)captureOptions.nDroppedFrames, captureOptions.nOverflows, captureOptions.dMaxLag);
+    }
+
+    g_free(captureOptions.pOutPath);
+    captureOptions.pOutPath = NULL;
+}
+
+void VcOnCaptureOutputDialogFinished(GObject *fileDialog, GAsyncResult *res, gpointer data)
+{
+    GError *error = NULL;
+    GFile *file = gtk_file_dialog_save_finish(GTK_FILE_DIALOG(fileDialog), res, &error);
+    if (error != NULL)
+    {
+        gtk_widget_set_sensitive(recordButton, true);
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+        return;
+    }
+
+    captureOptions.pOutPath         = g_file_get_path(file);
+    captureOptions.pLogView         = GTK_TEXT_VIEW(logView);
+    captureOptions.cbOnFinished     = VcOnCaptureFinished;
+    captureOptions.nChannels        = 2;
+    captureOptions.bDummyBackend    = gtk_check_button_get_active(GTK_CHECK_BUTTON(dummyInputCheckButton));
+    VcReadEncoderTuning(&captureOptions.tuning);
+    g_object_unref(file);
+
+    gtk_button_set_label(GTK_BUTTON(recordButton), "Stop");
+    gtk_widget_set_sensitive(recordButton, true);
+    captureThread = VcCaptureStart(&captureOptions);
+}
+
+// Starts a recording, or stops the one that is running
+void VcOnRecordClicked(GtkFileDialog *oggFileDialog)
+{
+    gtk_widget_set_sensitive(recordButton, false);
+    if (captureThread != NULL)
+    {
+        VcCaptureStop(&captureOptions);
+        return;
+    }
+
+    gtk_file_dialog_save(oggFileDialog, NULL, NULL, VcOnCaptureOutputDialogFinished, NULL);
+}
+
 void VcOnPlaybackButtonClick(GObject *button)
 {
     if (!VcAudioIoIsInitialized())
@@ -205,6 +1051,9 @@ void VcOnPlaybackButtonClick(GObject *button)
     if (paused)
     {
         gtk_button_set_icon_name(GTK_BUTTON(button), "media-playback-pause");
+        gchar *latencyText = g_strdup_printf("Latency: %.1f ms", VcAudioIoGetLatency() * 1000.0);
+        gtk_label_set_label(GTK_LABEL(latencyLabel), latencyText);
+        g_free(latencyText);
     }
 
     else
@@ -224,6 +1073,79 @@ void VcOnStopButtonClick(GObject *button)
     gtk_button_set_icon_name(GTK_BUTTON(playbackButton), "media-playback-start");
 
     VcAudioIoReset();
+    gtk_range_set_value(GTK_RANGE(seekScale), 0.0);
+}
+
+gboolean VcOnSeekScaleChanged(GtkRange *range, GtkScrollType scroll, double value, gpointer data)
+{
+    VcAudioIoSeek(value);
+    return false;
+}
+
+// Unticking follow during an encode stops waiting for the recording and finishes with what is there
+void VcOnFollowToggled(GtkCheckButton *checkButton)
+{
+    if (!gtk_check_button_get_active(checkButton) && encoderThread != NULL)
+    {
+        g_atomic_int_set(&encodingOptions.nFollowCancel, 1);
+    }
+}
+
+void VcOnLatencyChanged(GtkSpinButton *spinButton)
+{
+    VcAudioIoSetLatency(gtk_spin_button_get_value(spinButton) / 1000.0);
+}
+
+gboolean VcOnTelemetryTick(gpointer data)
+{
+    if (!VcAudioIoIsInitialized())
+    {
+        return G_SOURCE_CONTINUE;
+    }
+
+    gtk_range_set_value(GTK_RANGE(seekScale), VcAudioIoGetPosition());
+
+    gchar *text = VcTelemetryFormat(VcAudioIoGetTelemetry());
+    gtk_label_set_label(GTK_LABEL(telemetryLabel), text);
+    g_free(text);
+
+    return G_SOURCE_CONTINUE;
+}
+
+void VcOnTelemetryFileDialogFinished(GObject *fileDialog, GAsyncResult *res, gpointer data)
+{
+    GError *error = NULL;
+    GFile *statsFile = gtk_file_dialog_save_finish(GTK_FILE_DIALOG(fileDialog), res, &error);
+    if (error != NULL)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+        return;
+    }
+
+    char *statsFilePath = g_file_get_path(statsFile);
+    gchar *csv = VcTelemetryFormatCsv(VcAudioIoGetTelemetry());
+    g_file_set_contents(statsFilePath, csv, -1, &error);
+    if (error != NULL)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), error->message);
+        g_error_free(error);
+    }
+
+    else
+    {
+        VcLogViewWriteLine(GTK_TEXT_VIEW(logView), "Playback stats exported to %s", statsFilePath);
+    }
+
+    g_free(csv);
+    free(statsFilePath);
+    g_object_unref(statsFile);
+}
+
+void VcOnExportTelemetryClicked(GtkFileDialog *statsFileDialog)
+{
+    gtk_file_dialog_save(statsFileDialog, NULL, NULL, VcOnTelemetryFileDialogFinished, NULL);
 }
 
 void VcOnActivate(GtkApplication *app)
@@ -234,18 +1156,134 @@ void VcOnActivate(GtkApplication *app)
     GtkFileFilter   *outFileFilter      = gtk_file_filter_new();
     GtkFileDialog   *inputFileDialog    = gtk_file_dialog_new();
     GtkFileDialog   *outputFileDialog   = gtk_file_dialog_new();
+    GtkFileDialog   *statsFileDialog    = gtk_file_dialog_new();
 
     gtk_window_set_default_size(GTK_WINDOW(window), 600, 420);
     gtk_file_filter_add_mime_type(inFileFilter, "audio/wav");
     gtk_file_filter_add_mime_type(outFileFilter, "audio/ogg");
     gtk_file_dialog_set_default_filter(inputFileDialog, inFileFilter);
     gtk_file_dialog_set_default_filter(outputFileDialog, outFileFilter);
+    gtk_file_dialog_set_initial_name(statsFileDialog, "playback-stats.csv");
 
     inputFileLabel          = gtk_label_new("(no file selected)");
     outputFileLabel         = gtk_label_new("");
     compressionRateLabel    = gtk_label_new("");
     chooseFileButton        = gtk_button_new_with_label("Choose File");
     convertButton           = gtk_button_new_with_label("Convert");
+    inMemoryCheckButton     = gtk_check_button_new_with_label("Preview from memory");
+
+    rangeStartSpinButton    = gtk_spin_button_new_with_range(0.0, 0.0, 0.1);
+    qualitySpinButton       = gtk_spin_button_new_with_range(-1.0, 10.0, 0.5);
+    previewButton           = gtk_button_new_with_label("Preview");
+    previewQualitiesEntry   = gtk_entry_new();
+    previewResultsDropDown  = gtk_drop_down_new_from_strings((const char *[]){ NULL });
+    rangeEndSpinButton      = gtk_spin_button_new_with_range(0.0, 0.0, 0.1);
+    ladderButton            = gtk_button_new_with_label("Ladder");
+    decodeButton            = gtk_button_new_with_label("Decode to WAV");
+    transcodeButton         = gtk_button_new_with_label("Transcode Ogg");
+    decodeFormatDropDown    = gtk_drop_down_new_from_strings((const char *[]){ "16-bit PCM", "24-bit PCM", "32-bit float", NULL });
+    decodeTimer             = g_timer_new();
+    transcodeTimer          = g_timer_new();
+    cutButton               = gtk_button_new_with_label("Cut Ogg");
+    cutStartSpinButton      = gtk_spin_button_new_with_range(0.0, 86400.0, 0.1);
+    cutEndSpinButton        = gtk_spin_button_new_with_range(0.0, 86400.0, 0.1);
+    joinButton              = gtk_button_new_with_label("Join Ogg");
+    segmentSpinButton       = gtk_spin_button_new_with_range(0.0, 3600.0, 1.0);
+    segmentFilesCheckButton = gtk_check_button_new_with_label("Segment files");
+    liveTargetEntry         = gtk_entry_new();
+    liveLatencySpinButton   = gtk_spin_button_new_with_range(20.0, 5000.0, 10.0);
+    livePageSpinButton      = gtk_spin_button_new_with_range(0.0, 65025.0, 256.0);
+    recordButton            = gtk_button_new_with_label("Record");
+    dummyInputCheckButton   = gtk_check_button_new_with_label("Dummy input");
+    followCheckButton       = gtk_check_button_new_with_label("Follow growing file");
+    followIdleSpinButton    = gtk_spin_button_new_with_range(0.0, 3600.0, 5.0);
+    targetSizeSpinButton    = gtk_spin_button_new_with_range(0.0, 10000000.0, 100.0);
+    targetBitrateSpinButton = gtk_spin_button_new_with_range(0.0, 500.0, 8.0);
+    rateModeDropDown        = gtk_drop_down_new_from_strings((const char *[]){ "VBR", "ABR", "CBR", NULL });
+    bitrateSpinButton       = gtk_spin_button_new_with_range(8.0, 500.0, 8.0);
+    maxBitrateSpinButton    = gtk_spin_button_new_with_range(0.0, 500.0, 8.0);
+    reservoirSpinButton     = gtk_spin_button_new_with_range(0.0, 10.0, 0.1);
+    lowpassSpinButton       = gtk_spin_button_new_with_range(0.0, 50.0, 0.5);
+    impulseBlockSpinButton  = gtk_spin_button_new_with_range(-15.0, 0.0, 0.5);
+    couplingCheckButton     = gtk_check_button_new_with_label("Stereo coupling");
+    outputRateDropDown      = gtk_drop_down_new_from_strings((const char *[]){ "Keep rate", "48000 Hz", "44100 Hz", NULL });
+    resampleQualityDropDown = gtk_drop_down_new_from_strings((const char *[]){ "Fast", "Medium", "Best", NULL });
+    mixLayoutDropDown       = gtk_drop_down_new_from_strings((const char *[]){ "All channels", "Stereo", "Mono", NULL });
+    loudnessCheckButton     = gtk_check_button_new_with_label("ReplayGain tags");
+    verifyCheckButton       = gtk_check_button_new_with_label("Verify");
+    integrityCheckButton    = gtk_check_button_new_with_label("Check integrity");
+    trimLeadingCheckButton  = gtk_check_button_new_with_label("Trim leading silence");
+    trimTrailingCheckButton = gtk_check_button_new_with_label("Trim trailing silence");
+    silenceThresholdSpinButton = gtk_spin_button_new_with_range(-144.0, -20.0, 1.0);
+    minSilenceSpinButton    = gtk_spin_button_new_with_range(0.01, 60.0, 0.1);
+    ladderQualitiesEntry    = gtk_entry_new();
+
+    gtk_check_button_set_active(GTK_CHECK_BUTTON(inMemoryCheckButton), true);
+    gtk_spin_button_set_digits(GTK_SPIN_BUTTON(rangeStartSpinButton), 2);
+    gtk_spin_button_set_digits(GTK_SPIN_BUTTON(rangeEndSpinButton), 2);
+    gtk_widget_set_tooltip_text(rangeStartSpinButton, "Start of the excerpt to encode, in seconds");
+    gtk_widget_set_tooltip_text(rangeEndSpinButton, "End of the excerpt to encode in seconds, 0 encodes to the end of the file");
+    gtk_spin_button_set_digits(GTK_SPIN_BUTTON(qualitySpinButton), 1);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(qualitySpinButton), 3.0);
+    gtk_widget_set_tooltip_text(qualitySpinButton, "Vorbis quality, from -1 (smallest) to 10 (best)");
+    gtk_editable_set_text(GTK_EDITABLE(previewQualitiesEntry), "0, 2, 4, 6");
+    gtk_widget_set_tooltip_text(previewQualitiesEntry, "Qualities to encode the excerpt at, in parallel");
+    gtk_widget_set_tooltip_text(previewButton, "Encode the selected range at every preview quality at once");
+    gtk_widget_set_sensitive(previewButton, false);
+    gtk_widget_set_sensitive(previewResultsDropDown, false);
+    gtk_editable_set_text(GTK_EDITABLE(ladderQualitiesEntry), "2, 5, 8");
+    gtk_widget_set_tooltip_text(ladderQualitiesEntry, "Qualities of the renditions written by Ladder");
+    gtk_widget_set_tooltip_text(ladderButton, "Encode the selected range at every ladder quality in a single pass over the input");
+    gtk_widget_set_sensitive(ladderButton, false);
+    gtk_widget_set_tooltip_text(targetSizeSpinButton, "Largest output size in kB, Convert picks the highest quality that fits. 0 uses the quality above");
+    gtk_widget_set_tooltip_text(targetBitrateSpinButton, "Average bitrate to fit in kbit/s, used when no target size is set. 0 uses the quality above");
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(bitrateSpinButton), 128.0);
+    gtk_spin_button_set_digits(GTK_SPIN_BUTTON(reservoirSpinButton), 1);
+    gtk_spin_button_set_digits(GTK_SPIN_BUTTON(lowpassSpinButton), 1);
+    gtk_spin_button_set_digits(GTK_SPIN_BUTTON(impulseBlockSpinButton), 1);
+    gtk_check_button_set_active(GTK_CHECK_BUTTON(couplingCheckButton), true);
+    gtk_widget_set_tooltip_text(rateModeDropDown, "VBR encodes at a quality, ABR and CBR are bitrate managed");
+    gtk_widget_set_tooltip_text(bitrateSpinButton, "Average (ABR) or constant (CBR) bitrate in kbit/s");
+    gtk_widget_set_tooltip_text(maxBitrateSpinButton, "Hard upper bitrate limit for ABR in kbit/s, 0 leaves it open");
+    gtk_widget_set_tooltip_text(reservoirSpinButton, "Seconds the bitrate limits are enforced over, 0 keeps the encoder default");
+    gtk_widget_set_tooltip_text(lowpassSpinButton, "Lowpass cutoff in kHz, 0 keeps the encoder default");
+    gtk_widget_set_tooltip_text(impulseBlockSpinButton, "Impulse block bias, lower values spend more bits on transients");
+    gtk_widget_set_tooltip_text(couplingCheckButton, "Code stereo channels jointly, smaller but less exact stereo image");
+    VcOnRateModeChanged(G_OBJECT(rateModeDropDown), NULL, NULL);
+    gtk_drop_down_set_selected(GTK_DROP_DOWN(resampleQualityDropDown), VC_RESAMPLE_MEDIUM);
+    gtk_widget_set_tooltip_text(outputRateDropDown, "Sample rate to encode at, higher rate input is resampled before analysis");
+    gtk_widget_set_tooltip_text(resampleQualityDropDown, "Resampling filter length, longer filters are slower but cleaner");
+    gtk_widget_set_tooltip_text(mixLayoutDropDown, "Channels to encode, surround input can be folded down to stereo or mono");
+    gtk_check_button_set_active(GTK_CHECK_BUTTON(loudnessCheckButton), true);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(silenceThresholdSpinButton), -90.0);
+    gtk_spin_button_set_digits(GTK_SPIN_BUTTON(minSilenceSpinButton), 2);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(minSilenceSpinButton), 1.0);
+    gtk_widget_set_tooltip_text(silenceThresholdSpinButton, "Level in dBFS at or under which every channel counts as silent");
+    gtk_widget_set_tooltip_text(minSilenceSpinButton, "Shortest silence in seconds that is reported or trimmed");
+    gtk_widget_set_tooltip_text(loudnessCheckButton, "Measure EBU R128 loudness and true peak while encoding and write REPLAYGAIN_* and R128_* tags");
+    gtk_check_button_set_active(GTK_CHECK_BUTTON(integrityCheckButton), true);
+    gtk_widget_set_tooltip_text(integrityCheckButton, "Check page CRCs, granule positions, packet decoding and the total length of the output while it is written");
+    gtk_widget_set_tooltip_text(transcodeButton, "Re-encode an Ogg Vorbis file with the current rate settings, decoding and encoding in parallel");
+    gtk_widget_set_tooltip_text(cutButton, "Copy a time range of an Ogg Vorbis file without re-encoding, trimmed to the exact sample");
+    gtk_widget_set_tooltip_text(cutStartSpinButton, "Start of the cut in seconds");
+    gtk_widget_set_tooltip_text(cutEndSpinButton, "End of the cut in seconds, 0 keeps everything up to the end");
+    gtk_entry_set_placeholder_text(GTK_ENTRY(liveTargetEntry), "tcp://host:port or pipe");
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(liveLatencySpinButton), 250.0);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(livePageSpinButton), 1024.0);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(followIdleSpinButton), 30.0);
+    gtk_widget_set_tooltip_text(followCheckButton, "Encode a WAV file that is still being recorded as it grows, until its header is finalized or <file>.done appears. Untick it to stop following early");
+    gtk_widget_set_tooltip_text(followIdleSpinButton, "Seconds without growth after which a followed recording counts as finished, 0 never gives up");
+    gtk_widget_set_tooltip_text(recordButton, "Record the default input device straight to Ogg Vorbis with the current rate settings");
+    gtk_widget_set_tooltip_text(dummyInputCheckButton, "Record from libsoundio's dummy backend instead of a real device");
+    gtk_widget_set_tooltip_text(liveTargetEntry, "Stream the pages to a TCP listener or a pipe while the file is written");
+    gtk_widget_set_tooltip_text(liveLatencySpinButton, "Longest in milliseconds encoded audio may wait in a page before it is sent");
+    gtk_widget_set_tooltip_text(livePageSpinButton, "Bytes a live page is filled to before it is sent, 0 keeps the usual 4 KiB pages");
+    gtk_widget_set_tooltip_text(segmentSpinButton, "Split the output into independently decodable segments of this many seconds, chained in one stream, 0 keeps one stream");
+    gtk_widget_set_tooltip_text(segmentFilesCheckButton, "Also write every segment to a file of its own, listed in a manifest with byte offsets and durations");
+    gtk_widget_set_tooltip_text(joinButton, "Chain Ogg Vorbis files one after another without re-encoding");
+    gtk_widget_set_tooltip_text(decodeButton, "Decode Ogg Vorbis files back to WAV, several at once across all cores");
+    gtk_widget_set_tooltip_text(verifyCheckButton, "Decode the output while encoding and report SNR, segmental SNR and spectral distance against the source");
+    gtk_widget_set_tooltip_text(inMemoryCheckButton, "Keep the encoded pages in memory so preview doesn't read the output back from disk");
 
     gtk_widget_set_sensitive(convertButton, false);
 
@@ -256,11 +1294,21 @@ void VcOnActivate(GtkApplication *app)
 
     playbackButton  = gtk_button_new_from_icon_name("media-playback-start");
     stopButton      = gtk_button_new_from_icon_name("media-playback-stop");
+    latencySpinButton = gtk_spin_button_new_with_range(VC_AUDIO_IO_MIN_LATENCY * 1000, VC_AUDIO_IO_MAX_LATENCY * 1000, 5);
+    latencyLabel    = gtk_label_new("");
+    telemetryLabel  = gtk_label_new("");
+    seekScale       = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL, 0.0, 1.0, 0.1);
     textBuffer      = gtk_text_buffer_new(NULL);
     logView         = gtk_text_view_new_with_buffer(textBuffer);
     spinner         = gtk_spinner_new();
 
+    gtk_scale_set_draw_value(GTK_SCALE(seekScale), false);
+    gtk_widget_set_hexpand(seekScale, true);
+
     VcToggleMediaControls(false);
+
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(latencySpinButton), VC_AUDIO_IO_DEFAULT_LATENCY * 1000);
+    gtk_widget_set_tooltip_text(latencySpinButton, "Playback buffer size, lower values make play/stop respond faster");
  
     GtkWidget   *mainBox        = gtk_box_new(GTK_ORIENTATION_VERTICAL, 4);
     GtkWidget   *controlsBox    = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 4);
@@ -268,6 +1316,7 @@ void VcOnActivate(GtkApplication *app)
     GtkWidget   *scrolledWindow = gtk_scrolled_window_new();
     GtkWidget   *clearLogButton = gtk_button_new_with_label("Clear Log");
     GtkWidget   *copyLogButton  = gtk_button_new_from_icon_name("edit-copy");
+    GtkWidget   *exportStatsButton = gtk_button_new_with_label("Export Stats");
 
     gtk_text_view_set_editable(logView, false);
 
@@ -291,6 +1340,8 @@ void VcOnActivate(GtkApplication *app)
     gtk_widget_set_margin_end(grid, 10);
 
     gtk_widget_set_margin_start(controlsBox, 10);
+    gtk_widget_set_halign(telemetryLabel, GTK_ALIGN_START);
+    gtk_widget_set_margin_start(telemetryLabel, 10);
     gtk_widget_set_margin_end(controlsBox, 10);
 
     gtk_widget_set_margin_top(clearLogButton, 2);
@@ -300,6 +1351,12 @@ void VcOnActivate(GtkApplication *app)
 
     gtk_box_append(GTK_BOX(controlsBox), playbackButton);
     gtk_box_append(GTK_BOX(controlsBox), stopButton);
+    gtk_box_append(GTK_BOX(controlsBox), seekScale);
+    gtk_box_append(GTK_BOX(controlsBox), gtk_label_new("Latency (ms)"));
+    gtk_box_append(GTK_BOX(controlsBox), latencySpinButton);
+    gtk_box_append(GTK_BOX(controlsBox), latencyLabel);
+    gtk_box_append(GTK_BOX(controlsBox), exportStatsButton);
+    gtk_box_append(GTK_BOX(mainBox), telemetryLabel);
     gtk_box_append(GTK_BOX(mainBox), copyLogButton);
     gtk_box_append(GTK_BOX(mainBox), scrolledWindow);
     gtk_box_append(GTK_BOX(mainBox), clearLogButton);
@@ -323,16 +1380,85 @@ void VcOnActivate(GtkApplication *app)
     gtk_grid_attach(GTK_GRID(grid), spinner, 2, 2, 1, 1);
     gtk_grid_attach(GTK_GRID(grid), outputFileLabel, 2, 2, 3, 1);
     gtk_grid_attach(GTK_GRID(grid), compressionRateLabel, 1, 3, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), inMemoryCheckButton, 1, 1, 2, 1);
+    gtk_grid_attach(GTK_GRID(grid), gtk_label_new("Range (s)"), 3, 1, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), rangeStartSpinButton, 4, 1, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), rangeEndSpinButton, 5, 1, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), gtk_label_new("Quality"), 2, 3, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), qualitySpinButton, 3, 3, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), outputRateDropDown, 4, 3, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), resampleQualityDropDown, 5, 3, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), mixLayoutDropDown, 5, 2, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), loudnessCheckButton, 4, 5, 2, 1);
+    gtk_grid_attach(GTK_GRID(grid), verifyCheckButton, 3, 5, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), integrityCheckButton, 5, 6, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), decodeButton, 1, 10, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), decodeFormatDropDown, 2, 10, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), transcodeButton, 3, 10, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), recordButton, 4, 10, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), dummyInputCheckButton, 5, 10, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), cutButton, 1, 11, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), cutStartSpinButton, 2, 11, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), cutEndSpinButton, 3, 11, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), joinButton, 4, 11, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), gtk_label_new("Segments (s)"), 1, 12, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), segmentSpinButton, 2, 12, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), segmentFilesCheckButton, 3, 12, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), followCheckButton, 4, 12, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), followIdleSpinButton, 5, 12, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), gtk_label_new("Live (ms, bytes)"), 1, 13, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), liveTargetEntry, 2, 13, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), liveLatencySpinButton, 3, 13, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), livePageSpinButton, 4, 13, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), trimLeadingCheckButton, 1, 9, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), trimTrailingCheckButton, 2, 9, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), gtk_label_new("Silence (dBFS, s)"), 3, 9, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), silenceThresholdSpinButton, 4, 9, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), minSilenceSpinButton, 5, 9, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), previewButton, 1, 4, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), previewQualitiesEntry, 2, 4, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), previewResultsDropDown, 3, 4, 3, 1);
+    gtk_grid_attach(GTK_GRID(grid), ladderButton, 1, 5, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), ladderQualitiesEntry, 2, 5, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), gtk_label_new("Target (kB)"), 1, 6, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), targetSizeSpinButton, 2, 6, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), gtk_label_new("or (kbit/s)"), 3, 6, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), targetBitrateSpinButton, 4, 6, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), gtk_label_new("Rate (kbit/s)"), 1, 7, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), rateModeDropDown, 2, 7, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), bitrateSpinButton, 3, 7, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), maxBitrateSpinButton, 4, 7, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), reservoirSpinButton, 5, 7, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), gtk_label_new("Lowpass (kHz)"), 1, 8, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), lowpassSpinButton, 2, 8, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), gtk_label_new("Impulse bias"), 3, 8, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), impulseBlockSpinButton, 4, 8, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), couplingCheckButton, 5, 8, 1, 1);
     
     g_signal_connect_swapped(clearLogButton, "clicked", G_CALLBACK(VcLogViewClear), logView);
     g_signal_connect_swapped(chooseFileButton, "clicked", G_CALLBACK(VcOnOpenFileClicked), inputFileDialog);
     g_signal_connect_swapped(convertButton, "clicked", G_CALLBACK(VcOnConvertClicked), outputFileDialog);
     g_signal_connect_swapped(playbackButton, "clicked", G_CALLBACK(VcOnPlaybackButtonClick), playbackButton);
     g_signal_connect_swapped(stopButton, "clicked", G_CALLBACK(VcOnStopButtonClick), stopButton);
+    g_signal_connect_swapped(exportStatsButton, "clicked", G_CALLBACK(VcOnExportTelemetryClicked), statsFileDialog);
+    g_signal_connect(previewButton, "clicked", G_CALLBACK(VcOnPreviewClicked), NULL);
+    g_signal_connect_swapped(ladderButton, "clicked", G_CALLBACK(VcOnLadderClicked), outputFileDialog);
+    g_signal_connect_swapped(decodeButton, "clicked", G_CALLBACK(VcOnDecodeClicked), outputFileDialog);
+    g_signal_connect_swapped(transcodeButton, "clicked", G_CALLBACK(VcOnTranscodeClicked), outputFileDialog);
+    g_signal_connect_swapped(cutButton, "clicked", G_CALLBACK(VcOnCutClicked), outputFileDialog);
+    g_signal_connect_swapped(joinButton, "clicked", G_CALLBACK(VcOnJoinClicked), outputFileDialog);
+    g_signal_connect_swapped(recordButton, "clicked", G_CALLBACK(VcOnRecordClicked), outputFileDialog);
+    g_signal_connect(previewResultsDropDown, "notify::selected", G_CALLBACK(VcOnPreviewResultSelected), NULL);
+    g_signal_connect(rateModeDropDown, "notify::selected", G_CALLBACK(VcOnRateModeChanged), NULL);
+    g_signal_connect(seekScale, "change-value", G_CALLBACK(VcOnSeekScaleChanged), NULL);
+    g_signal_connect(latencySpinButton, "value-changed", G_CALLBACK(VcOnLatencyChanged), NULL);
+    g_signal_connect(followCheckButton, "toggled", G_CALLBACK(VcOnFollowToggled), NULL);
     g_signal_connect_swapped(copyLogButton, "clicked", G_CALLBACK(VcLogViewCopy), logView);
 
     gtk_window_set_icon_name(GTK_WINDOW(window), "applications-multimedia");
     
+    g_timeout_add(500, VcOnTelemetryTick, NULL);
+
     gtk_window_present(GTK_WINDOW(window));
 }
 
@@ -5,6 +5,13 @@
 
 gchar charBuffer[VC_LINE_SIZE];
 
+typedef struct
+{
+    GtkTextView *pLogView;
+    gchar       *pLine;
+
+} VcLogViewLine;
+
 void VcLogViewClear(GtkTextView *_logView)
 {
     GtkTextIter iterStart, iterEnd;
@@ -18,12 +25,45 @@ void VcLogViewWriteLine(GtkTextView *_logView, const char *format, ...)
 {
     va_list args;
     va_start(args, format);
+
+    // Without a view, as in the headless watch mode, lines go to the GLib log which is safe from any thread
+    if (_logView == NULL)
+    {
+        gchar *line = g_strdup_vprintf(format, args);
+        va_end(args);
+        g_message("%s", line);
+        g_free(line);
+        return;
+    }
+
     GtkTextBuffer *_textBuffer = gtk_text_view_get_buffer(_logView);
     int len = vsnprintf(charBuffer, VC_LINE_SIZE - 1, format, args);
     va_end(args);
     gtk_text_buffer_insert_at_cursor(_textBuffer, g_strconcat(charBuffer, "\n"), len + 1);
 }
 
+static gboolean VcLogViewWritePosted(gpointer data)
+{
+    VcLogViewLine *line = (VcLogViewLine *)data;
+    VcLogViewWriteLine(line->pLogView, "%s", line->pLine);
+    g_free(line->pLine);
+    g_free(line);
+    return G_SOURCE_REMOVE;
+}
+
+// The view belongs to the main thread, worker threads format their line here and it is written there
+void VcLogViewPostLine(GtkTextView *_logView, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    VcLogViewLine *line = g_new(VcLogViewLine, 1);
+    line->pLogView = _logView;
+    line->pLine = g_strdup_vprintf(format, args);
+    va_end(args);
+
+    g_main_context_invoke(NULL, VcLogViewWritePosted, line);
+}
+
 void VcLogViewCopy(GtkTextView *_logView)
 {
     GtkTextBuffer *_textBuffer = gtk_text_view_get_buffer(_logView);
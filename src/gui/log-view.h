@@ -6,6 +6,7 @@
 
 void VcLogViewClear(GtkTextView *_logView);
 void VcLogViewWriteLine(GtkTextView *_logView, const char *format, ...);
+void VcLogViewPostLine(GtkTextView *_logView, const char *format, ...);
 void VcLogViewCopy(GtkTextView *_logView);
 
 #endif // VC_LOG_VIEW_H
\ No newline at end of file
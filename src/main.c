@@ -1,6 +1,18 @@
 #include "gui/gui.h"
+#include "watch/watch.h"
+#include <signal.h>
 
 int main(int argc, char const *argv[])
 {
+    // A live output pipe losing its reader would otherwise kill the process, the write fails with EPIPE instead
+#ifdef SIGPIPE
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    if (VcWatchRequested(argc, (char **)argv))
+    {
+        return VcRunWatch(argc, (char **)argv);
+    }
+
     return VcRunApp(argc, argv);
 }
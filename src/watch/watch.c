@@ -0,0 +1,449 @@
+#include "watch.h"
+#include "../encoding/options.h"
+#include "../encoding/encoding.h"
+#include "../encoding/atomic-output.h"
+#include <glib-unix.h>
+#include <string.h>
+#include <signal.h>
+
+#define VC_WATCH_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_TIME_MODIFIED
+
+static GPtrArray        *watchDirs          = NULL;     // VcWatchDir *
+static GHashTable       *pending            = NULL;     // input path -> VcWatchPending *
+static GHashTable       *inFlight           = NULL;     // input path -> changed again while encoding
+static GThreadPool      *encodePool         = NULL;
+static gint64           settleTime          = 0;
+static gint             stopping            = 0;        // set on SIGINT/SIGTERM, running encodes give up
+
+static bool VcWatchIsWave(const char *path)
+{
+    gchar *name = g_path_get_basename(path);
+    size_t length = strlen(name);
+    bool wave = name[0] != '.' && length > 4 && g_ascii_strcasecmp(name + length - 4, ".wav") == 0;
+    g_free(name);
+
+    return wave;
+}
+
+static gchar *VcWatchOutputPath(const char *inPath)
+{
+    gchar *stem = g_strndup(inPath, strlen(inPath) - 4);
+    gchar *outPath = g_strconcat(stem, ".ogg", NULL);
+    g_free(stem);
+
+    return outPath;
+}
+
+// Starts or restarts the settle time of a file, changes while it is encoding queue it again afterwards
+static void VcWatchTouch(VcWatchDir *dir, const char *path)
+{
+    if (!VcWatchIsWave(path))
+    {
+        return;
+    }
+
+    if (g_hash_table_contains(inFlight, path))
+    {
+        g_hash_table_insert(inFlight, g_strdup(path), GINT_TO_POINTER(true));
+        return;
+    }
+
+    VcWatchPending *entry = g_hash_table_lookup(pending, path);
+    if (entry == NULL)
+    {
+        entry = g_malloc0(sizeof(VcWatchPending));
+        entry->nSize = -1;
+        g_hash_table_insert(pending, g_strdup(path), entry);
+    }
+
+    entry->dir = dir;
+    entry->nStableSince = g_get_monotonic_time();
+}
+
+static void VcOnWatchChanged(GFileMonitor *monitor, GFile *file, GFile *other, GFileMonitorEvent event, gpointer data)
+{
+    VcWatchDir *dir = (VcWatchDir *)data;
+    GFile *target = NULL;
+
+    switch (event)
+    {
+        case G_FILE_MONITOR_EVENT_CREATED:
+        case G_FILE_MONITOR_EVENT_CHANGED:
+        case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+        case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
+        case G_FILE_MONITOR_EVENT_MOVED_IN:
+            target = file;
+            break;
+
+        case G_FILE_MONITOR_EVENT_RENAMED:
+            target = other;
+            break;
+
+        default:
+            return;
+    }
+
+    if (target != NULL)
+    {
+        gchar *path = g_file_get_path(target);
+        VcWatchTouch(dir, path);
+        g_free(path);
+    }
+}
+
+// Files already in the directory are picked up when their .ogg is missing or older than they are,
+// only called at startup so the temporary files it finds can't belong to an encode still running
+static void VcWatchScan(VcWatchDir *dir)
+{
+    GError *error = NULL;
+    GFileEnumerator *children = g_file_enumerate_children(dir->dir, VC_WATCH_ATTRIBUTES, G_FILE_QUERY_INFO_NONE, NULL, &error);
+    if (children == NULL)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+        return;
+    }
+
+    GFileInfo *info;
+    while ((info = g_file_enumerator_next_file(children, NULL, NULL)) != NULL)
+    {
+        GFile *child = g_file_get_child(dir->dir, g_file_info_get_name(info));
+        gchar *path = g_file_get_path(child);
+
+        // Left behind by encodes an earlier run was killed in the middle of
+        if (g_file_info_get_file_type(info) == G_FILE_TYPE_REGULAR && VcAtomicOutputIsTemp(g_file_info_get_name(info)))
+        {
+            g_message("Removing stale %s", path);
+            g_file_delete(child, NULL, NULL);
+        }
+
+        else if (g_file_info_get_file_type(info) == G_FILE_TYPE_REGULAR && VcWatchIsWave(path))
+        {
+            gchar *outPath = VcWatchOutputPath(path);
+            GFile *outFile = g_file_new_for_path(outPath);
+            GFileInfo *outInfo = g_file_query_info(outFile, G_FILE_ATTRIBUTE_TIME_MODIFIED, G_FILE_QUERY_INFO_NONE, NULL, NULL);
+            if (outInfo == NULL
+                || g_file_info_get_attribute_uint64(outInfo, G_FILE_ATTRIBUTE_TIME_MODIFIED) < g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED))
+            {
+                VcWatchTouch(dir, path);
+            }
+
+            g_clear_object(&outInfo);
+            g_object_unref(outFile);
+            g_free(outPath);
+        }
+
+        g_free(path);
+        g_object_unref(child);
+        g_object_unref(info);
+    }
+
+    g_object_unref(children);
+}
+
+static gboolean VcOnWatchJobDone(gpointer data)
+{
+    VcWatchJob *job = (VcWatchJob *)data;
+    if (job->status == 0)
+    {
+        g_message("Encoded %s in %.1fs", job->pOutPath, job->dSeconds);
+    }
+    else if (!g_atomic_int_get(&stopping))
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Encoding %s failed", job->pInPath);
+    }
+
+    // Written to while it was encoding, the output already on disk is stale
+    bool changed = GPOINTER_TO_INT(g_hash_table_lookup(inFlight, job->pInPath));
+    g_hash_table_remove(inFlight, job->pInPath);
+    if (changed)
+    {
+        VcWatchTouch(job->dir, job->pInPath);
+    }
+
+    g_free(job->pInPath);
+    g_free(job->pOutPath);
+    g_free(job);
+
+    return G_SOURCE_REMOVE;
+}
+
+// Runs on a pool thread, the encode writes to a temporary file that only takes the .ogg name once it succeeded
+static void VcWatchEncodeJob(gpointer data, gpointer userData)
+{
+    VcWatchJob *job = (VcWatchJob *)data;
+    VcEncodeOptions options = { 0 };
+    VcAtomicOutput output;
+    GError *error = NULL;
+    gint64 start = g_get_monotonic_time();
+
+    GFile *inFile = g_file_new_for_path(job->pInPath);
+    GFile *outFile = g_file_new_for_path(job->pOutPath);
+    options.pInFileStream = g_file_read(inFile, NULL, &error);
+    if (options.pInFileStream != NULL)
+    {
+        options.pOutFileStream = VcAtomicOutputOpen(&output, outFile, &error);
+    }
+
+    job->status = -1;
+    if (options.pOutFileStream != NULL && g_atomic_int_get(&stopping))
+    {
+        VcAtomicOutputAbort(&output);
+    }
+
+    else if (options.pOutFileStream != NULL)
+    {
+        options.tuning.mode         = VC_RATE_VBR;
+        options.tuning.fQuality     = job->dQuality / 10.0f;
+        options.bLoudnessTags       = true;
+        options.bCheckIntegrity     = true;
+        options.pOutPath            = job->pOutPath;
+        options.pOutFile            = output.temp;
+        options.pAbort              = &stopping;
+
+        // Lines the encoder logs without a view go to g_message
+        job->status = VcEncodeCallback(&options);
+        if (job->status < 0)
+        {
+            VcAtomicOutputAbort(&output);
+        }
+        else if (VcAtomicOutputCommit(&output, &error) < 0)
+        {
+            job->status = -1;
+        }
+    }
+
+    if (error != NULL)
+    {
+        g_log(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, error->message);
+        g_error_free(error);
+    }
+
+    g_clear_object(&options.pInFileStream);
+    g_object_unref(outFile);
+    g_object_unref(inFile);
+
+    job->dSeconds = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+    g_main_context_invoke(NULL, VcOnWatchJobDone, job);
+}
+
+static void VcWatchQueue(const char *path, VcWatchDir *dir)
+{
+    VcWatchJob *job = g_malloc0(sizeof(VcWatchJob));
+    job->pInPath = g_strdup(path);
+    job->pOutPath = VcWatchOutputPath(path);
+    job->dir = dir;
+    job->dQuality = dir->dQuality;
+
+    g_hash_table_insert(inFlight, g_strdup(path), GINT_TO_POINTER(false));
+    g_message("Queued %s at quality %.1f", path, dir->dQuality);
+    g_thread_pool_push(encodePool, job, NULL);
+}
+
+// Inotify only says a file changed, a recorder or a copy can keep writing for a while. Sizes and
+// mtimes are polled until they hold still for the settle time, then the file goes to the pool.
+static gboolean VcOnWatchPoll(gpointer data)
+{
+    // The pool is gone once a signal stopped the loop, only the completions still run
+    if (g_atomic_int_get(&stopping))
+    {
+        return G_SOURCE_REMOVE;
+    }
+
+    gint64 now = g_get_monotonic_time();
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_hash_table_iter_init(&iter, pending);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        const char *path = (const char *)key;
+        VcWatchPending *entry = (VcWatchPending *)value;
+
+        GFile *file = g_file_new_for_path(path);
+        GFileInfo *info = g_file_query_info(file, G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_TIME_MODIFIED, G_FILE_QUERY_INFO_NONE, NULL, NULL);
+        g_object_unref(file);
+        if (info == NULL)
+        {
+            // Deleted or moved away before it settled
+            g_hash_table_iter_remove(&iter);
+            continue;
+        }
+
+        goffset size = g_file_info_get_size(info);
+        uint64_t modified = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+        g_object_unref(info);
+
+        if (size != entry->nSize || modified != entry->nModified)
+        {
+            entry->nSize = size;
+            entry->nModified = modified;
+            entry->nStableSince = now;
+        }
+        else if (now - entry->nStableSince >= settleTime)
+        {
+            VcWatchQueue(path, entry->dir);
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+// DIR or DIR:QUALITY, only a full number after the last ':' counts so "C:\in" stays a path
+static VcWatchDir *VcWatchDirNew(const char *spec, double quality, GError **error)
+{
+    gchar *path = g_strdup(spec);
+    gchar *colon = strrchr(path, ':');
+    if (colon != NULL && colon[1] != '\0')
+    {
+        gchar *end = NULL;
+        double value = g_ascii_strtod(colon + 1, &end);
+        if (*end == '\0')
+        {
+            quality = CLAMP(value, -1.0, 10.0);
+            *colon = '\0';
+        }
+    }
+
+    VcWatchDir *dir = g_malloc0(sizeof(VcWatchDir));
+    dir->dir = g_file_new_for_path(path);
+    dir->dQuality = quality;
+    g_free(path);
+
+    dir->monitor = g_file_monitor_directory(dir->dir, G_FILE_MONITOR_WATCH_MOVES, NULL, error);
+    if (dir->monitor == NULL)
+    {
+        g_object_unref(dir->dir);
+        g_free(dir);
+        return NULL;
+    }
+
+    g_signal_connect(dir->monitor, "changed", G_CALLBACK(VcOnWatchChanged), dir);
+    return dir;
+}
+
+static void VcWatchDirFree(gpointer data)
+{
+    VcWatchDir *dir = (VcWatchDir *)data;
+    g_file_monitor_cancel(dir->monitor);
+    g_object_unref(dir->monitor);
+    g_object_unref(dir->dir);
+    g_free(dir);
+}
+
+static gboolean VcOnWatchSignal(gpointer data)
+{
+    g_message("Stopping, unfinished encodes are discarded");
+    g_atomic_int_set(&stopping, 1);
+    g_main_loop_quit((GMainLoop *)data);
+    return G_SOURCE_REMOVE;
+}
+
+bool VcWatchRequested(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (g_str_has_prefix(argv[i], "--watch") || strcmp(argv[i], "-w") == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int VcRunWatch(int argc, char **argv)
+{
+    gchar **specs = NULL;
+    gint jobs = (gint)g_get_num_processors();
+    gint settle = VC_WATCH_SETTLE;
+    gdouble quality = VC_WATCH_QUALITY;
+    GError *error = NULL;
+
+    GOptionEntry entries[] =
+    {
+        { "watch",   'w', 0, G_OPTION_ARG_STRING_ARRAY, &specs,   "Directory to watch, optionally with its quality", "DIR[:QUALITY]" },
+        { "jobs",    'j', 0, G_OPTION_ARG_INT,          &jobs,    "Files encoded at once", "N" },
+        { "settle",  's', 0, G_OPTION_ARG_INT,          &settle,  "Seconds a file must stop changing before it is encoded", "SECONDS" },
+        { "quality", 'q', 0, G_OPTION_ARG_DOUBLE,       &quality, "Quality for directories given without one, -1 to 10", "Q" },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- encode WAV files dropped into directories");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error))
+    {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        g_option_context_free(context);
+        return 1;
+    }
+    g_option_context_free(context);
+
+    settleTime = (gint64)MAX(settle, 0) * G_USEC_PER_SEC;
+    pending = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    inFlight = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    watchDirs = g_ptr_array_new_with_free_func(VcWatchDirFree);
+
+    for (int i = 0; specs != NULL && specs[i] != NULL; i++)
+    {
+        VcWatchDir *dir = VcWatchDirNew(specs[i], CLAMP(quality, -1.0, 10.0), &error);
+        if (dir == NULL)
+        {
+            g_printerr("Can't watch %s: %s\n", specs[i], error->message);
+            g_clear_error(&error);
+            continue;
+        }
+
+        g_ptr_array_add(watchDirs, dir);
+        gchar *path = g_file_get_path(dir->dir);
+        g_message("Watching %s at quality %.1f", path, dir->dQuality);
+        g_free(path);
+    }
+    g_strfreev(specs);
+
+    int status = 1;
+    if (watchDirs->len > 0)
+    {
+        encodePool = g_thread_pool_new(VcWatchEncodeJob, NULL, MAX(jobs, 1), false, &error);
+        if (encodePool == NULL)
+        {
+            g_printerr("%s\n", error->message);
+            g_error_free(error);
+        }
+    }
+
+    if (encodePool != NULL)
+    {
+        for (guint i = 0; i < watchDirs->len; i++)
+        {
+            VcWatchScan(g_ptr_array_index(watchDirs, i));
+        }
+
+        g_message("Encoding up to %d files at once, files settle for %ds", MAX(jobs, 1), settle);
+        g_timeout_add_seconds(VC_WATCH_POLL_SECONDS, VcOnWatchPoll, NULL);
+
+        GMainLoop *loop = g_main_loop_new(NULL, false);
+        g_unix_signal_add(SIGINT, VcOnWatchSignal, loop);
+        g_unix_signal_add(SIGTERM, VcOnWatchSignal, loop);
+        g_main_loop_run(loop);
+        g_main_loop_unref(loop);
+
+        // Running encodes stop at their next block and queued ones skip straight to done, both
+        // remove their temporary files. Their completions are then run to free the jobs.
+        g_thread_pool_free(encodePool, false, true);
+        encodePool = NULL;
+        while (g_main_context_iteration(NULL, false))
+        {
+        }
+        status = 0;
+    }
+
+    g_ptr_array_unref(watchDirs);
+    g_hash_table_destroy(inFlight);
+    g_hash_table_destroy(pending);
+
+    return status;
+}
@@ -0,0 +1,47 @@
+#ifndef VC_WATCH_H
+#define VC_WATCH_H
+
+#include <gtk-4.0/gtk/gtk.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define VC_WATCH_POLL_SECONDS   1
+#define VC_WATCH_SETTLE         5       // seconds a file must keep its size and mtime before it is encoded
+#define VC_WATCH_QUALITY        4.0     // -1 to 10, for directories given without one
+
+// A watched directory and the quality its files are encoded at
+typedef struct
+{
+    GFile               *dir;
+    GFileMonitor        *monitor;
+    double              dQuality;
+
+} VcWatchDir;
+
+// A WAV seen changing, encoded once it has stopped for the settle time
+typedef struct
+{
+    VcWatchDir          *dir;
+    goffset             nSize;
+    uint64_t            nModified;
+    gint64              nStableSince;       // monotonic, microseconds
+
+} VcWatchPending;
+
+typedef struct
+{
+    VcWatchDir          *dir;
+    gchar               *pInPath;
+    gchar               *pOutPath;          // <name>.ogg next to the input
+    double              dQuality;
+    int                 status;
+    double              dSeconds;
+
+} VcWatchJob;
+
+// Headless mode, runs instead of the window when the command line asks for it:
+//   vorbis-compression --watch DIR[:QUALITY] [--watch DIR[:QUALITY] ...] [--jobs N] [--settle SECONDS] [--quality Q]
+bool    VcWatchRequested(int argc, char **argv);
+int     VcRunWatch(int argc, char **argv);
+
+#endif // VC_WATCH_H